@@ -27,17 +27,17 @@ std::string CodeGen::get_c_type(const std::string &pgt_type) {
   return "void*";
 }
 
-std::string CodeGen::generate_expr(const std::shared_ptr<AstNode> &expr) {
-  if (auto lit = std::dynamic_pointer_cast<Literal>(expr)) {
-    if (lit->value.type == ValueType::INT) {
-      return std::to_string(lit->value.int_val) + "LL";
-    } else if (lit->value.type == ValueType::FLOAT) {
-      return std::to_string(lit->value.float_val);
-    } else if (lit->value.type == ValueType::BOOL) {
-      return lit->value.bool_val ? "1" : "0";
-    } else if (lit->value.type == ValueType::STRING) {
+std::string CodeGen::generate_expr(AstNode *expr) {
+  if (auto lit = node_cast<Literal>(expr)) {
+    if (lit->value.type() == ValueType::INT) {
+      return std::to_string(lit->value.int_val()) + "LL";
+    } else if (lit->value.type() == ValueType::FLOAT) {
+      return std::to_string(lit->value.float_val());
+    } else if (lit->value.type() == ValueType::BOOL) {
+      return lit->value.bool_val() ? "1" : "0";
+    } else if (lit->value.type() == ValueType::STRING) {
       std::string escaped = "\"";
-      for (char c : lit->value.str_val) {
+      for (char c : lit->value.str_val()) {
         if (c == '"')
           escaped += "\\\"";
         else if (c == '\n')
@@ -51,9 +51,9 @@ std::string CodeGen::generate_expr(const std::shared_ptr<AstNode> &expr) {
       }
       escaped += "\"";
       return escaped;
-    } else if (lit->value.type == ValueType::BYTES) {
+    } else if (lit->value.type() == ValueType::BYTES) {
       std::string escaped = "\"";
-      for (char c : lit->value.str_val) {
+      for (char c : lit->value.str_val()) {
         if (c == '"')
           escaped += "\\\"";
         else if (c == '\n')
@@ -70,11 +70,11 @@ std::string CodeGen::generate_expr(const std::shared_ptr<AstNode> &expr) {
     }
   }
 
-  if (auto id = std::dynamic_pointer_cast<Identifier>(expr)) {
+  if (auto id = node_cast<Identifier>(expr)) {
     return id->name;
   }
 
-  if (auto builtin = std::dynamic_pointer_cast<BuiltinCallExpr>(expr)) {
+  if (auto builtin = node_cast<BuiltinCallExpr>(expr)) {
     if (builtin->name == "protocol") {
       throw std::runtime_error("Builtin expression 'protocol' is not supported "
                                "by the C backend yet");
@@ -83,7 +83,7 @@ std::string CodeGen::generate_expr(const std::shared_ptr<AstNode> &expr) {
                              builtin->name);
   }
 
-  if (auto bin = std::dynamic_pointer_cast<BinaryOp>(expr)) {
+  if (auto bin = node_cast<BinaryOp>(expr)) {
     std::string left = generate_expr(bin->left);
     std::string right = generate_expr(bin->right);
     std::string op;
@@ -129,7 +129,7 @@ std::string CodeGen::generate_expr(const std::shared_ptr<AstNode> &expr) {
   return "0";
 }
 
-void CodeGen::generate_var_decl(const std::shared_ptr<VarDecl> &decl) {
+void CodeGen::generate_var_decl(VarDecl *decl) {
   write_indent();
   code << "void* " << decl->name << " = (void*)(" << generate_expr(decl->expr)
        << ");\n";
@@ -137,7 +137,7 @@ void CodeGen::generate_var_decl(const std::shared_ptr<VarDecl> &decl) {
   code << "gc_add_root(&" << decl->name << ");\n";
 }
 
-void CodeGen::generate_print(const std::shared_ptr<PrintStmt> &print) {
+void CodeGen::generate_print(PrintStmt *print) {
   write_indent();
   for (size_t i = 0; i < print->args.size(); ++i) {
     std::string expr = generate_expr(print->args[i]);
@@ -168,7 +168,7 @@ void CodeGen::generate_print(const std::shared_ptr<PrintStmt> &print) {
   }
 }
 
-void CodeGen::generate_input(const std::shared_ptr<InputStmt> &input) {
+void CodeGen::generate_input(InputStmt *input) {
   write_indent();
   std::string var_name = input->var_name.empty() ? "input" : input->var_name;
 
@@ -195,7 +195,7 @@ void CodeGen::generate_input(const std::shared_ptr<InputStmt> &input) {
   }
 }
 
-void CodeGen::generate_if(const std::shared_ptr<IfStmt> &if_stmt) {
+void CodeGen::generate_if(IfStmt *if_stmt) {
   write_indent();
   code << "if (" << generate_expr(if_stmt->condition) << ") {\n";
   indent_level++;
@@ -224,7 +224,7 @@ void CodeGen::generate_if(const std::shared_ptr<IfStmt> &if_stmt) {
   code << "\n";
 }
 
-void CodeGen::generate_while(const std::shared_ptr<WhileStmt> &while_stmt) {
+void CodeGen::generate_while(WhileStmt *while_stmt) {
   write_indent();
   code << "while (" << generate_expr(while_stmt->condition) << ") {\n";
   indent_level++;
@@ -238,7 +238,7 @@ void CodeGen::generate_while(const std::shared_ptr<WhileStmt> &while_stmt) {
   code << "}\n";
 }
 
-void CodeGen::generate_file_op(const std::shared_ptr<FileOp> &file_op) {
+void CodeGen::generate_file_op(FileOp *file_op) {
   write_indent();
   std::string file_path = generate_expr(file_op->file_path);
 
@@ -268,7 +268,7 @@ void CodeGen::generate_file_op(const std::shared_ptr<FileOp> &file_op) {
   }
 }
 
-void CodeGen::generate_net_op(const std::shared_ptr<NetOp> &net_op) {
+void CodeGen::generate_net_op(NetOp *net_op) {
   write_indent();
   std::string op_name =
       net_op->transport.empty()
@@ -280,7 +280,7 @@ void CodeGen::generate_net_op(const std::shared_ptr<NetOp> &net_op) {
   code << "exit(1);\n";
 }
 
-void CodeGen::generate_call(const std::shared_ptr<CallStmt> &call) {
+void CodeGen::generate_call(CallStmt *call) {
   write_indent();
   std::string func_name = call->func_name;
   if (func_name == "main") {
@@ -295,35 +295,47 @@ void CodeGen::generate_call(const std::shared_ptr<CallStmt> &call) {
   code << ");\n";
 }
 
-void CodeGen::generate_return(const std::shared_ptr<ReturnStmt> &ret) {
+void CodeGen::generate_return(ReturnStmt *ret) {
   (void)ret;
   write_indent();
   code << "return;\n";
 }
 
-void CodeGen::generate_statement(const std::shared_ptr<AstNode> &stmt) {
-  if (auto decl = std::dynamic_pointer_cast<VarDecl>(stmt)) {
-    generate_var_decl(decl);
-  } else if (auto print = std::dynamic_pointer_cast<PrintStmt>(stmt)) {
-    generate_print(print);
-  } else if (auto input = std::dynamic_pointer_cast<InputStmt>(stmt)) {
-    generate_input(input);
-  } else if (auto if_stmt = std::dynamic_pointer_cast<IfStmt>(stmt)) {
-    generate_if(if_stmt);
-  } else if (auto while_stmt = std::dynamic_pointer_cast<WhileStmt>(stmt)) {
-    generate_while(while_stmt);
-  } else if (auto call = std::dynamic_pointer_cast<CallStmt>(stmt)) {
-    generate_call(call);
-  } else if (auto ret = std::dynamic_pointer_cast<ReturnStmt>(stmt)) {
-    generate_return(ret);
-  } else if (auto net_op = std::dynamic_pointer_cast<NetOp>(stmt)) {
-    generate_net_op(net_op);
-  } else if (auto file_op = std::dynamic_pointer_cast<FileOp>(stmt)) {
-    generate_file_op(file_op);
+void CodeGen::generate_statement(AstNode *stmt) {
+  switch (stmt->kind) {
+  case NodeKind::VAR_DECL:
+    generate_var_decl(static_cast<VarDecl *>(stmt));
+    break;
+  case NodeKind::PRINT:
+    generate_print(static_cast<PrintStmt *>(stmt));
+    break;
+  case NodeKind::INPUT:
+    generate_input(static_cast<InputStmt *>(stmt));
+    break;
+  case NodeKind::IF:
+    generate_if(static_cast<IfStmt *>(stmt));
+    break;
+  case NodeKind::WHILE:
+    generate_while(static_cast<WhileStmt *>(stmt));
+    break;
+  case NodeKind::CALL:
+    generate_call(static_cast<CallStmt *>(stmt));
+    break;
+  case NodeKind::RETURN:
+    generate_return(static_cast<ReturnStmt *>(stmt));
+    break;
+  case NodeKind::NET_OP:
+    generate_net_op(static_cast<NetOp *>(stmt));
+    break;
+  case NodeKind::FILE_OP:
+    generate_file_op(static_cast<FileOp *>(stmt));
+    break;
+  default:
+    break;
   }
 }
 
-void CodeGen::generate_function(const std::shared_ptr<FunctionDef> &func) {
+void CodeGen::generate_function(FunctionDef *func) {
   std::string func_name = func->name;
   if (func_name == "main") {
     func_name = "pgt_main";
@@ -349,8 +361,7 @@ void CodeGen::generate_function(const std::shared_ptr<FunctionDef> &func) {
   code << "}\n\n";
 }
 
-std::string
-CodeGen::generate(const std::vector<std::shared_ptr<AstNode>> &program) {
+std::string CodeGen::generate(const std::vector<AstNode *> &program) {
   code.str("");
 
   code << "// Generated by PGT Compiler\n";
@@ -360,7 +371,7 @@ CodeGen::generate(const std::vector<std::shared_ptr<AstNode>> &program) {
   code << "#include \"runtime/gc.h\"\n\n";
 
   for (const auto &node : program) {
-    if (auto func = std::dynamic_pointer_cast<FunctionDef>(node)) {
+    if (auto func = node_cast<FunctionDef>(node)) {
       std::string func_name = func->name;
       if (func_name == "main") {
         func_name = "pgt_main";
@@ -379,9 +390,9 @@ CodeGen::generate(const std::vector<std::shared_ptr<AstNode>> &program) {
   code << "\n";
 
   for (const auto &node : program) {
-    if (auto func = std::dynamic_pointer_cast<FunctionDef>(node)) {
+    if (auto func = node_cast<FunctionDef>(node)) {
       generate_function(func);
-    } else if (auto var = std::dynamic_pointer_cast<VarDecl>(node)) {
+    } else if (auto var = node_cast<VarDecl>(node)) {
       code << "void* " << var->name << " = NULL;\n";
     }
   }
@@ -390,7 +401,7 @@ CodeGen::generate(const std::vector<std::shared_ptr<AstNode>> &program) {
   code << "    gc_init();\n";
 
   for (const auto &node : program) {
-    if (auto call = std::dynamic_pointer_cast<CallStmt>(node)) {
+    if (auto call = node_cast<CallStmt>(node)) {
       if (call->func_name == "main") {
         code << "    pgt_main();\n";
       }
@@ -0,0 +1,601 @@
+#include "../include/parser/AstCache.h"
+#include "../include/utils/Version.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <openssl/sha.h>
+#include <unistd.h>
+
+namespace {
+const char cache_magic[] = "PGTC";
+// Bump when the layout below or the fields of a node change.
+constexpr uint32_t cache_format = 2;
+constexpr uint8_t null_node = 0xff;
+
+std::string entry_path(const std::string &directory, const std::string &key) {
+  return (std::filesystem::path(directory) / (key + ".pgtc")).string();
+}
+
+// Integers are little-endian, strings and lists are prefixed with a 32-bit
+// length, and a node is its kind, its location and then its fields, with
+// null_node standing in for a missing child.
+class CacheWriter {
+  std::string out;
+
+public:
+  const std::string &data() const { return out; }
+
+  void u8(uint8_t value) { out.push_back(static_cast<char>(value)); }
+
+  void u32(uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+      u8(static_cast<uint8_t>(value >> shift));
+    }
+  }
+
+  void u64(uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) {
+      u8(static_cast<uint8_t>(value >> shift));
+    }
+  }
+
+  void i32(int value) { u32(static_cast<uint32_t>(value)); }
+
+  void str(const std::string &value) {
+    u32(static_cast<uint32_t>(value.size()));
+    out.append(value);
+  }
+
+  void strings(const std::vector<std::string> &values) {
+    u32(static_cast<uint32_t>(values.size()));
+    for (const auto &value : values) {
+      str(value);
+    }
+  }
+
+  void location(const SourceLocation &loc) {
+    i32(loc.line);
+    i32(loc.column);
+    str(loc.file_path);
+  }
+
+  void builtin(const BuiltinInfo *info) { str(info ? info->name : ""); }
+
+  // The parser only produces scalar and string literals.
+  bool value(const Value &value) {
+    u8(static_cast<uint8_t>(value.type()));
+    switch (value.type()) {
+    case ValueType::INT:
+      u64(static_cast<uint64_t>(value.int_val()));
+      return true;
+    case ValueType::FLOAT: {
+      double number = value.float_val();
+      uint64_t bits;
+      std::memcpy(&bits, &number, sizeof(bits));
+      u64(bits);
+      return true;
+    }
+    case ValueType::STRING:
+    case ValueType::BYTES:
+      str(value.str_val());
+      return true;
+    case ValueType::BOOL:
+      u8(value.bool_val() ? 1 : 0);
+      return true;
+    case ValueType::NONE:
+      return true;
+    case ValueType::OBJECT:
+    case ValueType::ARRAY:
+      return false;
+    }
+    return false;
+  }
+
+  bool nodes(const std::vector<AstNode *> &list) {
+    u32(static_cast<uint32_t>(list.size()));
+    for (const AstNode *node : list) {
+      if (!this->node(node)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool node(const AstNode *node) {
+    if (!node) {
+      u8(null_node);
+      return true;
+    }
+    u8(static_cast<uint8_t>(node->kind));
+    location(node->location);
+    switch (node->kind) {
+    case NodeKind::FUNCTION_DEF: {
+      auto func = static_cast<const FunctionDef *>(node);
+      str(func->name);
+      strings(func->param_names);
+      strings(func->param_types);
+      u32(static_cast<uint32_t>(func->routes.size()));
+      for (const auto &route : func->routes) {
+        str(route.method);
+        str(route.path);
+        location(route.location);
+      }
+      u8(func->has_return_one ? 1 : 0);
+      return nodes(func->body);
+    }
+    case NodeKind::CLASS_DEF: {
+      auto klass = static_cast<const ClassDef *>(node);
+      str(klass->name);
+      str(klass->base);
+      u32(static_cast<uint32_t>(klass->fields.size()));
+      for (const auto &field : klass->fields) {
+        str(field.name);
+        str(field.db_type);
+        i32(field.size);
+        u8(field.primary_key ? 1 : 0);
+        location(field.location);
+      }
+      return true;
+    }
+    case NodeKind::VAR_DECL: {
+      auto decl = static_cast<const VarDecl *>(node);
+      str(decl->name);
+      str(decl->type_name);
+      return this->node(decl->expr);
+    }
+    case NodeKind::BINARY_OP: {
+      auto bin = static_cast<const BinaryOp *>(node);
+      i32(bin->op);
+      return this->node(bin->left) && this->node(bin->right);
+    }
+    case NodeKind::LITERAL:
+      return value(static_cast<const Literal *>(node)->value);
+    case NodeKind::IDENTIFIER:
+      str(static_cast<const Identifier *>(node)->name);
+      return true;
+    case NodeKind::BUILTIN_CALL: {
+      auto call = static_cast<const BuiltinCallExpr *>(node);
+      str(call->name);
+      builtin(call->builtin);
+      return nodes(call->args);
+    }
+    case NodeKind::PRINT: {
+      auto print = static_cast<const PrintStmt *>(node);
+      strings(print->formats);
+      u8(print->is_printg ? 1 : 0);
+      return nodes(print->args);
+    }
+    case NodeKind::INPUT: {
+      auto input = static_cast<const InputStmt *>(node);
+      str(input->format);
+      str(input->prompt);
+      str(input->var_name);
+      return true;
+    }
+    case NodeKind::CALL: {
+      auto call = static_cast<const CallStmt *>(node);
+      str(call->func_name);
+      builtin(call->builtin);
+      return nodes(call->args);
+    }
+    case NodeKind::RETURN:
+      return this->node(static_cast<const ReturnStmt *>(node)->expr);
+    case NodeKind::IMPORT: {
+      auto import = static_cast<const ImportStmt *>(node);
+      str(import->file_path);
+      strings(import->import_names);
+      return true;
+    }
+    case NodeKind::IF: {
+      auto if_stmt = static_cast<const IfStmt *>(node);
+      return this->node(if_stmt->condition) && nodes(if_stmt->then_body) &&
+             nodes(if_stmt->else_body);
+    }
+    case NodeKind::WHILE: {
+      auto while_stmt = static_cast<const WhileStmt *>(node);
+      return this->node(while_stmt->condition) && nodes(while_stmt->body);
+    }
+    case NodeKind::NET_OP: {
+      auto net_op = static_cast<const NetOp *>(node);
+      str(net_op->transport);
+      str(net_op->method);
+      return this->node(net_op->url) && this->node(net_op->path) &&
+             this->node(net_op->port) && this->node(net_op->data) &&
+             this->node(net_op->workers);
+    }
+    case NodeKind::FILE_OP: {
+      auto file_op = static_cast<const FileOp *>(node);
+      i32(file_op->operation);
+      str(file_op->mode);
+      return this->node(file_op->file_path) && this->node(file_op->data);
+    }
+    }
+    return false;
+  }
+};
+
+// Reads what CacheWriter wrote. Any short read or out-of-range tag clears ok
+// and makes every later read return an empty value, so callers check ok once
+// at the end.
+class CacheReader {
+  AstArena &arena;
+  std::string_view in;
+  size_t pos = 0;
+
+  bool take(size_t count) {
+    if (!ok || in.size() - pos < count) {
+      ok = false;
+      return false;
+    }
+    return true;
+  }
+
+  // Every list element takes at least one byte, so a count larger than what
+  // is left is corrupt; checking it keeps a bad entry from reserving memory.
+  uint32_t count() {
+    uint32_t n = u32();
+    if (n > in.size() - pos) {
+      ok = false;
+      return 0;
+    }
+    return n;
+  }
+
+public:
+  bool ok = true;
+
+  CacheReader(AstArena &arena, std::string_view in) : arena(arena), in(in) {}
+
+  bool at_end() const { return pos == in.size(); }
+
+  uint8_t u8() {
+    if (!take(1)) {
+      return 0;
+    }
+    return static_cast<uint8_t>(in[pos++]);
+  }
+
+  uint32_t u32() {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+      value |= static_cast<uint32_t>(u8()) << shift;
+    }
+    return value;
+  }
+
+  uint64_t u64() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 8) {
+      value |= static_cast<uint64_t>(u8()) << shift;
+    }
+    return value;
+  }
+
+  int i32() { return static_cast<int>(u32()); }
+
+  bool flag() { return u8() != 0; }
+
+  std::string str() {
+    uint32_t size = u32();
+    if (!take(size)) {
+      return "";
+    }
+    std::string value(in.substr(pos, size));
+    pos += size;
+    return value;
+  }
+
+  std::vector<std::string> strings() {
+    std::vector<std::string> values(count());
+    for (auto &value : values) {
+      value = str();
+    }
+    return values;
+  }
+
+  SourceLocation location() {
+    SourceLocation loc;
+    loc.line = i32();
+    loc.column = i32();
+    loc.file_path = str();
+    return loc;
+  }
+
+  const BuiltinInfo *builtin() {
+    std::string name = str();
+    if (name.empty()) {
+      return nullptr;
+    }
+    const BuiltinInfo *info = find_builtin(name);
+    if (!info) {
+      ok = false;
+    }
+    return info;
+  }
+
+  Value value() {
+    switch (static_cast<ValueType>(u8())) {
+    case ValueType::INT:
+      return Value(static_cast<long long>(u64()));
+    case ValueType::FLOAT: {
+      uint64_t bits = u64();
+      double number;
+      std::memcpy(&number, &bits, sizeof(number));
+      return Value(number);
+    }
+    case ValueType::STRING:
+      return Value(str());
+    case ValueType::BYTES:
+      return Value::Bytes(str());
+    case ValueType::BOOL:
+      return Value::Bool(flag());
+    case ValueType::NONE:
+      return Value();
+    case ValueType::OBJECT:
+    case ValueType::ARRAY:
+      break;
+    }
+    ok = false;
+    return Value();
+  }
+
+  std::vector<AstNode *> nodes() {
+    std::vector<AstNode *> list(count());
+    for (auto &node : list) {
+      node = this->node();
+    }
+    return list;
+  }
+
+  AstNode *node() {
+    uint8_t tag = u8();
+    if (!ok || tag == null_node) {
+      return nullptr;
+    }
+    SourceLocation loc = location();
+    AstNode *result = nullptr;
+    switch (static_cast<NodeKind>(tag)) {
+    case NodeKind::FUNCTION_DEF: {
+      auto func = arena.make<FunctionDef>();
+      func->name = str();
+      func->param_names = strings();
+      func->param_types = strings();
+      func->routes.resize(count());
+      for (auto &route : func->routes) {
+        route.method = str();
+        route.path = str();
+        route.location = location();
+      }
+      func->has_return_one = flag();
+      func->body = nodes();
+      result = func;
+      break;
+    }
+    case NodeKind::CLASS_DEF: {
+      auto klass = arena.make<ClassDef>();
+      klass->name = str();
+      klass->base = str();
+      klass->fields.resize(count());
+      for (auto &field : klass->fields) {
+        field.name = str();
+        field.db_type = str();
+        field.size = i32();
+        field.primary_key = flag();
+        field.location = location();
+      }
+      result = klass;
+      break;
+    }
+    case NodeKind::VAR_DECL: {
+      auto decl = arena.make<VarDecl>();
+      decl->name = str();
+      decl->type_name = str();
+      decl->expr = node();
+      result = decl;
+      break;
+    }
+    case NodeKind::BINARY_OP: {
+      auto bin = arena.make<BinaryOp>();
+      bin->op = static_cast<TokenType>(i32());
+      bin->left = node();
+      bin->right = node();
+      result = bin;
+      break;
+    }
+    case NodeKind::LITERAL: {
+      auto lit = arena.make<Literal>();
+      lit->value = value();
+      result = lit;
+      break;
+    }
+    case NodeKind::IDENTIFIER: {
+      auto id = arena.make<Identifier>();
+      id->name = str();
+      result = id;
+      break;
+    }
+    case NodeKind::BUILTIN_CALL: {
+      auto call = arena.make<BuiltinCallExpr>();
+      call->name = str();
+      call->builtin = builtin();
+      call->args = nodes();
+      result = call;
+      break;
+    }
+    case NodeKind::PRINT: {
+      auto print = arena.make<PrintStmt>();
+      print->formats = strings();
+      print->is_printg = flag();
+      print->args = nodes();
+      result = print;
+      break;
+    }
+    case NodeKind::INPUT: {
+      auto input = arena.make<InputStmt>();
+      input->format = str();
+      input->prompt = str();
+      input->var_name = str();
+      result = input;
+      break;
+    }
+    case NodeKind::CALL: {
+      auto call = arena.make<CallStmt>();
+      call->func_name = str();
+      call->builtin = builtin();
+      call->args = nodes();
+      result = call;
+      break;
+    }
+    case NodeKind::RETURN: {
+      auto ret = arena.make<ReturnStmt>();
+      ret->expr = node();
+      result = ret;
+      break;
+    }
+    case NodeKind::IMPORT: {
+      auto import = arena.make<ImportStmt>();
+      import->file_path = str();
+      import->import_names = strings();
+      result = import;
+      break;
+    }
+    case NodeKind::IF: {
+      auto if_stmt = arena.make<IfStmt>();
+      if_stmt->condition = node();
+      if_stmt->then_body = nodes();
+      if_stmt->else_body = nodes();
+      result = if_stmt;
+      break;
+    }
+    case NodeKind::WHILE: {
+      auto while_stmt = arena.make<WhileStmt>();
+      while_stmt->condition = node();
+      while_stmt->body = nodes();
+      result = while_stmt;
+      break;
+    }
+    case NodeKind::NET_OP: {
+      auto net_op = arena.make<NetOp>();
+      net_op->transport = str();
+      net_op->method = str();
+      net_op->url = node();
+      net_op->path = node();
+      net_op->port = node();
+      net_op->data = node();
+      net_op->workers = node();
+      result = net_op;
+      break;
+    }
+    case NodeKind::FILE_OP: {
+      auto file_op = arena.make<FileOp>();
+      file_op->operation = static_cast<TokenType>(i32());
+      file_op->mode = str();
+      file_op->file_path = node();
+      file_op->data = node();
+      result = file_op;
+      break;
+    }
+    default:
+      ok = false;
+      return nullptr;
+    }
+    result->location = std::move(loc);
+    return result;
+  }
+};
+} // namespace
+
+std::string AstCache::key(std::string_view source) {
+  static const char *hex = "0123456789abcdef";
+  SHA256_CTX ctx;
+  SHA256_Init(&ctx);
+  std::string prefix = std::string(cache_magic) +
+                       std::to_string(cache_format) + ":" + pgt_version;
+  SHA256_Update(&ctx, prefix.c_str(), prefix.size() + 1);
+  SHA256_Update(&ctx, source.data(), source.size());
+  unsigned char digest[SHA256_DIGEST_LENGTH];
+  SHA256_Final(digest, &ctx);
+
+  std::string out;
+  out.reserve(SHA256_DIGEST_LENGTH * 2);
+  for (unsigned char byte : digest) {
+    out += hex[byte >> 4];
+    out += hex[byte & 0x0f];
+  }
+  return out;
+}
+
+bool AstCache::load(const std::string &key, AstArena &arena,
+                    ParsedFile &file) const {
+  if (directory.empty()) {
+    return false;
+  }
+  std::ifstream in(entry_path(directory, key), std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::string data(std::istreambuf_iterator<char>(in), {});
+
+  CacheReader reader(arena, data);
+  bool header_ok = reader.str() == cache_magic &&
+                   reader.u32() == cache_format && reader.str() == pgt_version;
+  if (!header_ok) {
+    return false;
+  }
+  ParsedFile parsed;
+  parsed.has_package_decl = reader.flag();
+  parsed.package_name = reader.str();
+  parsed.has_return_zero = reader.flag();
+  parsed.program = reader.nodes();
+  if (!reader.ok || !reader.at_end()) {
+    return false;
+  }
+  file = std::move(parsed);
+  return true;
+}
+
+void AstCache::store(const std::string &key, const ParsedFile &file) const {
+  if (directory.empty()) {
+    return;
+  }
+  CacheWriter writer;
+  writer.str(cache_magic);
+  writer.u32(cache_format);
+  writer.str(pgt_version);
+  writer.u8(file.has_package_decl ? 1 : 0);
+  writer.str(file.package_name);
+  writer.u8(file.has_return_zero ? 1 : 0);
+  if (!writer.nodes(file.program)) {
+    return;
+  }
+
+  std::error_code ec;
+  std::filesystem::create_directories(directory, ec);
+  if (ec) {
+    return;
+  }
+
+  // Write aside and rename, so a concurrent `pgt run` never sees half an
+  // entry.
+  static std::atomic<unsigned> sequence{0};
+  std::string path = entry_path(directory, key);
+  std::string temp = path + "." + std::to_string(getpid()) + "." +
+                     std::to_string(sequence++) + ".tmp";
+  {
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    out.write(writer.data().data(),
+              static_cast<std::streamsize>(writer.data().size()));
+    if (!out) {
+      out.close();
+      std::filesystem::remove(temp, ec);
+      return;
+    }
+  }
+  std::filesystem::rename(temp, path, ec);
+  if (ec) {
+    std::filesystem::remove(temp, ec);
+  }
+}
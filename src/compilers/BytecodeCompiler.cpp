@@ -0,0 +1,292 @@
+#include "../include/vm/Bytecode.h"
+#include <limits>
+
+size_t BytecodeCompiler::emit(OpCode op, int a, int b, const AstNode *node) {
+  chunk->code.push_back({op, a, b, 0, node});
+  return chunk->code.size() - 1;
+}
+
+int BytecodeCompiler::add_constant(const Value &value) {
+  chunk->constants.push_back(value);
+  return static_cast<int>(chunk->constants.size() - 1);
+}
+
+int BytecodeCompiler::add_name(const std::string &name) {
+  for (size_t i = 0; i < chunk->names.size(); ++i) {
+    if (chunk->names[i] == name) {
+      return static_cast<int>(i);
+    }
+  }
+  chunk->names.push_back(name);
+  return static_cast<int>(chunk->names.size() - 1);
+}
+
+int BytecodeCompiler::add_builtin(const BuiltinInfo *builtin) {
+  for (size_t i = 0; i < chunk->builtins.size(); ++i) {
+    if (chunk->builtins[i] == builtin) {
+      return static_cast<int>(i);
+    }
+  }
+  chunk->builtins.push_back(builtin);
+  return static_cast<int>(chunk->builtins.size() - 1);
+}
+
+void BytecodeCompiler::patch_jump(size_t at) {
+  chunk->code[at].a = static_cast<int>(chunk->code.size());
+}
+
+void BytecodeCompiler::adjust_stack(int delta) {
+  stack_depth = static_cast<size_t>(static_cast<long>(stack_depth) + delta);
+  if (stack_depth > chunk->max_stack) {
+    chunk->max_stack = stack_depth;
+  }
+}
+
+// Matches `name + int = name + K` / `name + int = name - K` on a local, the
+// shape of a loop counter update.
+bool BytecodeCompiler::emit_increment(const VarDecl &decl, size_t &at) {
+  if (DEBUG || decl.is_global || decl.slot < 0 || decl.type_name != "int") {
+    return false;
+  }
+  auto *bin = node_cast<BinaryOp>(decl.expr);
+  if (!bin || (bin->op != T_PLUS && bin->op != T_MINUS)) {
+    return false;
+  }
+  auto *id = node_cast<Identifier>(bin->left);
+  auto *step = node_cast<Literal>(bin->right);
+  if (!id || id->slot != decl.slot || !step ||
+      step->value.type() != ValueType::INT) {
+    return false;
+  }
+  long long delta = step->value.int_val();
+  if (bin->op == T_MINUS) {
+    delta = -delta;
+  }
+  if (delta < std::numeric_limits<int>::min() + 1 ||
+      delta > std::numeric_limits<int>::max()) {
+    return false;
+  }
+  at = emit(OpCode::INC_LOCAL_INT, decl.slot, static_cast<int>(delta), &decl);
+  return true;
+}
+
+std::shared_ptr<Chunk>
+BytecodeCompiler::compile_function(const FunctionDef &func) {
+  chunk = std::make_shared<Chunk>();
+  chunk->name = func.name;
+  chunk->frame_size = static_cast<size_t>(func.frame_size);
+  stack_depth = 0;
+  compile_block(func.body);
+  emit(OpCode::END, 0, 0, &func);
+  return chunk;
+}
+
+std::shared_ptr<Chunk>
+BytecodeCompiler::compile_expression(AstNode *expr, const std::string &name) {
+  chunk = std::make_shared<Chunk>();
+  chunk->name = name;
+  stack_depth = 0;
+  compile_expr(expr);
+  emit(OpCode::RETURN, 0, 0, expr);
+  adjust_stack(-1);
+  return chunk;
+}
+
+void BytecodeCompiler::compile_block(const std::vector<AstNode *> &body) {
+  for (const auto &stmt : body) {
+    compile_statement(stmt);
+  }
+}
+
+void BytecodeCompiler::compile_statement(AstNode *stmt) {
+  switch (stmt->kind) {
+  case NodeKind::VAR_DECL: {
+    auto decl = static_cast<VarDecl *>(stmt);
+    size_t increment = 0;
+    bool fused = emit_increment(*decl, increment);
+    compile_expr(decl->expr);
+    emit(decl->is_global ? OpCode::STORE_GLOBAL : OpCode::STORE_LOCAL,
+         decl->slot, decl->type_name.empty() ? -1 : add_name(decl->type_name),
+         decl);
+    adjust_stack(-1);
+    if (fused) {
+      chunk->code[increment].c = static_cast<int>(chunk->code.size());
+    }
+    break;
+  }
+  case NodeKind::PRINT:
+    compile_print(*static_cast<PrintStmt *>(stmt));
+    break;
+  case NodeKind::CALL:
+    compile_call(*static_cast<CallStmt *>(stmt));
+    break;
+  case NodeKind::BUILTIN_CALL:
+    compile_expr(stmt);
+    emit(OpCode::POP);
+    adjust_stack(-1);
+    break;
+  case NodeKind::RETURN: {
+    auto ret = static_cast<ReturnStmt *>(stmt);
+    if (ret->expr) {
+      compile_expr(ret->expr);
+    } else {
+      emit(OpCode::CONST, add_constant(Value(1LL)), 0, ret);
+      adjust_stack(1);
+    }
+    emit(OpCode::RETURN, 0, 0, ret);
+    adjust_stack(-1);
+    break;
+  }
+  case NodeKind::IF:
+    compile_if(*static_cast<IfStmt *>(stmt));
+    break;
+  case NodeKind::WHILE:
+    compile_while(*static_cast<WhileStmt *>(stmt));
+    break;
+  case NodeKind::INPUT: {
+    auto input = static_cast<InputStmt *>(stmt);
+    emit(OpCode::INPUT, input->slot, input->is_global ? 1 : 0, input);
+    break;
+  }
+  case NodeKind::FILE_OP:
+    compile_file_op(*static_cast<FileOp *>(stmt));
+    break;
+  case NodeKind::NET_OP:
+    compile_net_op(*static_cast<NetOp *>(stmt));
+    break;
+  default:
+    break;
+  }
+}
+
+void BytecodeCompiler::compile_expr(AstNode *expr) {
+  if (!expr) {
+    emit(OpCode::CONST, add_constant(Value()));
+    adjust_stack(1);
+    return;
+  }
+  switch (expr->kind) {
+  case NodeKind::LITERAL:
+    emit(OpCode::CONST, add_constant(static_cast<Literal *>(expr)->value), 0,
+         expr);
+    adjust_stack(1);
+    break;
+  case NodeKind::BUILTIN_CALL: {
+    auto builtin = static_cast<BuiltinCallExpr *>(expr);
+    compile_builtin(builtin->builtin, builtin->args, builtin);
+    break;
+  }
+  case NodeKind::IDENTIFIER: {
+    auto id = static_cast<Identifier *>(expr);
+    if (id->slot >= 0) {
+      emit(OpCode::LOAD_LOCAL, id->slot, id->global_slot, id);
+    } else if (id->global_slot >= 0) {
+      emit(OpCode::LOAD_GLOBAL, id->global_slot, 0, id);
+    } else {
+      emit(OpCode::LOAD_NAME, add_name(id->name), 0, id);
+    }
+    adjust_stack(1);
+    break;
+  }
+  case NodeKind::BINARY_OP: {
+    auto bin = static_cast<BinaryOp *>(expr);
+    compile_expr(bin->left);
+    compile_expr(bin->right);
+    OpCode op = bin->operand_type == ValueType::INT     ? OpCode::BINARY_INT
+                : bin->operand_type == ValueType::FLOAT ? OpCode::BINARY_FLOAT
+                                                        : OpCode::BINARY;
+    emit(op, bin->op, 0, bin);
+    adjust_stack(-1);
+    break;
+  }
+  default:
+    emit(OpCode::CONST, add_constant(Value()), 0, expr);
+    adjust_stack(1);
+    break;
+  }
+}
+
+void BytecodeCompiler::compile_print(const PrintStmt &print) {
+  for (size_t i = 0; i < print.args.size(); ++i) {
+    compile_expr(print.args[i]);
+    std::string format = i < print.formats.size() ? print.formats[i] : "";
+    emit(OpCode::PRINT_VALUE, add_name(format), 0, &print);
+    adjust_stack(-1);
+  }
+  emit(OpCode::PRINT_END, print.is_printg ? 0 : 1, 0, &print);
+}
+
+void BytecodeCompiler::compile_builtin(const BuiltinInfo *builtin,
+                                       const std::vector<AstNode *> &args,
+                                       const AstNode *node) {
+  for (const auto &arg : args) {
+    compile_expr(arg);
+  }
+  int argc = static_cast<int>(args.size());
+  emit(OpCode::BUILTIN, add_builtin(builtin), argc, node);
+  adjust_stack(1 - argc);
+}
+
+void BytecodeCompiler::compile_call(const CallStmt &call) {
+  if (call.builtin) {
+    compile_builtin(call.builtin, call.args, &call);
+    emit(OpCode::POP);
+    adjust_stack(-1);
+    return;
+  }
+  for (const auto &arg : call.args) {
+    compile_expr(arg);
+  }
+  int argc = static_cast<int>(call.args.size());
+  emit(OpCode::CALL, add_name(call.func_name), argc, &call);
+  adjust_stack(-argc);
+}
+
+void BytecodeCompiler::compile_if(const IfStmt &if_stmt) {
+  compile_expr(if_stmt.condition);
+  size_t else_jump = emit(OpCode::JUMP_IF_FALSE, 0, 0, &if_stmt);
+  adjust_stack(-1);
+  compile_block(if_stmt.then_body);
+  if (if_stmt.else_body.empty()) {
+    patch_jump(else_jump);
+    return;
+  }
+  size_t end_jump = emit(OpCode::JUMP, 0, 0, &if_stmt);
+  patch_jump(else_jump);
+  compile_block(if_stmt.else_body);
+  patch_jump(end_jump);
+}
+
+void BytecodeCompiler::compile_while(const WhileStmt &while_stmt) {
+  size_t loop_start = chunk->code.size();
+  compile_expr(while_stmt.condition);
+  size_t exit_jump = emit(OpCode::JUMP_IF_FALSE, 0, 0, &while_stmt);
+  adjust_stack(-1);
+  compile_block(while_stmt.body);
+  emit(OpCode::JUMP, static_cast<int>(loop_start), 0, &while_stmt);
+  patch_jump(exit_jump);
+}
+
+void BytecodeCompiler::compile_file_op(const FileOp &file_op) {
+  compile_expr(file_op.file_path);
+  int operands = 1;
+  if (file_op.operation == T_WRITE && file_op.data) {
+    compile_expr(file_op.data);
+    operands++;
+  }
+  emit(OpCode::FILE_OP, operands, 0, &file_op);
+  adjust_stack(-operands);
+}
+
+void BytecodeCompiler::compile_net_op(const NetOp &net_op) {
+  int operands = 0;
+  for (const auto *operand : {&net_op.url, &net_op.path, &net_op.port,
+                               &net_op.data, &net_op.workers}) {
+    if (*operand) {
+      compile_expr(*operand);
+      operands++;
+    }
+  }
+  emit(OpCode::NET_OP, operands, 0, &net_op);
+  adjust_stack(-operands);
+}
@@ -0,0 +1,359 @@
+#include "../include/interpreter/HttpParser.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+// A chunk-size line is a hex number and optional extensions, which are
+// ignored; anything longer than this is not a real client.
+constexpr size_t max_chunk_line = 1024;
+
+bool equals_ignore_case(std::string_view value, const char *expected) {
+  size_t length = std::strlen(expected);
+  if (value.size() != length) {
+    return false;
+  }
+  for (size_t i = 0; i < length; ++i) {
+    if (std::tolower(static_cast<unsigned char>(value[i])) != expected[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool equals_ignore_case(std::string_view left, std::string_view right) {
+  return left.size() == right.size() &&
+         std::equal(left.begin(), left.end(), right.begin(),
+                    [](char a, char b) {
+                      return std::tolower(static_cast<unsigned char>(a)) ==
+                             std::tolower(static_cast<unsigned char>(b));
+                    });
+}
+
+std::string_view trim_header(std::string_view value) {
+  size_t start = value.find_first_not_of(" \t");
+  if (start == std::string_view::npos) {
+    return {};
+  }
+  size_t end = value.find_last_not_of(" \t");
+  return value.substr(start, end - start + 1);
+}
+
+int hex_digit(char ch) {
+  if (ch >= '0' && ch <= '9') {
+    return ch - '0';
+  }
+  if (ch >= 'a' && ch <= 'f') {
+    return ch - 'a' + 10;
+  }
+  if (ch >= 'A' && ch <= 'F') {
+    return ch - 'A' + 10;
+  }
+  return -1;
+}
+
+} // namespace
+
+std::string decode_url_component(std::string_view text, bool form_encoded) {
+  std::string decoded;
+  decoded.reserve(text.size());
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (form_encoded && text[i] == '+') {
+      decoded += ' ';
+    } else if (text[i] == '%' && i + 2 < text.size() &&
+               hex_digit(text[i + 1]) >= 0 && hex_digit(text[i + 2]) >= 0) {
+      decoded += static_cast<char>(hex_digit(text[i + 1]) * 16 +
+                                   hex_digit(text[i + 2]));
+      i += 2;
+    } else {
+      decoded += text[i];
+    }
+  }
+  return decoded;
+}
+
+std::string_view HttpRequestMessage::header(std::string_view name) const {
+  for (const HttpHeader &header : headers) {
+    if (equals_ignore_case(header.name, name)) {
+      return header.value;
+    }
+  }
+  return {};
+}
+
+std::string HttpRequestMessage::query_param(std::string_view name) const {
+  size_t start = 0;
+  while (start <= query.size()) {
+    size_t end = query.find('&', start);
+    if (end == std::string_view::npos) {
+      end = query.size();
+    }
+    std::string_view pair = query.substr(start, end - start);
+    size_t equals = pair.find('=');
+    std::string_view key = pair.substr(0, equals);
+    if (!key.empty() && decode_url_component(key, true) == name) {
+      return equals == std::string_view::npos
+                 ? std::string()
+                 : decode_url_component(pair.substr(equals + 1), true);
+    }
+    start = end + 1;
+  }
+  return {};
+}
+
+HttpRequestParser::Status
+HttpRequestParser::parse(std::string &buffer, size_t start,
+                         HttpRequestMessage &request) {
+  if (stage == Stage::HEAD) {
+    Status status = parse_head(buffer, start);
+    if (status != Status::COMPLETE) {
+      return status;
+    }
+  }
+  if (stage == Stage::BODY) {
+    if (buffer.size() - start - body_start < content_length) {
+      return Status::INCOMPLETE;
+    }
+    body_end = body_start + content_length;
+    done = body_end;
+    return finish(buffer, start, request);
+  }
+  Status status = parse_chunks(buffer, start);
+  if (status != Status::COMPLETE) {
+    return status;
+  }
+  return finish(buffer, start, request);
+}
+
+bool HttpRequestParser::take_continue() {
+  bool pending = expect_continue && stage != Stage::HEAD;
+  expect_continue = false;
+  return pending;
+}
+
+// Returns COMPLETE once the request line and headers have been read and the
+// parser has moved on to the body.
+HttpRequestParser::Status
+HttpRequestParser::parse_head(const std::string &buffer, size_t start) {
+  size_t available = buffer.size() - start;
+  // The terminator may straddle the bytes already scanned and the new ones.
+  size_t from = scanned > 3 ? scanned - 3 : 0;
+  size_t head_end = buffer.find("\r\n\r\n", start + from);
+  if (head_end == std::string::npos) {
+    scanned = available;
+    return available > max_header_bytes ? Status::HEADERS_TOO_LARGE
+                                        : Status::INCOMPLETE;
+  }
+  head_end -= start;
+  if (head_end > max_header_bytes) {
+    return Status::HEADERS_TOO_LARGE;
+  }
+
+  std::string_view head(buffer.data() + start, head_end + 2);
+  size_t line_end = head.find("\r\n");
+  std::string_view request_line = head.substr(0, line_end);
+  size_t method_end = request_line.find(' ');
+  size_t target_end = method_end == std::string_view::npos
+                          ? std::string_view::npos
+                          : request_line.find(' ', method_end + 1);
+  if (method_end == 0 || target_end == std::string_view::npos ||
+      target_end == method_end + 1) {
+    return Status::BAD_REQUEST;
+  }
+  std::string_view version = request_line.substr(target_end + 1);
+  if (version.substr(0, 7) != "HTTP/1.") {
+    return Status::BAD_REQUEST;
+  }
+  keep_alive = version == "HTTP/1.1";
+  method = {0, method_end};
+  target = {method_end + 1, target_end - method_end - 1};
+
+  headers.clear();
+  content_length = 0;
+  expect_continue = false;
+  bool has_length = false;
+  bool chunked = false;
+  size_t line_start = line_end + 2;
+  while (line_start < head.size()) {
+    size_t next = head.find("\r\n", line_start);
+    std::string_view line = head.substr(line_start, next - line_start);
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos || colon == 0) {
+      return Status::BAD_REQUEST;
+    }
+    std::string_view name = line.substr(0, colon);
+    // "Name :" is how a proxy and this server could be made to disagree on
+    // where a request ends, so it is refused rather than guessed at.
+    if (name.find_first_of(" \t") != std::string_view::npos) {
+      return Status::BAD_REQUEST;
+    }
+    std::string_view value = trim_header(line.substr(colon + 1));
+    if (headers.size() == max_headers) {
+      return Status::HEADERS_TOO_LARGE;
+    }
+    size_t value_offset =
+        value.empty() ? line_start : value.data() - buffer.data() - start;
+    headers.push_back({{line_start, colon}, {value_offset, value.size()}});
+    line_start = next + 2;
+
+    if (equals_ignore_case(name, "content-length")) {
+      if (value.empty() ||
+          value.find_first_not_of("0123456789") != std::string_view::npos) {
+        return Status::BAD_REQUEST;
+      }
+      size_t length = 0;
+      for (char digit : value) {
+        length = length * 10 + (digit - '0');
+        if (length > max_body_bytes) {
+          return Status::BODY_TOO_LARGE;
+        }
+      }
+      if (has_length && length != content_length) {
+        return Status::BAD_REQUEST;
+      }
+      content_length = length;
+      has_length = true;
+    } else if (equals_ignore_case(name, "transfer-encoding")) {
+      // chunked is the only coding a request body can arrive in here.
+      if (chunked || !equals_ignore_case(value, "chunked")) {
+        return Status::BAD_REQUEST;
+      }
+      chunked = true;
+    } else if (equals_ignore_case(name, "expect")) {
+      // An HTTP/1.0 client does not wait for an interim response.
+      expect_continue = version == "HTTP/1.1" &&
+                        equals_ignore_case(value, "100-continue");
+    } else if (equals_ignore_case(name, "connection")) {
+      size_t option_start = 0;
+      while (option_start <= value.size()) {
+        size_t comma = value.find(',', option_start);
+        std::string_view option = trim_header(value.substr(
+            option_start, comma == std::string_view::npos
+                              ? std::string_view::npos
+                              : comma - option_start));
+        if (equals_ignore_case(option, "close")) {
+          keep_alive = false;
+        } else if (equals_ignore_case(option, "keep-alive")) {
+          keep_alive = true;
+        }
+        if (comma == std::string_view::npos) {
+          break;
+        }
+        option_start = comma + 1;
+      }
+    }
+  }
+  if (chunked && has_length) {
+    return Status::BAD_REQUEST;
+  }
+
+  body_start = head_end + 4;
+  if (chunked) {
+    body_end = body_start;
+    cursor = body_start;
+    stage = Stage::CHUNK_SIZE;
+  } else {
+    stage = Stage::BODY;
+  }
+  return Status::COMPLETE;
+}
+
+// Moves each chunk's data down to body_end as it arrives, so the decoded
+// body ends up contiguous right after the headers and every byte is moved
+// at most once.
+HttpRequestParser::Status
+HttpRequestParser::parse_chunks(std::string &buffer, size_t start) {
+  char *data = &buffer[start];
+  size_t available = buffer.size() - start;
+  Status incomplete = available >= max_request_bytes ? Status::BODY_TOO_LARGE
+                                                     : Status::INCOMPLETE;
+  for (;;) {
+    if (stage == Stage::CHUNK_DATA) {
+      size_t take = std::min(chunk_left, available - cursor);
+      if (take > 0 && body_end != cursor) {
+        std::memmove(data + body_end, data + cursor, take);
+      }
+      body_end += take;
+      cursor += take;
+      chunk_left -= take;
+      if (chunk_left > 0 || available - cursor < 2) {
+        return incomplete;
+      }
+      if (data[cursor] != '\r' || data[cursor + 1] != '\n') {
+        return Status::BAD_REQUEST;
+      }
+      cursor += 2;
+      stage = Stage::CHUNK_SIZE;
+      continue;
+    }
+
+    std::string_view rest(data + cursor, available - cursor);
+    size_t line_end = rest.find("\r\n");
+    if (line_end == std::string_view::npos) {
+      size_t limit = stage == Stage::CHUNK_SIZE ? max_chunk_line
+                                                : max_header_bytes;
+      return rest.size() > limit ? Status::BAD_REQUEST : incomplete;
+    }
+    std::string_view line = rest.substr(0, line_end);
+    cursor += line_end + 2;
+
+    if (stage == Stage::TRAILERS) {
+      // Trailer fields carry nothing a handler can see, so they are skipped.
+      if (line.empty()) {
+        done = cursor;
+        return Status::COMPLETE;
+      }
+      continue;
+    }
+
+    size_t size = 0;
+    size_t digits = 0;
+    while (digits < line.size() && hex_digit(line[digits]) >= 0) {
+      size = size * 16 + hex_digit(line[digits]);
+      if (size > max_body_bytes) {
+        return Status::BODY_TOO_LARGE;
+      }
+      ++digits;
+    }
+    std::string_view extensions = trim_header(line.substr(digits));
+    if (digits == 0 || (!extensions.empty() && extensions[0] != ';')) {
+      return Status::BAD_REQUEST;
+    }
+    if (size == 0) {
+      stage = Stage::TRAILERS;
+      continue;
+    }
+    if (body_end - body_start + size > max_body_bytes) {
+      return Status::BODY_TOO_LARGE;
+    }
+    chunk_left = size;
+    stage = Stage::CHUNK_DATA;
+  }
+}
+
+HttpRequestParser::Status
+HttpRequestParser::finish(const std::string &buffer, size_t start,
+                          HttpRequestMessage &request) {
+  const char *data = buffer.data() + start;
+  auto view = [data](const Span &span) {
+    return std::string_view(data + span.offset, span.length);
+  };
+  request.method = view(method);
+  request.target = view(target);
+  size_t question = request.target.find('?');
+  request.path = request.target.substr(0, question);
+  request.query = question == std::string_view::npos
+                      ? std::string_view()
+                      : request.target.substr(question + 1);
+  request.headers.clear();
+  for (const auto &[name, value] : headers) {
+    request.headers.push_back({view(name), view(value)});
+  }
+  request.body = std::string_view(data + body_start, body_end - body_start);
+  request.keep_alive = keep_alive;
+
+  stage = Stage::HEAD;
+  scanned = 0;
+  expect_continue = false;
+  return Status::COMPLETE;
+}
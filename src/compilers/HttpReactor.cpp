@@ -0,0 +1,320 @@
+#include "../include/interpreter/HttpReactor.h"
+#include "../include/utils/Error.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+HttpReply error_reply(int status, const char *reason) {
+  HttpReply reply;
+  reply.status = status;
+  reply.reason = reason;
+  reply.body = reason;
+  return reply;
+}
+} // namespace
+
+HttpReactor::HttpReactor(int listen_fd, Handler handler, Logger log)
+    : listen_fd(listen_fd), handler(std::move(handler)), log(std::move(log)) {
+  int flags = fcntl(listen_fd, F_GETFL, 0);
+  epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  // Preforked workers all wait on the same listening socket; wake only one
+  // of them per incoming connection.
+  epoll_event event{};
+  event.events = EPOLLIN | EPOLLEXCLUSIVE;
+  event.data.fd = listen_fd;
+  if (flags < 0 || fcntl(listen_fd, F_SETFL, flags | O_NONBLOCK) != 0 ||
+      epoll_fd < 0 ||
+      epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event) != 0) {
+    std::string reason = std::strerror(errno);
+    if (epoll_fd >= 0) {
+      close(epoll_fd);
+    }
+    close(listen_fd);
+    throw RuntimeError("Failed to start server event loop: " + reason);
+  }
+}
+
+HttpReactor::~HttpReactor() {
+  for (const auto &[fd, conn] : connections) {
+    close(fd);
+  }
+  close(epoll_fd);
+  if (listen_fd >= 0) {
+    close(listen_fd);
+  }
+}
+
+void HttpReactor::run() {
+  epoll_event events[64];
+  auto last_sweep = std::chrono::steady_clock::now();
+  for (;;) {
+    int ready = epoll_wait(epoll_fd, events, 64, 1000);
+    if (ready < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw RuntimeError("Server event loop failed: " +
+                         std::string(std::strerror(errno)));
+    }
+    for (int i = 0; i < ready; ++i) {
+      if (events[i].data.fd == listen_fd) {
+        if (!draining) {
+          accept_clients();
+        }
+      } else {
+        handle(events[i].data.fd, events[i].events);
+      }
+    }
+
+    if (draining) {
+      if (listen_fd >= 0) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, listen_fd, nullptr);
+        close(listen_fd);
+        listen_fd = -1;
+      }
+      close_quiet_clients();
+      if (connections.empty()) {
+        return;
+      }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_sweep >= std::chrono::seconds(1)) {
+      close_idle_clients();
+      last_sweep = now;
+    }
+  }
+}
+
+void HttpReactor::drain() { draining = true; }
+
+void HttpReactor::accept_clients() {
+  for (;;) {
+    int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        log("Failed to accept client connection", "WARN");
+      }
+      return;
+    }
+
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+      close(fd);
+      log("Failed to watch client connection", "WARN");
+      continue;
+    }
+    Connection &conn = connections[fd];
+    conn.events = EPOLLIN;
+    conn.last_active = std::chrono::steady_clock::now();
+    log("Accepted client connection", "DEBUG");
+  }
+}
+
+void HttpReactor::handle(int fd, uint32_t events) {
+  auto found = connections.find(fd);
+  if (found == connections.end()) {
+    return;
+  }
+  Connection &conn = found->second;
+  if (events & EPOLLERR) {
+    close_client(fd);
+    return;
+  }
+  if ((events & (EPOLLIN | EPOLLHUP)) && !read_client(fd, conn)) {
+    close_client(fd);
+    return;
+  }
+  progress(fd, conn);
+}
+
+bool HttpReactor::read_client(int fd, Connection &conn) {
+  char buffer[16 * 1024];
+  size_t total = 0;
+  // Stop short of draining the socket once a full request's worth is
+  // buffered; the rest is read after that has been answered.
+  while (conn.input.size() < HttpRequestParser::max_request_bytes) {
+    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+    if (received > 0) {
+      conn.input.append(buffer, received);
+      total += received;
+      continue;
+    }
+    if (received == 0) {
+      conn.eof = true;
+      break;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
+    }
+    return false;
+  }
+  if (total > 0) {
+    conn.last_active = std::chrono::steady_clock::now();
+    log("Received request bytes: " + std::to_string(total), "DEBUG");
+  }
+  return true;
+}
+
+void HttpReactor::serve_buffered(Connection &conn) {
+  size_t offset = 0;
+  while (!conn.closing && offset < conn.input.size()) {
+    HttpRequestParser::Status status =
+        conn.parser.parse(conn.input, offset, conn.request);
+    if (status == HttpRequestParser::Status::INCOMPLETE) {
+      if (conn.parser.take_continue()) {
+        conn.output += "HTTP/1.1 100 Continue\r\n\r\n";
+      }
+      break;
+    }
+    if (status == HttpRequestParser::Status::COMPLETE) {
+      offset += conn.parser.consumed();
+      ++conn.requests;
+      HttpReply reply = handler(conn.request);
+      bool keep_alive = conn.request.keep_alive && !draining;
+      append_reply(conn.output, reply, keep_alive);
+      conn.closing = !keep_alive;
+      continue;
+    }
+
+    HttpReply reply = error_reply(400, "Bad Request");
+    if (status == HttpRequestParser::Status::HEADERS_TOO_LARGE) {
+      reply = error_reply(431, "Request Header Fields Too Large");
+    } else if (status == HttpRequestParser::Status::BODY_TOO_LARGE) {
+      reply = error_reply(413, "Payload Too Large");
+    }
+    log("Rejected request: " + reply.reason, "WARN");
+    append_reply(conn.output, reply, false);
+    conn.closing = true;
+  }
+  if (conn.closing) {
+    conn.input.clear();
+  } else {
+    conn.input.erase(0, offset);
+  }
+}
+
+bool HttpReactor::flush(int fd, Connection &conn) {
+  while (conn.output_sent < conn.output.size()) {
+    ssize_t sent = send(fd, conn.output.data() + conn.output_sent,
+                        conn.output.size() - conn.output_sent, MSG_NOSIGNAL);
+    if (sent > 0) {
+      conn.output_sent += sent;
+      conn.last_active = std::chrono::steady_clock::now();
+      continue;
+    }
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    return sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+  }
+  conn.output.clear();
+  conn.output_sent = 0;
+  return true;
+}
+
+void HttpReactor::progress(int fd, Connection &conn) {
+  // Later pipelined requests wait until earlier answers are on the wire, so
+  // a client that does not read cannot make the server buffer without bound.
+  for (;;) {
+    bool drained = conn.output.empty();
+    if (drained) {
+      serve_buffered(conn);
+    }
+    if (!flush(fd, conn)) {
+      close_client(fd);
+      return;
+    }
+    if (!conn.output.empty()) {
+      break;
+    }
+    if (conn.closing || conn.eof) {
+      if (conn.requests == 0) {
+        log("Client closed connection before sending a request", "DEBUG");
+      }
+      close_client(fd);
+      return;
+    }
+    if (drained) {
+      break;
+    }
+  }
+  watch(fd, conn);
+}
+
+void HttpReactor::watch(int fd, Connection &conn) {
+  uint32_t wanted = conn.output.empty() ? EPOLLIN : EPOLLOUT;
+  if (wanted == conn.events) {
+    return;
+  }
+  epoll_event event{};
+  event.events = wanted;
+  event.data.fd = fd;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) != 0) {
+    close_client(fd);
+    return;
+  }
+  conn.events = wanted;
+}
+
+void HttpReactor::close_client(int fd) {
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+  close(fd);
+  connections.erase(fd);
+}
+
+void HttpReactor::close_idle_clients() {
+  auto deadline = std::chrono::steady_clock::now() - idle_timeout;
+  std::vector<int> idle;
+  for (const auto &[fd, conn] : connections) {
+    if (conn.last_active < deadline) {
+      idle.push_back(fd);
+    }
+  }
+  for (int fd : idle) {
+    log("Closing idle client connection", "DEBUG");
+    close_client(fd);
+  }
+}
+
+// While draining, a connection with nothing buffered either way is between
+// requests and can be closed without cutting anyone off.
+void HttpReactor::close_quiet_clients() {
+  std::vector<int> quiet;
+  for (const auto &[fd, conn] : connections) {
+    if (conn.input.empty() && conn.output.empty()) {
+      quiet.push_back(fd);
+    }
+  }
+  for (int fd : quiet) {
+    close_client(fd);
+  }
+}
+
+void HttpReactor::append_reply(std::string &output, const HttpReply &reply,
+                               bool keep_alive) {
+  output += "HTTP/1.1 " + std::to_string(reply.status) + " " + reply.reason +
+            "\r\n";
+  output += "Content-Type: " + reply.content_type + "\r\n";
+  output += "Content-Length: " + std::to_string(reply.body.size()) + "\r\n";
+  output += keep_alive ? "Connection: keep-alive\r\n\r\n"
+                       : "Connection: close\r\n\r\n";
+  output += reply.body;
+}
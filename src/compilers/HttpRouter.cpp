@@ -0,0 +1,192 @@
+#include "../include/interpreter/HttpRouter.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+bool equals_ignore_case(std::string_view left, std::string_view right) {
+  return left.size() == right.size() &&
+         std::equal(left.begin(), left.end(), right.begin(),
+                    [](char a, char b) {
+                      return std::tolower(static_cast<unsigned char>(a)) ==
+                             std::tolower(static_cast<unsigned char>(b));
+                    });
+}
+
+// ':' and '*' only introduce a parameter at the start of a segment, so
+// routes such as "/time/12:30" keep matching literally.
+bool starts_parameter(std::string_view pattern, size_t pos) {
+  return pos > 0 && pattern[pos - 1] == '/' &&
+         (pattern[pos] == ':' || pattern[pos] == '*');
+}
+} // namespace
+
+std::string_view RouteMatch::param(std::string_view name) const {
+  for (size_t i = 0; i < param_count; ++i) {
+    if (params[i].name == name) {
+      return params[i].value;
+    }
+  }
+  return {};
+}
+
+size_t &HttpRouter::add(const std::string &method, std::string_view pattern,
+                        const SourceLocation &loc) {
+  size_t node = no_route;
+  for (const auto &[name, root] : roots) {
+    if (name == method) {
+      node = root;
+    }
+  }
+  if (node == no_route) {
+    node = add_node();
+    roots.emplace_back(method, node);
+  }
+
+  std::string route(pattern);
+  size_t params = 0;
+  size_t pos = 0;
+  while (pos < pattern.size()) {
+    if (!starts_parameter(pattern, pos)) {
+      size_t end = pos + 1;
+      while (end < pattern.size() && !starts_parameter(pattern, end)) {
+        ++end;
+      }
+      node = insert_literal(node, pattern.substr(pos, end - pos));
+      pos = end;
+      continue;
+    }
+
+    char kind = pattern[pos];
+    size_t end = std::min(pattern.find('/', pos), pattern.size());
+    std::string name(pattern.substr(pos + 1, end - pos - 1));
+    if (name.empty()) {
+      throw RuntimeError("Route parameter in '" + route + "' needs a name",
+                         loc);
+    }
+    if (++params > RouteMatch::max_params) {
+      throw RuntimeError("Route '" + route + "' has more than " +
+                             std::to_string(RouteMatch::max_params) +
+                             " parameters",
+                         loc);
+    }
+
+    if (kind == '*') {
+      if (end != pattern.size()) {
+        throw RuntimeError("Catch-all parameter '*" + name +
+                               "' must end route '" + route + "'",
+                           loc);
+      }
+      Node &target = nodes[node];
+      if (!target.catch_all_name.empty() && target.catch_all_name != name) {
+        throw RuntimeError("Route parameter '*" + name + "' in '" + route +
+                               "' conflicts with '*" + target.catch_all_name +
+                               "'",
+                           loc);
+      }
+      target.catch_all_name = name;
+      return target.catch_all_route;
+    }
+
+    if (nodes[node].param == no_route) {
+      size_t child = add_node();
+      nodes[child].param_name = name;
+      nodes[node].param = child;
+    } else if (nodes[nodes[node].param].param_name != name) {
+      throw RuntimeError("Route parameter ':" + name + "' in '" + route +
+                             "' conflicts with ':" +
+                             nodes[nodes[node].param].param_name + "'",
+                         loc);
+    }
+    node = nodes[node].param;
+    pos = end;
+  }
+  return nodes[node].route;
+}
+
+bool HttpRouter::find(std::string_view method, std::string_view path,
+                      RouteMatch &match) const {
+  match.param_count = 0;
+  for (const auto &[name, root] : roots) {
+    if (equals_ignore_case(name, method)) {
+      return this->match(root, path, match);
+    }
+  }
+  return false;
+}
+
+size_t HttpRouter::add_node() {
+  nodes.emplace_back();
+  return nodes.size() - 1;
+}
+
+// Walks text down from node, splitting a child where text leaves its prefix
+// part way, and returns the node text ends at.
+size_t HttpRouter::insert_literal(size_t node, std::string_view text) {
+  while (!text.empty()) {
+    size_t branch = nodes[node].first_bytes.find(text[0]);
+    if (branch == std::string::npos) {
+      size_t child = add_node();
+      nodes[child].prefix = std::string(text);
+      nodes[node].first_bytes += text[0];
+      nodes[node].children.push_back(child);
+      return child;
+    }
+
+    size_t child = nodes[node].children[branch];
+    size_t common = 0;
+    while (common < nodes[child].prefix.size() && common < text.size() &&
+           nodes[child].prefix[common] == text[common]) {
+      ++common;
+    }
+    if (common < nodes[child].prefix.size()) {
+      size_t middle = add_node();
+      nodes[middle].prefix = nodes[child].prefix.substr(0, common);
+      nodes[child].prefix.erase(0, common);
+      nodes[middle].first_bytes = nodes[child].prefix.substr(0, 1);
+      nodes[middle].children.push_back(child);
+      nodes[node].children[branch] = middle;
+      child = middle;
+    }
+    node = child;
+    text.remove_prefix(common);
+  }
+  return node;
+}
+
+// Tries literal text first, then a parameter, then a catch-all, backing out
+// of a branch that cannot reach a route for the rest of the path.
+bool HttpRouter::match(size_t index, std::string_view rest,
+                       RouteMatch &found) const {
+  const Node &node = nodes[index];
+  if (rest.empty() && node.route != no_route) {
+    found.route = node.route;
+    return true;
+  }
+  if (!rest.empty()) {
+    size_t branch = node.first_bytes.find(rest[0]);
+    if (branch != std::string::npos) {
+      size_t child = node.children[branch];
+      const std::string &prefix = nodes[child].prefix;
+      if (rest.substr(0, prefix.size()) == prefix &&
+          match(child, rest.substr(prefix.size()), found)) {
+        return true;
+      }
+    }
+    if (node.param != no_route && rest[0] != '/') {
+      size_t end = std::min(rest.find('/'), rest.size());
+      size_t saved = found.param_count;
+      found.params[found.param_count++] = {nodes[node.param].param_name,
+                                           rest.substr(0, end)};
+      if (match(node.param, rest.substr(end), found)) {
+        return true;
+      }
+      found.param_count = saved;
+    }
+  }
+  if (node.catch_all_route != no_route) {
+    found.params[found.param_count++] = {node.catch_all_name, rest};
+    found.route = node.catch_all_route;
+    return true;
+  }
+  return false;
+}
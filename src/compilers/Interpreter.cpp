@@ -1,7 +1,11 @@
 #include "../include/interpreter/Interpreter.h"
 #include "../include/utils/Error.h"
 #include "../include/utils/Utils.h"
+#include "../include/vm/Resolver.h"
+#include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <csignal>
 #include <cstring>
 #include <ctime>
 #include <filesystem>
@@ -16,8 +20,12 @@
 #include <openssl/ssl.h>
 #include <sqlite3.h>
 #include <sstream>
+#include <sys/prctl.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/wait.h>
+#include <thread>
 #include <unistd.h>
 
 namespace {
@@ -81,11 +89,6 @@ std::string hmac_sha256_base64url(const std::string &data,
 }
 } // namespace
 
-struct FunctionReturn {
-  Value value;
-  bool has_expr;
-};
-
 static bool path_ends_with(const std::string &value,
                            const std::string &suffix) {
   return value.size() >= suffix.size() &&
@@ -122,27 +125,27 @@ Interpreter::~Interpreter() {
   }
 }
 
-bool Interpreter::is_truthy(const Value &value) const {
-  if (value.type == ValueType::INT) {
-    return value.int_val != 0;
+bool Interpreter::is_truthy(const Value &value) {
+  if (value.type() == ValueType::INT) {
+    return value.int_val() != 0;
   }
-  if (value.type == ValueType::BOOL) {
-    return value.bool_val;
+  if (value.type() == ValueType::BOOL) {
+    return value.bool_val();
   }
-  if (value.type == ValueType::FLOAT) {
-    return value.float_val != 0.0;
+  if (value.type() == ValueType::FLOAT) {
+    return value.float_val() != 0.0;
   }
-  if (value.type == ValueType::STRING) {
-    return !value.str_val.empty();
+  if (value.type() == ValueType::STRING) {
+    return !value.str_val().empty();
   }
-  if (value.type == ValueType::BYTES) {
-    return !value.str_val.empty();
+  if (value.type() == ValueType::BYTES) {
+    return !value.str_val().empty();
   }
-  if (value.type == ValueType::OBJECT) {
-    return !value.obj_val.empty();
+  if (value.type() == ValueType::OBJECT) {
+    return !value.obj_val().empty();
   }
-  if (value.type == ValueType::ARRAY) {
-    return !value.arr_val.empty();
+  if (value.type() == ValueType::ARRAY) {
+    return !value.arr_val().empty();
   }
   return false;
 }
@@ -151,65 +154,56 @@ Value Interpreter::coerce_value(const Value &value,
                                 const std::string &type_name,
                                 const SourceLocation &loc) const {
   if (type_name == "int") {
-    if (value.type == ValueType::INT)
+    if (value.type() == ValueType::INT)
       return value;
-    if (value.type == ValueType::BOOL)
-      return Value(value.bool_val ? 1LL : 0LL);
-    if (value.type == ValueType::FLOAT)
-      return Value(static_cast<long long>(value.float_val));
+    if (value.type() == ValueType::BOOL)
+      return Value(value.bool_val() ? 1LL : 0LL);
+    if (value.type() == ValueType::FLOAT)
+      return Value(static_cast<long long>(value.float_val()));
   }
   if (type_name == "float") {
-    if (value.type == ValueType::FLOAT)
+    if (value.type() == ValueType::FLOAT)
       return value;
-    if (value.type == ValueType::INT)
-      return Value(static_cast<double>(value.int_val));
-    if (value.type == ValueType::BOOL)
-      return Value(value.bool_val ? 1.0 : 0.0);
+    if (value.type() == ValueType::INT)
+      return Value(static_cast<double>(value.int_val()));
+    if (value.type() == ValueType::BOOL)
+      return Value(value.bool_val() ? 1.0 : 0.0);
   }
   if (type_name == "string") {
-    if (value.type == ValueType::STRING)
+    if (value.type() == ValueType::STRING)
       return value;
-    if (value.type == ValueType::BYTES)
-      return Value(value.str_val);
+    if (value.type() == ValueType::BYTES)
+      return Value(value.str_val());
   }
   if (type_name == "bool") {
-    if (value.type == ValueType::BOOL)
+    if (value.type() == ValueType::BOOL)
       return value;
-    if (value.type == ValueType::INT)
-      return Value::Bool(value.int_val != 0);
-    if (value.type == ValueType::FLOAT)
-      return Value::Bool(value.float_val != 0.0);
-    if (value.type == ValueType::STRING || value.type == ValueType::BYTES) {
-      return Value::Bool(!value.str_val.empty());
+    if (value.type() == ValueType::INT)
+      return Value::Bool(value.int_val() != 0);
+    if (value.type() == ValueType::FLOAT)
+      return Value::Bool(value.float_val() != 0.0);
+    if (value.type() == ValueType::STRING || value.type() == ValueType::BYTES) {
+      return Value::Bool(!value.str_val().empty());
     }
   }
   if (type_name == "bytes") {
-    if (value.type == ValueType::BYTES)
+    if (value.type() == ValueType::BYTES)
       return value;
-    if (value.type == ValueType::STRING)
-      return Value::Bytes(value.str_val);
+    if (value.type() == ValueType::STRING)
+      return Value::Bytes(value.str_val());
   }
   if (type_name == "object") {
-    if (value.type == ValueType::OBJECT)
+    if (value.type() == ValueType::OBJECT)
       return value;
   }
   if (type_name == "array") {
-    if (value.type == ValueType::ARRAY)
+    if (value.type() == ValueType::ARRAY)
       return value;
   }
 
   throw TypeError("Cannot convert value to type '" + type_name + "'", loc);
 }
 
-void Interpreter::assign_value(const std::string &name, const Value &value,
-                               std::map<std::string, Value> &locals) {
-  if (globals.count(name)) {
-    globals[name] = value;
-  } else {
-    locals[name] = value;
-  }
-}
-
 Interpreter::ParsedUrl Interpreter::parse_url(const std::string &url,
                                               const SourceLocation &loc) const {
   ParsedUrl parsed;
@@ -460,18 +454,19 @@ void Interpreter::register_http_route(const std::string &method,
     throw RuntimeError("HTTP route handler cannot be empty", loc);
   }
 
-  std::string key = make_route_key(method, path);
-  http_routes[key] = {handler, loc};
+  // Registering the same method and path again replaces its handler.
+  size_t &route = http_router.add(normalize_http_method(method), path, loc);
+  if (route == HttpRouter::no_route) {
+    route = http_routes.size();
+    http_routes.push_back({handler, loc});
+  } else {
+    http_routes[route] = {handler, loc};
+  }
   log_message("Registered route: " + normalize_http_method(method) + " " +
                   path + " -> " + handler,
               "INFO");
 }
 
-std::string Interpreter::make_route_key(const std::string &method,
-                                        const std::string &path) const {
-  return normalize_http_method(method) + " " + path;
-}
-
 std::string
 Interpreter::normalize_http_method(const std::string &method) const {
   std::string normalized;
@@ -499,18 +494,24 @@ std::string Interpreter::read_response_body(const std::string &body,
 
 Value Interpreter::call_http_handler(const HttpRoute &route,
                                      const std::string &method,
-                                     const std::string &path,
-                                     const std::string &body) {
+                                     const HttpRequestMessage &request,
+                                     const RouteMatch &match) {
   if (functions.count(route.handler)) {
     HttpRequest previous_request = current_request;
-    current_request = {method, path, body};
+    current_request = HttpRequest();
+    current_request.method = Value(method);
+    current_request.path = Value(std::string(request.path));
+    current_request.body = Value(std::string(request.body));
+    current_request.message = &request;
+    current_request.route = &match;
     try {
-      auto handler = functions[route.handler];
-      Value result =
-          handler->param_names.empty()
-              ? execute_function(route.handler, {})
-              : execute_function(route.handler,
-                                 {Value(method), Value(path), Value(body)});
+      const auto &handler = functions[route.handler].def;
+      Value result = handler->param_names.empty()
+                         ? execute_function(route.handler, {})
+                         : execute_function(route.handler,
+                                            {current_request.method,
+                                             current_request.path,
+                                             current_request.body});
       current_request = previous_request;
       return result;
     } catch (...) {
@@ -522,16 +523,16 @@ Value Interpreter::call_http_handler(const HttpRoute &route,
 }
 
 std::string Interpreter::response_content_type(const Value &value) const {
-  if (value.type == ValueType::OBJECT || value.type == ValueType::ARRAY) {
+  if (value.type() == ValueType::OBJECT || value.type() == ValueType::ARRAY) {
     return "application/json; charset=utf-8";
   }
-  if (value.type == ValueType::STRING || value.type == ValueType::BYTES) {
+  if (value.type() == ValueType::STRING || value.type() == ValueType::BYTES) {
     size_t start = 0;
-    while (start < value.str_val.size() &&
-           std::isspace(static_cast<unsigned char>(value.str_val[start]))) {
+    while (start < value.str_val().size() &&
+           std::isspace(static_cast<unsigned char>(value.str_val()[start]))) {
       start++;
     }
-    std::string prefix = value.str_val.substr(start, 15);
+    std::string prefix = value.str_val().substr(start, 15);
     for (char &ch : prefix) {
       ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
     }
@@ -547,7 +548,7 @@ std::string Interpreter::response_content_type(const Value &value) const {
 }
 
 std::string Interpreter::response_body_from_value(const Value &value) const {
-  if (value.type == ValueType::OBJECT || value.type == ValueType::ARRAY) {
+  if (value.type() == ValueType::OBJECT || value.type() == ValueType::ARRAY) {
     return stringify_json(value);
   }
   return value.to_string();
@@ -555,13 +556,13 @@ std::string Interpreter::response_body_from_value(const Value &value) const {
 
 Value Interpreter::read_file_path(const Value &arg,
                                   const SourceLocation &loc) const {
-  if (arg.type != ValueType::STRING && arg.type != ValueType::BYTES) {
+  if (arg.type() != ValueType::STRING && arg.type() != ValueType::BYTES) {
     throw TypeError("Builtin 'read::file' expects a string path", loc);
   }
 
-  std::ifstream file(arg.str_val);
+  std::ifstream file(arg.str_val());
   if (!file.is_open()) {
-    throw RuntimeError("Failed to open file: " + arg.str_val, loc);
+    throw RuntimeError("Failed to open file: " + arg.str_val(), loc);
   }
 
   std::string content((std::istreambuf_iterator<char>(file)),
@@ -570,75 +571,66 @@ Value Interpreter::read_file_path(const Value &arg,
   return Value(content);
 }
 
-Value Interpreter::execute_json_builtin(const std::string &name,
+Value Interpreter::execute_json_builtin(const BuiltinInfo &builtin,
                                         const std::vector<Value> &args,
                                         const SourceLocation &loc) {
-  if (name == "json::parse" || name == "json::decode" ||
-      name == "json::unmarshal") {
-    if (args.size() != 1) {
-      throw RuntimeError("Builtin '" + name + "' expects 1 argument", loc);
+  switch (builtin.id) {
+  case BuiltinId::JSON_PARSE:
+    if (args[0].type() != ValueType::STRING &&
+        args[0].type() != ValueType::BYTES) {
+      throw TypeError("Builtin '" + std::string(builtin.name) +
+                          "' expects a string",
+                      loc);
     }
-    if (args[0].type != ValueType::STRING && args[0].type != ValueType::BYTES) {
-      throw TypeError("Builtin '" + name + "' expects a string", loc);
-    }
-    return parse_json(args[0].str_val, loc);
-  }
+    return parse_json(args[0].str_val(), loc);
 
-  if (name == "json::stringify" || name == "json::encode" ||
-      name == "json::marshal") {
-    if (args.size() != 1) {
-      throw RuntimeError("Builtin '" + name + "' expects 1 argument", loc);
-    }
+  case BuiltinId::JSON_STRINGIFY:
     return Value(stringify_json(args[0]));
-  }
 
-  if (name == "json::object") {
+  case BuiltinId::JSON_OBJECT: {
     if (args.size() % 2 != 0) {
       throw RuntimeError("Builtin 'json::object' expects key/value pairs", loc);
     }
 
     std::map<std::string, Value> object;
     for (size_t i = 0; i < args.size(); i += 2) {
-      if (args[i].type != ValueType::STRING &&
-          args[i].type != ValueType::BYTES) {
+      if (args[i].type() != ValueType::STRING &&
+          args[i].type() != ValueType::BYTES) {
         throw TypeError("JSON object keys must be strings", loc);
       }
-      object[args[i].str_val] = args[i + 1];
+      object[args[i].str_val()] = args[i + 1];
     }
-    return Value::Object(object);
+    return Value::Object(std::move(object));
   }
 
-  if (name == "json::get") {
-    if (args.size() != 2) {
-      throw RuntimeError("Builtin 'json::get' expects object and key", loc);
-    }
-    if (args[0].type != ValueType::OBJECT) {
+  case BuiltinId::JSON_GET: {
+    if (args[0].type() != ValueType::OBJECT) {
       throw TypeError("Builtin 'json::get' expects an object", loc);
     }
-    if (args[1].type != ValueType::STRING && args[1].type != ValueType::BYTES) {
+    if (args[1].type() != ValueType::STRING &&
+        args[1].type() != ValueType::BYTES) {
       throw TypeError("JSON object key must be a string", loc);
     }
-    auto it = args[0].obj_val.find(args[1].str_val);
-    if (it == args[0].obj_val.end()) {
+    auto it = args[0].obj_val().find(args[1].str_val());
+    if (it == args[0].obj_val().end()) {
       return Value();
     }
     return it->second;
   }
 
-  if (name == "json::write" || name == "json::save") {
-    if (args.size() != 2) {
-      throw RuntimeError("Builtin '" + name + "' expects path and value", loc);
-    }
-    if (args[0].type != ValueType::STRING && args[0].type != ValueType::BYTES) {
+  case BuiltinId::JSON_WRITE: {
+    if (args[0].type() != ValueType::STRING &&
+        args[0].type() != ValueType::BYTES) {
       throw TypeError("JSON file path must be a string", loc);
     }
 
-    std::ofstream file(args[0].str_val, std::ios::out | std::ios::trunc);
+    std::ofstream file(args[0].str_val(), std::ios::out | std::ios::trunc);
     if (!file.is_open()) {
       throw RuntimeError(
-          "Failed to open JSON file for writing: " + args[0].str_val, loc);
+          "Failed to open JSON file for writing: " + args[0].str_val(), loc);
     }
-    if (args[1].type == ValueType::OBJECT || args[1].type == ValueType::ARRAY) {
+    if (args[1].type() == ValueType::OBJECT ||
+        args[1].type() == ValueType::ARRAY) {
       file << stringify_json(args[1]);
     } else {
       file << args[1].to_json();
@@ -647,45 +639,38 @@ Value Interpreter::execute_json_builtin(const std::string &name,
     return Value::Bool(true);
   }
 
-  if (name == "json::read") {
-    if (args.size() != 1) {
-      throw RuntimeError("Builtin 'json::read' expects 1 argument", loc);
-    }
+  case BuiltinId::JSON_READ: {
     Value content = read_file_path(args[0], loc);
-    return parse_json(content.str_val, loc);
+    return parse_json(content.str_val(), loc);
   }
 
-  throw RuntimeError("Unknown JSON builtin: " + name, loc);
+  default:
+    throw RuntimeError("Unknown JSON builtin: " + std::string(builtin.name),
+                       loc);
+  }
 }
 
-Value Interpreter::execute_auth_builtin(const std::string &name,
+Value Interpreter::execute_auth_builtin(const BuiltinInfo &builtin,
                                         const std::vector<Value> &args,
                                         const SourceLocation &loc) {
-  if (name == "auth::hash_password") {
-    if (args.size() != 1) {
-      throw RuntimeError("Builtin 'auth::hash_password' expects 1 argument",
-                         loc);
-    }
-    if (args[0].type != ValueType::STRING && args[0].type != ValueType::BYTES) {
+  if (builtin.id == BuiltinId::AUTH_HASH_PASSWORD) {
+    if (args[0].type() != ValueType::STRING &&
+        args[0].type() != ValueType::BYTES) {
       throw TypeError("Password must be a string", loc);
     }
     std::string salt = random_hex(16);
     return Value("sha256$" + salt + "$" +
-                 sha256_hex(salt + ":" + args[0].str_val));
+                 sha256_hex(salt + ":" + args[0].str_val()));
   }
 
-  if (name == "auth::verify_password") {
-    if (args.size() != 2) {
-      throw RuntimeError(
-          "Builtin 'auth::verify_password' expects password and hash", loc);
-    }
-    if ((args[0].type != ValueType::STRING &&
-         args[0].type != ValueType::BYTES) ||
-        (args[1].type != ValueType::STRING &&
-         args[1].type != ValueType::BYTES)) {
+  if (builtin.id == BuiltinId::AUTH_VERIFY_PASSWORD) {
+    if ((args[0].type() != ValueType::STRING &&
+         args[0].type() != ValueType::BYTES) ||
+        (args[1].type() != ValueType::STRING &&
+         args[1].type() != ValueType::BYTES)) {
       throw TypeError("Password and hash must be strings", loc);
     }
-    const std::string &stored = args[1].str_val;
+    const std::string &stored = args[1].str_val();
     const std::string prefix = "sha256$";
     if (stored.rfind(prefix, 0) != 0) {
       return Value::Bool(false);
@@ -697,24 +682,23 @@ Value Interpreter::execute_auth_builtin(const std::string &name,
     }
     std::string salt = stored.substr(salt_start, salt_end - salt_start);
     std::string expected =
-        prefix + salt + "$" + sha256_hex(salt + ":" + args[0].str_val);
+        prefix + salt + "$" + sha256_hex(salt + ":" + args[0].str_val());
     return Value::Bool(expected == stored);
   }
 
-  throw RuntimeError("Unknown auth builtin: " + name, loc);
+  throw RuntimeError("Unknown auth builtin: " + std::string(builtin.name),
+                     loc);
 }
 
-Value Interpreter::execute_jwt_builtin(const std::string &name,
+Value Interpreter::execute_jwt_builtin(const BuiltinInfo &builtin,
                                        const std::vector<Value> &args,
                                        const SourceLocation &loc) {
-  if (name == "jwt::sign") {
-    if (args.size() != 2) {
-      throw RuntimeError("Builtin 'jwt::sign' expects payload and secret", loc);
-    }
-    if (args[0].type != ValueType::OBJECT) {
+  if (builtin.id == BuiltinId::JWT_SIGN) {
+    if (args[0].type() != ValueType::OBJECT) {
       throw TypeError("JWT payload must be an object", loc);
     }
-    if (args[1].type != ValueType::STRING && args[1].type != ValueType::BYTES) {
+    if (args[1].type() != ValueType::STRING &&
+        args[1].type() != ValueType::BYTES) {
       throw TypeError("JWT secret must be a string", loc);
     }
     std::string header =
@@ -722,52 +706,86 @@ Value Interpreter::execute_jwt_builtin(const std::string &name,
     std::string payload = base64url_encode(stringify_json(args[0]));
     std::string signing_input = header + "." + payload;
     return Value(signing_input + "." +
-                 hmac_sha256_base64url(signing_input, args[1].str_val));
+                 hmac_sha256_base64url(signing_input, args[1].str_val()));
   }
 
-  if (name == "jwt::verify") {
-    if (args.size() != 2) {
-      throw RuntimeError("Builtin 'jwt::verify' expects token and secret", loc);
-    }
-    if ((args[0].type != ValueType::STRING &&
-         args[0].type != ValueType::BYTES) ||
-        (args[1].type != ValueType::STRING &&
-         args[1].type != ValueType::BYTES)) {
+  if (builtin.id == BuiltinId::JWT_VERIFY) {
+    if ((args[0].type() != ValueType::STRING &&
+         args[0].type() != ValueType::BYTES) ||
+        (args[1].type() != ValueType::STRING &&
+         args[1].type() != ValueType::BYTES)) {
       throw TypeError("JWT token and secret must be strings", loc);
     }
-    size_t first_dot = args[0].str_val.find('.');
-    size_t second_dot = args[0].str_val.find(
+    size_t first_dot = args[0].str_val().find('.');
+    size_t second_dot = args[0].str_val().find(
         '.', first_dot == std::string::npos ? 0 : first_dot + 1);
     if (first_dot == std::string::npos || second_dot == std::string::npos) {
       return Value::Bool(false);
     }
-    std::string signing_input = args[0].str_val.substr(0, second_dot);
+    std::string signing_input = args[0].str_val().substr(0, second_dot);
     std::string expected =
-        hmac_sha256_base64url(signing_input, args[1].str_val);
-    std::string actual = args[0].str_val.substr(second_dot + 1);
+        hmac_sha256_base64url(signing_input, args[1].str_val());
+    std::string actual = args[0].str_val().substr(second_dot + 1);
     return Value::Bool(expected == actual);
   }
 
-  throw RuntimeError("Unknown JWT builtin: " + name, loc);
+  throw RuntimeError("Unknown JWT builtin: " + std::string(builtin.name),
+                     loc);
 }
 
-Value Interpreter::execute_request_builtin(const std::string &name,
+Value Interpreter::request_json(const SourceLocation &loc) {
+  if (!current_request.json_parsed) {
+    current_request.json = parse_json(current_request.body.str_val(), loc);
+    current_request.json_parsed = true;
+  }
+  return current_request.json;
+}
+
+Value Interpreter::execute_request_builtin(const BuiltinInfo &builtin,
                                            const std::vector<Value> &args,
                                            const SourceLocation &loc) {
-  if (!args.empty()) {
-    throw RuntimeError("Builtin '" + name + "' expects 0 arguments", loc);
+  switch (builtin.id) {
+  case BuiltinId::REQUEST_METHOD:
+    return current_request.method;
+  case BuiltinId::REQUEST_PATH:
+    return current_request.path;
+  case BuiltinId::REQUEST_BODY:
+    return current_request.body;
+  case BuiltinId::REQUEST_JSON:
+    return request_json(loc);
+  case BuiltinId::REQUEST_QUERY:
+  case BuiltinId::REQUEST_HEADER:
+  case BuiltinId::REQUEST_PARAM: {
+    for (const Value &arg : args) {
+      if (arg.type() != ValueType::STRING && arg.type() != ValueType::BYTES) {
+        throw TypeError("Builtin '" + std::string(builtin.name) +
+                            "' expects a string name",
+                        loc);
+      }
+    }
+    if (builtin.id == BuiltinId::REQUEST_PARAM) {
+      // Routes match the path as it was sent, so captures are decoded here.
+      const RouteMatch *route = current_request.route;
+      return Value(route ? decode_url_component(
+                               route->param(args[0].str_val()), false)
+                         : std::string());
+    }
+    const HttpRequestMessage *message = current_request.message;
+    if (!message) {
+      return Value(std::string());
+    }
+    if (builtin.id == BuiltinId::REQUEST_HEADER) {
+      return Value(std::string(message->header(args[0].str_val())));
+    }
+    if (args.empty()) {
+      return Value(std::string(message->query));
+    }
+    return Value(message->query_param(args[0].str_val()));
+  }
+  default:
+    throw RuntimeError(
+        "Unknown request builtin: " + std::string(builtin.name), loc);
   }
-
-  if (name == "request::method")
-    return Value(current_request.method);
-  if (name == "request::path")
-    return Value(current_request.path);
-  if (name == "request::body")
-    return Value(current_request.body);
-  if (name == "request::json")
-    return parse_json(current_request.body, loc);
-
-  throw RuntimeError("Unknown request builtin: " + name, loc);
 }
 
 std::string
@@ -786,13 +804,13 @@ Interpreter::escape_sql_identifier(const std::string &identifier,
 }
 
 std::string Interpreter::sql_literal(const Value &value) const {
-  if (value.type == ValueType::INT)
-    return std::to_string(value.int_val);
-  if (value.type == ValueType::FLOAT)
-    return std::to_string(value.float_val);
-  if (value.type == ValueType::BOOL)
-    return value.bool_val ? "1" : "0";
-  if (value.type == ValueType::NONE)
+  if (value.type() == ValueType::INT)
+    return std::to_string(value.int_val());
+  if (value.type() == ValueType::FLOAT)
+    return std::to_string(value.float_val());
+  if (value.type() == ValueType::BOOL)
+    return value.bool_val() ? "1" : "0";
+  if (value.type() == ValueType::NONE)
     return "NULL";
 
   std::string raw = value.to_string();
@@ -873,26 +891,26 @@ std::string Interpreter::build_insert_sql(const std::string &table,
                                           const Value &data,
                                           const SourceLocation &loc) const {
   Value object = data;
-  if (object.type == ValueType::STRING || object.type == ValueType::BYTES) {
-    object = parse_json(object.str_val, loc);
+  if (object.type() == ValueType::STRING || object.type() == ValueType::BYTES) {
+    object = parse_json(object.str_val(), loc);
   }
-  if (object.type != ValueType::OBJECT) {
+  if (object.type() != ValueType::OBJECT) {
     throw TypeError("SQL insert expects a JSON object", loc);
   }
-  if (object.obj_val.empty()) {
+  if (object.obj_val().empty()) {
     throw RuntimeError("SQL insert object cannot be empty", loc);
   }
 
   const ClassDef *model = nullptr;
   auto model_it = orm_models.find(table);
   if (model_it != orm_models.end()) {
-    model = model_it->second.get();
+    model = model_it->second;
   }
 
   std::ostringstream columns;
   std::ostringstream values;
   bool first = true;
-  for (const auto &[key, value] : object.obj_val) {
+  for (const auto &[key, value] : object.obj_val()) {
     if (model) {
       bool known_field = false;
       for (const auto &field : model->fields) {
@@ -970,7 +988,7 @@ Value Interpreter::find_first_row(const std::string &table,
     throw RuntimeError("SQLite query failed: " + message, loc);
   }
   sqlite3_finalize(stmt);
-  return Value::Object(row);
+  return Value::Object(std::move(row));
 }
 
 void Interpreter::execute_sql_statement(const std::string &statement,
@@ -996,127 +1014,119 @@ void Interpreter::execute_sql_statement(const std::string &statement,
   }
 }
 
-Value Interpreter::execute_sql_builtin(const std::string &name,
-                                       const std::vector<Value> &args,
-                                       const SourceLocation &loc) {
-  if (name == "sql::open" || name == "sql::connect") {
-    if (args.size() != 1) {
-      throw RuntimeError("Builtin '" + name + "' expects 1 argument", loc);
-    }
-    if (args[0].type != ValueType::STRING && args[0].type != ValueType::BYTES) {
-      throw TypeError("SQLite database path must be a string", loc);
-    }
+void Interpreter::open_sqlite(const std::string &path,
+                              const SourceLocation &loc) {
+  if (sqlite_db) {
+    sqlite3_close(sqlite_db);
+    sqlite_db = nullptr;
+  }
 
+  sql_output_path = path;
+  int rc = sqlite3_open(sql_output_path.c_str(), &sqlite_db);
+  if (rc != SQLITE_OK) {
+    std::string message =
+        sqlite_db ? sqlite3_errmsg(sqlite_db) : "unknown error";
     if (sqlite_db) {
       sqlite3_close(sqlite_db);
       sqlite_db = nullptr;
     }
+    throw RuntimeError("Failed to open SQLite database: " + message, loc);
+  }
 
-    sql_output_path = args[0].str_val;
-    int rc = sqlite3_open(sql_output_path.c_str(), &sqlite_db);
-    if (rc != SQLITE_OK) {
-      std::string message =
-          sqlite_db ? sqlite3_errmsg(sqlite_db) : "unknown error";
-      if (sqlite_db) {
-        sqlite3_close(sqlite_db);
-        sqlite_db = nullptr;
-      }
-      throw RuntimeError("Failed to open SQLite database: " + message, loc);
-    }
+  char *error_message = nullptr;
+  rc = sqlite3_exec(sqlite_db, "PRAGMA schema_version;", nullptr, nullptr,
+                    &error_message);
+  if (rc != SQLITE_OK) {
+    std::string message =
+        error_message ? error_message : sqlite3_errmsg(sqlite_db);
+    sqlite3_free(error_message);
+    sqlite3_close(sqlite_db);
+    sqlite_db = nullptr;
+    throw RuntimeError("File is not a SQLite database: " + sql_output_path +
+                           ". Use a new .sqlite/.db file or rename the old "
+                           "SQL script. SQLite says: " +
+                           message,
+                       loc);
+  }
+}
 
-    char *error_message = nullptr;
-    rc = sqlite3_exec(sqlite_db, "PRAGMA schema_version;", nullptr, nullptr,
-                      &error_message);
-    if (rc != SQLITE_OK) {
-      std::string message =
-          error_message ? error_message : sqlite3_errmsg(sqlite_db);
-      sqlite3_free(error_message);
-      sqlite3_close(sqlite_db);
-      sqlite_db = nullptr;
-      throw RuntimeError("File is not a SQLite database: " + sql_output_path +
-                             ". Use a new .sqlite/.db file or rename the old "
-                             "SQL script. SQLite says: " +
-                             message,
-                         loc);
+Value Interpreter::execute_sql_builtin(const BuiltinInfo &builtin,
+                                       const std::vector<Value> &args,
+                                       const SourceLocation &loc) {
+  switch (builtin.id) {
+  case BuiltinId::SQL_OPEN: {
+    if (args[0].type() != ValueType::STRING &&
+        args[0].type() != ValueType::BYTES) {
+      throw TypeError("SQLite database path must be a string", loc);
     }
 
+    open_sqlite(args[0].str_val(), loc);
     return Value::Bool(true);
   }
 
-  if (name == "sql::exec") {
-    if (args.size() != 1) {
-      throw RuntimeError("Builtin 'sql::exec' expects 1 argument", loc);
-    }
-    if (args[0].type != ValueType::STRING && args[0].type != ValueType::BYTES) {
+  case BuiltinId::SQL_EXEC:
+    if (args[0].type() != ValueType::STRING &&
+        args[0].type() != ValueType::BYTES) {
       throw TypeError("SQL query must be a string", loc);
     }
-    execute_sql_statement(args[0].str_val, loc);
-    return Value(args[0].str_val);
-  }
+    execute_sql_statement(args[0].str_val(), loc);
+    return Value(args[0].str_val());
 
-  if (name == "orm::migrate") {
-    if (args.size() != 1) {
-      throw RuntimeError("Builtin 'orm::migrate' expects 1 argument", loc);
-    }
-    if (args[0].type != ValueType::STRING && args[0].type != ValueType::BYTES) {
+  case BuiltinId::ORM_MIGRATE: {
+    if (args[0].type() != ValueType::STRING &&
+        args[0].type() != ValueType::BYTES) {
       throw TypeError("ORM model name must be a string", loc);
     }
-    if (!orm_models.count(args[0].str_val)) {
-      throw RuntimeError("ORM model was not found: " + args[0].str_val, loc);
+    if (!orm_models.count(args[0].str_val())) {
+      throw RuntimeError("ORM model was not found: " + args[0].str_val(), loc);
     }
 
-    std::string query = create_table_sql(*orm_models[args[0].str_val]);
+    std::string query = create_table_sql(*orm_models[args[0].str_val()]);
     execute_sql_statement(query, loc);
     return Value(query);
   }
 
-  if (name == "sql::table" || name == "orm::table") {
-    if (args.size() != 2) {
-      throw RuntimeError("Builtin '" + name + "' expects table and columns",
-                         loc);
-    }
-    if (args[0].type != ValueType::STRING && args[0].type != ValueType::BYTES) {
+  case BuiltinId::SQL_TABLE: {
+    if (args[0].type() != ValueType::STRING &&
+        args[0].type() != ValueType::BYTES) {
       throw TypeError("SQL table name must be a string", loc);
     }
-    if (args[1].type != ValueType::STRING && args[1].type != ValueType::BYTES) {
+    if (args[1].type() != ValueType::STRING &&
+        args[1].type() != ValueType::BYTES) {
       throw TypeError("SQL table columns must be a string", loc);
     }
 
     std::string query = "CREATE TABLE IF NOT EXISTS " +
-                        escape_sql_identifier(args[0].str_val, loc) + " (" +
-                        args[1].str_val + ")";
+                        escape_sql_identifier(args[0].str_val(), loc) + " (" +
+                        args[1].str_val() + ")";
     execute_sql_statement(query, loc);
     return Value(query);
   }
 
-  if (name == "sql::insert" || name == "orm::save") {
-    if (args.size() != 2) {
-      throw RuntimeError("Builtin '" + name + "' expects table and data", loc);
-    }
-    if (args[0].type != ValueType::STRING && args[0].type != ValueType::BYTES) {
+  case BuiltinId::SQL_INSERT: {
+    if (args[0].type() != ValueType::STRING &&
+        args[0].type() != ValueType::BYTES) {
       throw TypeError("SQL table name must be a string", loc);
     }
 
-    std::string query = build_insert_sql(args[0].str_val, args[1], loc);
+    std::string query = build_insert_sql(args[0].str_val(), args[1], loc);
     execute_sql_statement(query, loc);
     return Value(query);
   }
 
-  if (name == "orm::find" || name == "sql::find") {
-    if (args.size() != 3) {
-      throw RuntimeError(
-          "Builtin '" + name + "' expects table, field and value", loc);
-    }
-    if ((args[0].type != ValueType::STRING &&
-         args[0].type != ValueType::BYTES) ||
-        (args[1].type != ValueType::STRING &&
-         args[1].type != ValueType::BYTES)) {
+  case BuiltinId::SQL_FIND:
+    if ((args[0].type() != ValueType::STRING &&
+         args[0].type() != ValueType::BYTES) ||
+        (args[1].type() != ValueType::STRING &&
+         args[1].type() != ValueType::BYTES)) {
       throw TypeError("SQL table and field names must be strings", loc);
     }
-    return find_first_row(args[0].str_val, args[1].str_val, args[2], loc);
-  }
+    return find_first_row(args[0].str_val(), args[1].str_val(), args[2], loc);
 
-  throw RuntimeError("Unknown SQL builtin: " + name, loc);
+  default:
+    throw RuntimeError("Unknown SQL builtin: " + std::string(builtin.name),
+                       loc);
+  }
 }
 
 std::string Interpreter::normalize_log_level(const std::string &level) const {
@@ -1163,57 +1173,32 @@ bool Interpreter::is_known_log_level(const std::string &level) const {
          normalized == "CRITICAL";
 }
 
-std::string Interpreter::log_level_from_builtin(const std::string &name) const {
-  if (name == "log_trace")
+std::string Interpreter::log_level_from_builtin(BuiltinId id) const {
+  switch (id) {
+  case BuiltinId::LOG_TRACE:
     return "TRACE";
-  if (name == "log::trace")
-    return "TRACE";
-  if (name == "log_debug")
-    return "DEBUG";
-  if (name == "log::debug")
+  case BuiltinId::LOG_DEBUG:
     return "DEBUG";
-  if (name == "log_notice")
+  case BuiltinId::LOG_NOTICE:
     return "NOTICE";
-  if (name == "log::notice")
-    return "NOTICE";
-  if (name == "log_warn" || name == "log_warning")
-    return "WARN";
-  if (name == "log::warn" || name == "log::warning")
+  case BuiltinId::LOG_WARN:
     return "WARN";
-  if (name == "log_error")
-    return "ERROR";
-  if (name == "log::error")
+  case BuiltinId::LOG_ERROR:
     return "ERROR";
-  if (name == "log_critical" || name == "log_critecal" || name == "log_fatal")
+  case BuiltinId::LOG_CRITICAL:
     return "CRITICAL";
-  if (name == "log::critical" || name == "log::critecal" ||
-      name == "log::fatal")
-    return "CRITICAL";
-  return "INFO";
-}
-
-bool Interpreter::is_log_builtin_name(const std::string &name) const {
-  return name == "log" || name == "log_output" || name == "set_log_output" ||
-         name == "log_console" || name == "log_file" || name == "log::output" ||
-         name == "log::set_output" || name == "log::console" ||
-         name == "log::file" || name == "log::trace" || name == "log::debug" ||
-         name == "log::info" || name == "log::notice" || name == "log::warn" ||
-         name == "log::warning" || name == "log::error" ||
-         name == "log::critical" || name == "log::critecal" ||
-         name == "log::fatal" || name == "log_trace" || name == "log_debug" ||
-         name == "log_info" || name == "log_notice" || name == "log_warn" ||
-         name == "log_warning" || name == "log_error" ||
-         name == "log_critical" || name == "log_critecal" ||
-         name == "log_fatal";
+  default:
+    return "INFO";
+  }
 }
 
 Value Interpreter::set_log_output(const Value &arg, const SourceLocation &loc) {
-  if (arg.type != ValueType::STRING && arg.type != ValueType::BYTES) {
+  if (arg.type() != ValueType::STRING && arg.type() != ValueType::BYTES) {
     throw TypeError("Builtin 'log_output' expects 'console' or 'file'", loc);
   }
 
   std::string target;
-  for (char ch : arg.str_val) {
+  for (char ch : arg.str_val()) {
     target += static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
   }
 
@@ -1224,7 +1209,8 @@ Value Interpreter::set_log_output(const Value &arg, const SourceLocation &loc) {
     target = "file";
   }
 
-  if (target == "file" && !log_file.is_open()) {
+  std::lock_guard<std::mutex> guard(log_sink->lock);
+  if (target == "file" && !log_sink->file.is_open()) {
     throw RuntimeError(
         "Cannot switch log output to file before opening a log file", loc);
   }
@@ -1232,54 +1218,43 @@ Value Interpreter::set_log_output(const Value &arg, const SourceLocation &loc) {
     throw RuntimeError("Log output must be 'console' or 'file'", loc);
   }
 
-  log_output = target;
+  log_sink->output = target;
   return Value::Bool(true);
 }
 
-Value Interpreter::execute_log_builtin(const std::string &name,
+Value Interpreter::execute_log_builtin(const BuiltinInfo &builtin,
                                        const std::vector<Value> &args,
                                        const SourceLocation &loc) {
-  if (name == "log_console" || name == "log::console") {
-    if (!args.empty()) {
-      throw RuntimeError("Builtin 'log_console' expects 0 arguments", loc);
-    }
-    log_output = "console";
+  switch (builtin.id) {
+  case BuiltinId::LOG_CONSOLE: {
+    std::lock_guard<std::mutex> guard(log_sink->lock);
+    log_sink->output = "console";
     return Value::Bool(true);
   }
-  if (name == "log_file" || name == "log::file") {
-    if (args.size() != 1) {
-      throw RuntimeError("Builtin 'log_file' expects 1 argument", loc);
-    }
+  case BuiltinId::LOG_FILE:
     return open_log_path(args[0], loc);
-  }
-  if (name == "log_output" || name == "set_log_output" ||
-      name == "log::output" || name == "log::set_output") {
-    if (args.size() != 1) {
-      throw RuntimeError("Builtin '" + name + "' expects 1 argument", loc);
-    }
+  case BuiltinId::LOG_OUTPUT:
     return set_log_output(args[0], loc);
-  }
-  if (args.empty()) {
-    throw RuntimeError("Builtin '" + name + "' expects at least 1 argument",
-                       loc);
+  default:
+    break;
   }
 
-  std::string level = log_level_from_builtin(name);
+  std::string level = log_level_from_builtin(builtin.id);
   size_t message_start = 0;
   size_t message_end = args.size();
-  if (name == "log" && args.size() > 1) {
-    bool first_is_string =
-        args[0].type == ValueType::STRING || args[0].type == ValueType::BYTES;
-    bool last_is_string = args.back().type == ValueType::STRING ||
-                          args.back().type == ValueType::BYTES;
-    if (first_is_string && is_known_log_level(args[0].str_val)) {
-      level = normalize_log_level(args[0].str_val);
+  if (builtin.id == BuiltinId::LOG && args.size() > 1) {
+    bool first_is_string = args[0].type() == ValueType::STRING ||
+                           args[0].type() == ValueType::BYTES;
+    bool last_is_string = args.back().type() == ValueType::STRING ||
+                          args.back().type() == ValueType::BYTES;
+    if (first_is_string && is_known_log_level(args[0].str_val())) {
+      level = normalize_log_level(args[0].str_val());
       message_start = 1;
-    } else if (last_is_string && is_known_log_level(args.back().str_val)) {
-      level = normalize_log_level(args.back().str_val);
+    } else if (last_is_string && is_known_log_level(args.back().str_val())) {
+      level = normalize_log_level(args.back().str_val());
       message_end--;
     } else if (first_is_string) {
-      level = normalize_log_level(args[0].str_val);
+      level = normalize_log_level(args[0].str_val());
       message_start = 1;
     } else {
       throw TypeError("Builtin 'log' level must be a string", loc);
@@ -1299,34 +1274,26 @@ Value Interpreter::execute_log_builtin(const std::string &name,
 }
 
 Value Interpreter::open_log_path(const Value &arg, const SourceLocation &loc) {
-  if (arg.type != ValueType::STRING && arg.type != ValueType::BYTES) {
+  if (arg.type() != ValueType::STRING && arg.type() != ValueType::BYTES) {
     throw TypeError("Builtin 'open_log' expects a string path", loc);
   }
-  if (log_file.is_open()) {
-    log_file.close();
+  std::lock_guard<std::mutex> guard(log_sink->lock);
+  if (log_sink->file.is_open()) {
+    log_sink->file.close();
   }
-  log_file.open(arg.str_val, std::ios::app);
-  if (!log_file.is_open()) {
-    throw RuntimeError("Failed to open log file: " + arg.str_val, loc);
+  log_sink->file.open(arg.str_val(), std::ios::app);
+  if (!log_sink->file.is_open()) {
+    throw RuntimeError("Failed to open log file: " + arg.str_val(), loc);
   }
-  log_output = "file";
+  log_sink->output = "file";
   return Value::Bool(true);
 }
 
-void Interpreter::run_http_server(const std::string &host, long long port,
-                                  const std::string &body,
-                                  const SourceLocation &loc) {
-  if (port <= 0 || port > 65535) {
-    throw RuntimeError("Server port must be between 1 and 65535", loc);
-  }
-
-  std::string display_host = host.empty() ? "0.0.0.0" : host;
-  std::string server_url =
-      "http://" + display_host + ":" + std::to_string(port);
-  log_message("Server starting on " + server_url, "INFO");
-  log_message("Registered HTTP routes: " + std::to_string(http_routes.size()),
-              "DEBUG");
-
+// Resolves host and binds a listening socket to it. With reuse_port several
+// sockets can share the address, and the kernel spreads new connections
+// across them.
+static int open_http_listener(const std::string &host, long long port,
+                              bool reuse_port, const SourceLocation &loc) {
   struct addrinfo hints{};
   std::memset(&hints, 0, sizeof(hints));
   hints.ai_family = AF_UNSPEC;
@@ -1352,6 +1319,9 @@ void Interpreter::run_http_server(const std::string &host, long long port,
 
     int yes = 1;
     setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    if (reuse_port) {
+      setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes));
+    }
     if (bind(server_fd, rp->ai_addr, rp->ai_addrlen) == 0) {
       break;
     }
@@ -1364,91 +1334,337 @@ void Interpreter::run_http_server(const std::string &host, long long port,
   if (server_fd == -1) {
     throw RuntimeError("Failed to bind local server", loc);
   }
-  if (listen(server_fd, 16) != 0) {
+  if (listen(server_fd, SOMAXCONN) != 0) {
     close(server_fd);
     throw RuntimeError("Failed to listen on local server", loc);
   }
+  return server_fd;
+}
+
+void Interpreter::run_http_server(const std::string &host, long long port,
+                                  const std::string &body, long long workers,
+                                  const SourceLocation &loc) {
+  if (port <= 0 || port > 65535) {
+    throw RuntimeError("Server port must be between 1 and 65535", loc);
+  }
+  if (workers < 0 || workers > max_http_workers) {
+    throw RuntimeError("Server worker count must be between 0 and " +
+                           std::to_string(max_http_workers),
+                       loc);
+  }
+  if (workers == 0) {
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  }
 
-  log_message("Server listening on " + server_url, "INFO");
+  std::string display_host = host.empty() ? "0.0.0.0" : host;
+  std::string server_url =
+      "http://" + display_host + ":" + std::to_string(port);
+  log_message("Server starting on " + server_url, "INFO");
+  log_message("Registered HTTP routes: " + std::to_string(http_routes.size()),
+              "DEBUG");
 
-  while (true) {
-    int client_fd = accept(server_fd, nullptr, nullptr);
-    if (client_fd < 0) {
-      log_message("Failed to accept client connection", "WARN");
-      continue;
+  if (server_options.prefork) {
+    // The workers inherit one listening socket instead of binding their own,
+    // so a restarted worker never leaves a gap in the accept queue.
+    int listen_fd = open_http_listener(host, port, false, loc);
+    log_message("Server listening on " + server_url + " with " +
+                    std::to_string(workers) + " worker processes",
+                "INFO");
+    supervise_http_workers(listen_fd, body, workers, loc);
+  }
+
+  // Every socket is bound and every worker context built before any worker
+  // starts, so a bad address or database fails web::run like it always has.
+  std::vector<int> listeners;
+  std::vector<std::unique_ptr<Interpreter>> contexts;
+  try {
+    for (long long i = 0; i < workers; ++i) {
+      listeners.push_back(open_http_listener(host, port, workers > 1, loc));
+    }
+    if (sqlite_db && workers > 1) {
+      sqlite3_busy_timeout(sqlite_db, sqlite_busy_timeout_ms);
     }
-    log_message("Accepted client connection", "DEBUG");
+    for (long long i = 1; i < workers; ++i) {
+      contexts.push_back(make_worker_context(loc));
+    }
+  } catch (...) {
+    for (int fd : listeners) {
+      close(fd);
+    }
+    throw;
+  }
 
-    char buffer[8192] = {0};
-    ssize_t received = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
-    if (received <= 0) {
-      log_message("Client closed connection before sending a request", "DEBUG");
-      close(client_fd);
-      continue;
+  if (workers > 1) {
+    log_message("Server listening on " + server_url + " with " +
+                    std::to_string(workers) + " workers",
+                "INFO");
+  } else {
+    log_message("Server listening on " + server_url, "INFO");
+  }
+
+  if (contexts.empty()) {
+    serve_http(listeners[0], body, loc);
+    return;
+  }
+
+  // Once a worker thread is running on this process's statics, a failing
+  // worker, the one on this thread included, leaves without destroying them.
+  auto serve_worker = [](Interpreter &worker, int fd, const std::string &body,
+                         const SourceLocation &loc) {
+    try {
+      worker.serve_http(fd, body, loc);
+      return;
+    } catch (const CompilerError &e) {
+      std::cerr << e.get_traceback();
+    } catch (const std::exception &e) {
+      std::cerr << "Error: " << e.what() << "\n";
     }
-    log_message("Received request bytes: " + std::to_string(received), "DEBUG");
-    std::string request(buffer, received);
+    std::cout.flush();
+    std::cerr.flush();
+    std::_Exit(1);
+  };
+  for (size_t i = 0; i < contexts.size(); ++i) {
+    std::thread([serve_worker, context = std::move(contexts[i]),
+                 fd = listeners[i + 1], body, loc]() {
+      serve_worker(*context, fd, body, loc);
+    }).detach();
+  }
+  serve_worker(*this, listeners[0], body, loc);
+}
+
+std::unique_ptr<Interpreter>
+Interpreter::make_worker_context(const SourceLocation &loc) const {
+  auto worker = std::make_unique<Interpreter>();
+  worker->functions = functions;
+  worker->orm_models = orm_models;
+  worker->globals = globals;
+  worker->global_names = global_names;
+  worker->http_routes = http_routes;
+  worker->http_router = http_router;
+  worker->log_sink = log_sink;
+  if (sqlite_db) {
+    worker->open_sqlite(sql_output_path, loc);
+    sqlite3_busy_timeout(worker->sqlite_db, sqlite_busy_timeout_ms);
+  }
+  return worker;
+}
 
-    std::string method, path;
-    size_t pos = request.find(' ');
-    if (pos != std::string::npos) {
-      method = request.substr(0, pos);
-      size_t pos2 = request.find(' ', pos + 1);
-      if (pos2 != std::string::npos) {
-        path = request.substr(pos + 1, pos2 - pos - 1);
+void Interpreter::serve_http(int listen_fd, const std::string &body,
+                             const SourceLocation &loc) {
+  uint64_t served = 0;
+  HttpReactor reactor(
+      listen_fd,
+      [&](const HttpRequestMessage &request) {
+        HttpReply reply = serve_http_request(request, body, loc);
+        if (http_worker_spent(++served)) {
+          log_message("Server worker is over its budget after " +
+                          std::to_string(served) + " requests; draining",
+                      "INFO");
+          reactor.drain();
+        }
+        return reply;
+      },
+      [this](const std::string &message, const std::string &level) {
+        log_message(message, level);
+      });
+  reactor.run();
+}
+
+bool Interpreter::http_worker_spent(uint64_t served) const {
+  if (server_options.max_requests && served >= server_options.max_requests) {
+    return true;
+  }
+  if (!server_options.max_memory_mb) {
+    return false;
+  }
+  struct rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  // ru_maxrss is in KiB on Linux.
+  return static_cast<uint64_t>(usage.ru_maxrss) / 1024 >=
+         server_options.max_memory_mb;
+}
+
+static volatile std::sig_atomic_t supervisor_stop_signal = 0;
+
+static void request_supervisor_stop(int signal) {
+  supervisor_stop_signal = signal;
+}
+
+void Interpreter::supervise_http_workers(int listen_fd,
+                                         const std::string &body,
+                                         long long workers,
+                                         const SourceLocation &loc) {
+  // An SQLite connection must not be used on both sides of a fork, so the
+  // supervisor gives up its own and each worker opens a fresh one.
+  bool open_database = sqlite_db != nullptr;
+  if (sqlite_db) {
+    sqlite3_close(sqlite_db);
+    sqlite_db = nullptr;
+  }
+
+  struct sigaction action{};
+  action.sa_handler = request_supervisor_stop;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  using Clock = std::chrono::steady_clock;
+  std::map<pid_t, Clock::time_point> children;
+  pid_t supervisor = getpid();
+  auto start_worker = [&]() {
+    std::cout.flush();
+    std::cerr.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+      log_message("Failed to fork server worker: " +
+                      std::string(std::strerror(errno)),
+                  "ERROR");
+      return;
+    }
+    if (pid == 0) {
+      prctl(PR_SET_PDEATHSIG, SIGTERM);
+      if (getppid() != supervisor) {
+        std::_Exit(1);
+      }
+      run_http_worker_process(listen_fd, body, open_database, loc);
+    }
+    children[pid] = Clock::now();
+  };
+
+  for (long long i = 0; i < workers; ++i) {
+    start_worker();
+  }
+  if (children.empty()) {
+    throw RuntimeError("Failed to start any server worker", loc);
+  }
+
+  while (!supervisor_stop_signal) {
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      if (errno == EINTR) {
+        continue;
       }
+      throw RuntimeError("Failed to wait for server workers: " +
+                             std::string(std::strerror(errno)),
+                         loc);
+    }
+    auto child = children.find(pid);
+    if (child == children.end()) {
+      continue;
     }
+    Clock::duration lifetime = Clock::now() - child->second;
+    children.erase(child);
 
-    size_t body_pos = request.find("\r\n\r\n");
-    std::string request_body =
-        body_pos != std::string::npos ? request.substr(body_pos + 4) : "";
-    std::string route_key = make_route_key(method, path);
-    auto route = http_routes.find(route_key);
-    log_message("Request: " + method + " " + path + " from client", "INFO");
+    std::string worker = "Server worker " + std::to_string(pid);
+    bool retired = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (retired) {
+      log_message(worker + " retired", "INFO");
+    } else if (WIFSIGNALED(status)) {
+      log_message(worker + " crashed: " + strsignal(WTERMSIG(status)),
+                  "ERROR");
+    } else {
+      log_message(worker + " exited with status " +
+                      std::to_string(WEXITSTATUS(status)),
+                  "ERROR");
+    }
+    // A worker that fails as soon as it starts would otherwise be restarted
+    // in a tight loop.
+    if (!retired && lifetime < std::chrono::seconds(1)) {
+      struct timespec pause{1, 0};
+      nanosleep(&pause, nullptr);
+    }
+    if (!supervisor_stop_signal) {
+      start_worker();
+    }
+  }
 
-    std::string response_body;
-    std::string content_type = "text/plain; charset=utf-8";
-    std::string status_line = "HTTP/1.1 200 OK\r\n";
+  int signal = supervisor_stop_signal;
+  log_message("Server stopping", "INFO");
+  for (const auto &[pid, started] : children) {
+    kill(pid, SIGTERM);
+  }
+  for (const auto &[pid, started] : children) {
+    while (waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {
+    }
+  }
+  close(listen_fd);
+  std::cout.flush();
+  std::signal(signal, SIG_DFL);
+  std::raise(signal);
+  std::_Exit(128 + signal);
+}
 
-    try {
-      if (route != http_routes.end()) {
-        Value result = call_http_handler(
-            route->second, normalize_http_method(method), path, request_body);
-        response_body = response_body_from_value(result);
-        content_type = response_content_type(result);
-        std::string route_content_type = response_content_type_for_path(path);
-        if (!route_content_type.empty()) {
-          content_type = route_content_type;
-        }
-      } else if (!body.empty() && normalize_http_method(method) == "GET" &&
-                 path == "/") {
-        response_body = read_response_body(body, loc);
-        if (body.find(".html") != std::string::npos) {
-          content_type = "text/html; charset=utf-8";
-        }
-      } else {
-        status_line = "HTTP/1.1 404 Not Found\r\n";
-        response_body = "Not found";
-        log_message("Route not found: " + method + " " + path, "WARN");
+void Interpreter::run_http_worker_process(int listen_fd,
+                                          const std::string &body,
+                                          bool open_database,
+                                          const SourceLocation &loc) {
+  std::signal(SIGINT, SIG_DFL);
+  std::signal(SIGTERM, SIG_DFL);
+  int status = 0;
+  try {
+    if (open_database) {
+      open_sqlite(sql_output_path, loc);
+      sqlite3_busy_timeout(sqlite_db, sqlite_busy_timeout_ms);
+    }
+    serve_http(listen_fd, body, loc);
+  } catch (const CompilerError &e) {
+    std::cerr << e.get_traceback();
+    status = 1;
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << "\n";
+    status = 1;
+  }
+  std::cout.flush();
+  std::cerr.flush();
+  std::_Exit(status);
+}
+
+HttpReply Interpreter::serve_http_request(const HttpRequestMessage &request,
+                                          const std::string &body,
+                                          const SourceLocation &loc) {
+  std::string method(request.method);
+  std::string path(request.path);
+  RouteMatch match;
+  bool routed = http_router.find(request.method, request.path, match);
+  log_message("Request: " + method + " " + std::string(request.target) +
+                  " from client",
+              "INFO");
+
+  HttpReply reply;
+  try {
+    if (routed) {
+      Value result =
+          call_http_handler(http_routes[match.route],
+                            normalize_http_method(method), request, match);
+      reply.body = response_body_from_value(result);
+      reply.content_type = response_content_type(result);
+      std::string route_content_type = response_content_type_for_path(path);
+      if (!route_content_type.empty()) {
+        reply.content_type = route_content_type;
       }
-    } catch (const CompilerError &e) {
-      status_line = "HTTP/1.1 500 Internal Server Error\r\n";
-      response_body = e.what();
-      log_message("Route handler failed: " + std::string(e.what()), "ERROR");
-    }
-
-    std::string response = status_line;
-    response += "Content-Type: " + content_type + "\r\n";
-    response +=
-        "Content-Length: " + std::to_string(response_body.size()) + "\r\n";
-    response += "Connection: close\r\n\r\n";
-    response += response_body;
-    send(client_fd, response.data(), response.size(), 0);
-    log_message("Response sent: " + std::to_string(response_body.size()) +
-                    " bytes",
-                "INFO");
-    close(client_fd);
+    } else if (!body.empty() && normalize_http_method(method) == "GET" &&
+               path == "/") {
+      reply.body = read_response_body(body, loc);
+      if (body.find(".html") != std::string::npos) {
+        reply.content_type = "text/html; charset=utf-8";
+      }
+    } else {
+      reply.status = 404;
+      reply.reason = "Not Found";
+      reply.body = "Not found";
+      log_message("Route not found: " + method + " " + path, "WARN");
+    }
+  } catch (const CompilerError &e) {
+    reply.status = 500;
+    reply.reason = "Internal Server Error";
+    reply.body = e.what();
+    log_message("Route handler failed: " + std::string(e.what()), "ERROR");
   }
+
+  log_message("Response sent: " + std::to_string(reply.body.size()) + " bytes",
+              "INFO");
+  return reply;
 }
 
 Value Interpreter::parse_json(const std::string &json_str,
@@ -1488,7 +1704,7 @@ Value Interpreter::parse_json_object(const std::string &json_str, size_t &pos,
   skip_whitespace(json_str, pos);
   if (pos < json_str.size() && json_str[pos] == '}') {
     pos++;
-    return Value::Object(obj);
+    return Value::Object(std::move(obj));
   }
   while (true) {
     skip_whitespace(json_str, pos);
@@ -1499,8 +1715,7 @@ Value Interpreter::parse_json_object(const std::string &json_str, size_t &pos,
     if (json_str[pos] != ':')
       throw RuntimeError("Expected ':' after key", loc);
     pos++;
-    Value value = parse_json_value(json_str, pos, loc);
-    obj[key] = value;
+    obj[key] = parse_json_value(json_str, pos, loc);
     skip_whitespace(json_str, pos);
     if (json_str[pos] == '}') {
       pos++;
@@ -1511,7 +1726,7 @@ Value Interpreter::parse_json_object(const std::string &json_str, size_t &pos,
       throw RuntimeError("Expected ',' or '}' in object", loc);
     }
   }
-  return Value::Object(obj);
+  return Value::Object(std::move(obj));
 }
 
 Value Interpreter::parse_json_array(const std::string &json_str, size_t &pos,
@@ -1521,11 +1736,10 @@ Value Interpreter::parse_json_array(const std::string &json_str, size_t &pos,
   skip_whitespace(json_str, pos);
   if (pos < json_str.size() && json_str[pos] == ']') {
     pos++;
-    return Value::Array(arr);
+    return Value::Array(std::move(arr));
   }
   while (true) {
-    Value value = parse_json_value(json_str, pos, loc);
-    arr.push_back(value);
+    arr.push_back(parse_json_value(json_str, pos, loc));
     skip_whitespace(json_str, pos);
     if (json_str[pos] == ']') {
       pos++;
@@ -1536,7 +1750,7 @@ Value Interpreter::parse_json_array(const std::string &json_str, size_t &pos,
       throw RuntimeError("Expected ',' or ']' in array", loc);
     }
   }
-  return Value::Array(arr);
+  return Value::Array(std::move(arr));
 }
 
 Value Interpreter::parse_json_string(const std::string &json_str, size_t &pos,
@@ -1641,591 +1855,522 @@ std::string Interpreter::stringify_json(const Value &value) const {
   return value.to_json();
 }
 
-void Interpreter::execute_block(
-    const std::vector<std::shared_ptr<AstNode>> &body,
-    std::map<std::string, Value> &locals) {
-  for (const auto &stmt : body) {
-    execute_statement(stmt, locals);
+Value Interpreter::execute_input(const InputStmt &input) {
+  Value val;
+
+  if (!input.prompt.empty()) {
+    std::cout << input.prompt;
+  } else {
+    std::cout << "> ";
   }
-}
+  std::cout.flush();
 
-void Interpreter::execute_statement(const std::shared_ptr<AstNode> &stmt,
-                                    std::map<std::string, Value> &locals) {
-  if (auto decl = std::dynamic_pointer_cast<VarDecl>(stmt)) {
-    Value val =
-        coerce_value(eval(decl->expr, locals), decl->type_name, decl->location);
-    assign_value(decl->name, val, locals);
-    if (DEBUG) {
-      std::cout << "[DEBUG] Set "
-                << (globals.count(decl->name) ? "global" : "local") << " var "
-                << decl->name << " = " << val.to_string() << std::endl;
+  if (input.format == "{int}") {
+    long long x;
+    if (std::cin >> x) {
+      val = Value(x);
+    } else {
+      val = Value(0LL);
+      std::cin.clear();
+      std::cin.ignore(10000, '\n');
     }
-    return;
+  } else if (input.format == "{float}") {
+    double x;
+    if (std::cin >> x) {
+      val = Value(x);
+    } else {
+      val = Value(0.0);
+      std::cin.clear();
+      std::cin.ignore(10000, '\n');
+    }
+  } else if (input.format == "{string}") {
+    std::string x;
+    if (std::cin.peek() == '\n') {
+      std::cin.ignore();
+    }
+    std::getline(std::cin, x);
+    val = Value(x);
+  } else if (input.format == "{bool}") {
+    std::string x;
+    std::cin >> x;
+    val = Value::Bool(x == "true" || x == "1" || x == "yes");
+  } else if (input.format == "{bytes}") {
+    std::string x;
+    if (std::cin.peek() == '\n') {
+      std::cin.ignore();
+    }
+    std::getline(std::cin, x);
+    val = Value::Bytes(x);
+  }
+
+  if (DEBUG) {
+    std::cout << "[DEBUG] Input saved to "
+              << (input.is_global ? "global" : "local") << " '"
+              << (input.var_name.empty() ? "input" : input.var_name)
+              << "' = " << val.to_string() << std::endl;
+  }
+  return val;
+}
+
+void Interpreter::execute_file_op(const FileOp &file_op,
+                                  const Value *operands) {
+  const Value &file_path_val = operands[0];
+  if (file_path_val.type() != ValueType::STRING) {
+    throw TypeError("File path must be a string", file_op.location);
   }
+  std::string file_path = file_path_val.str_val();
 
-  if (auto print = std::dynamic_pointer_cast<PrintStmt>(stmt)) {
-    size_t fmt_idx = 0;
-    for (const auto &arg : print->args) {
-      Value v = eval(arg, locals);
-      std::string fmt =
-          fmt_idx < print->formats.size() ? print->formats[fmt_idx++] : "";
-      std::cout << v.to_string(fmt);
-    }
-    if (!print->is_printg) {
-      std::cout << std::endl;
+  switch (file_op.operation) {
+  case T_CREATE: {
+    std::ofstream file(file_path, std::ios::out);
+    if (!file.is_open()) {
+      throw RuntimeError("Failed to create file: " + file_path,
+                         file_op.location);
     }
-    return;
+    file.close();
+    if (DEBUG)
+      std::cout << "[DEBUG] Created file: " << file_path << std::endl;
+    break;
   }
-
-  if (auto call = std::dynamic_pointer_cast<CallStmt>(stmt)) {
-    std::vector<Value> args;
-    for (const auto &arg : call->args) {
-      args.push_back(eval(arg, locals));
+  case T_WRITE: {
+    if (!file_op.data) {
+      throw SemanticError("Write operation requires data argument",
+                          file_op.location);
     }
-    if (is_log_builtin_name(call->func_name)) {
-      execute_log_builtin(call->func_name, args, call->location);
-      return;
+    const Value &data_val = operands[1];
+    std::ofstream file(file_path, std::ios::out | std::ios::app);
+    if (!file.is_open()) {
+      throw RuntimeError("Failed to open file for writing: " + file_path,
+                         file_op.location);
     }
-    if (call->func_name == "open_log") {
-      if (args.size() != 1) {
-        throw RuntimeError("Builtin 'open_log' expects 1 argument",
-                           call->location);
-      }
-      open_log_path(args[0], call->location);
-      return;
+    file << data_val.to_string();
+    file.close();
+    if (DEBUG)
+      std::cout << "[DEBUG] Wrote to file: " << file_path << std::endl;
+    break;
+  }
+  case T_READ: {
+    std::ifstream file(file_path);
+    if (!file.is_open()) {
+      throw RuntimeError("Failed to open file for reading: " + file_path,
+                         file_op.location);
+    }
+    std::string content;
+    std::string line;
+    while (std::getline(file, line)) {
+      if (!content.empty())
+        content += "\n";
+      content += line;
     }
+    file.close();
     if (DEBUG) {
-      std::cout << "[DEBUG] Calling " << call->func_name << " with "
-                << args.size() << " args" << std::endl;
+      std::cout << "[DEBUG] Read from file: " << file_path << " ("
+                << content.size() << " bytes)" << std::endl;
     }
-    try {
-      execute_function(call->func_name, args);
-    } catch (CompilerError &e) {
-      e.traceback.push_back(call->location);
-      throw;
+    std::cout << content << std::endl;
+    break;
+  }
+  case T_CLOSE: {
+    if (open_files.count(file_path)) {
+      open_files[file_path]->close();
+      open_files.erase(file_path);
+      if (DEBUG)
+        std::cout << "[DEBUG] Closed file: " << file_path << std::endl;
     }
-    return;
+    break;
   }
-
-  if (auto builtin = std::dynamic_pointer_cast<BuiltinCallExpr>(stmt)) {
-    eval(builtin, locals);
-    return;
+  case T_DELETE: {
+    if (std::filesystem::exists(file_path)) {
+      if (open_files.count(file_path)) {
+        open_files[file_path]->close();
+        open_files.erase(file_path);
+      }
+      std::filesystem::remove(file_path);
+      if (DEBUG)
+        std::cout << "[DEBUG] Deleted file: " << file_path << std::endl;
+    } else {
+      throw RuntimeError("File does not exist: " + file_path,
+                         file_op.location);
+    }
+    break;
+  }
+  default:
+    throw SemanticError("Unknown file operation", file_op.location);
   }
+}
+
+void Interpreter::execute_net_op(const NetOp &net_op, const Value *operands) {
+  const Value &url_val = *operands++;
+  const Value *path_val = net_op.path ? operands++ : nullptr;
+  const Value *port_val = net_op.port ? operands++ : nullptr;
+  const Value *data_val = net_op.data ? operands++ : nullptr;
+  const Value *workers_val = net_op.workers ? operands++ : nullptr;
 
-  if (auto ret = std::dynamic_pointer_cast<ReturnStmt>(stmt)) {
-    throw FunctionReturn{ret->expr ? eval(ret->expr, locals) : Value(1LL),
-                         ret->expr != nullptr};
+  if (url_val.type() != ValueType::STRING) {
+    throw TypeError("Network URL must be a string", net_op.location);
   }
 
-  if (auto if_stmt = std::dynamic_pointer_cast<IfStmt>(stmt)) {
-    const auto &body_to_execute = is_truthy(eval(if_stmt->condition, locals))
-                                      ? if_stmt->then_body
-                                      : if_stmt->else_body;
-    execute_block(body_to_execute, locals);
-    return;
+  if (!net_op.transport.empty() && net_op.transport != "http" &&
+      net_op.transport != "https") {
+    throw RuntimeError("Unsupported network transport: " + net_op.transport,
+                       net_op.location);
+  }
+  if (net_op.method != "get" && net_op.method != "post" &&
+      net_op.method != "serve" && net_op.method != "run" &&
+      net_op.method != "route") {
+    throw RuntimeError("Unsupported network method: " + net_op.method,
+                       net_op.location);
+  }
+  if ((net_op.method == "serve" || net_op.method == "run") &&
+      net_op.transport == "https") {
+    throw RuntimeError("Local server currently supports HTTP only",
+                       net_op.location);
   }
 
-  if (auto while_stmt = std::dynamic_pointer_cast<WhileStmt>(stmt)) {
-    while (is_truthy(eval(while_stmt->condition, locals))) {
-      execute_block(while_stmt->body, locals);
+  std::string body;
+  if ((net_op.method == "get" || net_op.method == "post") && data_val &&
+      url_val.str_val().rfind("/", 0) == 0) {
+    if (data_val->type() != ValueType::STRING &&
+        data_val->type() != ValueType::BYTES) {
+      throw TypeError("Route handler must be a string", net_op.location);
     }
+    register_http_route(net_op.method, url_val.str_val(), data_val->str_val(),
+                        net_op.location);
     return;
   }
 
-  if (auto input = std::dynamic_pointer_cast<InputStmt>(stmt)) {
-    Value val;
-
-    if (!input->prompt.empty()) {
-      std::cout << input->prompt;
-    } else {
-      std::cout << "> ";
+  if (net_op.method == "route") {
+    if (!path_val) {
+      throw RuntimeError("Route requires path and handler", net_op.location);
     }
-    std::cout.flush();
-
-    if (input->format == "{int}") {
-      long long x;
-      if (std::cin >> x) {
-        val = Value(x);
-      } else {
-        val = Value(0LL);
-        std::cin.clear();
-        std::cin.ignore(10000, '\n');
-      }
-    } else if (input->format == "{float}") {
-      double x;
-      if (std::cin >> x) {
-        val = Value(x);
-      } else {
-        val = Value(0.0);
-        std::cin.clear();
-        std::cin.ignore(10000, '\n');
-      }
-    } else if (input->format == "{string}") {
-      std::string x;
-      if (std::cin.peek() == '\n') {
-        std::cin.ignore();
-      }
-      std::getline(std::cin, x);
-      val = Value(x);
-    } else if (input->format == "{bool}") {
-      std::string x;
-      std::cin >> x;
-      val = Value::Bool(x == "true" || x == "1" || x == "yes");
-    } else if (input->format == "{bytes}") {
-      std::string x;
-      if (std::cin.peek() == '\n') {
-        std::cin.ignore();
-      }
-      std::getline(std::cin, x);
-      val = Value::Bytes(x);
+    const Value &handler_val = data_val ? *data_val : *path_val;
+    std::string route_method = data_val ? url_val.str_val() : "GET";
+    std::string route_path = data_val ? path_val->str_val() : url_val.str_val();
+    if (path_val->type() != ValueType::STRING) {
+      throw TypeError("Route arguments must be strings", net_op.location);
     }
-
-    std::string var_name = input->var_name.empty() ? "input" : input->var_name;
-    assign_value(var_name, val, locals);
-    if (DEBUG) {
-      std::cout << "[DEBUG] Input saved to "
-                << (globals.count(var_name) ? "global" : "local") << " '"
-                << var_name << "' = " << val.to_string() << std::endl;
+    if (handler_val.type() != ValueType::STRING &&
+        handler_val.type() != ValueType::BYTES) {
+      throw TypeError("Route handler must be a string", net_op.location);
     }
+    register_http_route(route_method, route_path, handler_val.str_val(),
+                        net_op.location);
     return;
   }
 
-  if (auto file_op = std::dynamic_pointer_cast<FileOp>(stmt)) {
-    Value file_path_val = eval(file_op->file_path, locals);
-    if (file_path_val.type != ValueType::STRING) {
-      throw TypeError("File path must be a string", file_op->location);
+  if (net_op.method == "serve" || net_op.method == "run") {
+    if (!port_val) {
+      throw RuntimeError("Server requires host and port", net_op.location);
     }
-    std::string file_path = file_path_val.str_val;
-
-    switch (file_op->operation) {
-    case T_CREATE: {
-      std::ofstream file(file_path, std::ios::out);
-      if (!file.is_open()) {
-        throw RuntimeError("Failed to create file: " + file_path,
-                           file_op->location);
-      }
-      file.close();
-      if (DEBUG)
-        std::cout << "[DEBUG] Created file: " << file_path << std::endl;
-      break;
+    if (port_val->type() != ValueType::INT) {
+      throw TypeError("Server port must be an int", net_op.location);
     }
-    case T_WRITE: {
-      if (!file_op->data) {
-        throw SemanticError("Write operation requires data argument",
-                            file_op->location);
-      }
-      Value data_val = eval(file_op->data, locals);
-      std::ofstream file(file_path, std::ios::out | std::ios::app);
-      if (!file.is_open()) {
-        throw RuntimeError("Failed to open file for writing: " + file_path,
-                           file_op->location);
-      }
-      file << data_val.to_string();
-      file.close();
-      if (DEBUG)
-        std::cout << "[DEBUG] Wrote to file: " << file_path << std::endl;
-      break;
+    if (data_val && data_val->type() == ValueType::INT && !workers_val) {
+      workers_val = data_val;
+      data_val = nullptr;
     }
-    case T_READ: {
-      std::ifstream file(file_path);
-      if (!file.is_open()) {
-        throw RuntimeError("Failed to open file for reading: " + file_path,
-                           file_op->location);
+    if (data_val) {
+      if (data_val->type() != ValueType::STRING &&
+          data_val->type() != ValueType::BYTES) {
+        throw TypeError("Server response body must be a string or bytes",
+                        net_op.location);
       }
-      std::string content;
-      std::string line;
-      while (std::getline(file, line)) {
-        if (!content.empty())
-          content += "\n";
-        content += line;
-      }
-      file.close();
-      if (DEBUG) {
-        std::cout << "[DEBUG] Read from file: " << file_path << " ("
-                  << content.size() << " bytes)" << std::endl;
-      }
-      std::cout << content << std::endl;
-      break;
+      body = data_val->str_val();
     }
-    case T_CLOSE: {
-      if (open_files.count(file_path)) {
-        open_files[file_path]->close();
-        open_files.erase(file_path);
-        if (DEBUG)
-          std::cout << "[DEBUG] Closed file: " << file_path << std::endl;
+    long long workers = 1;
+    if (workers_val) {
+      if (workers_val->type() != ValueType::INT) {
+        throw TypeError("Server worker count must be an int",
+                        net_op.location);
       }
-      break;
-    }
-    case T_DELETE: {
-      if (std::filesystem::exists(file_path)) {
-        if (open_files.count(file_path)) {
-          open_files[file_path]->close();
-          open_files.erase(file_path);
-        }
-        std::filesystem::remove(file_path);
-        if (DEBUG)
-          std::cout << "[DEBUG] Deleted file: " << file_path << std::endl;
-      } else {
-        throw RuntimeError("File does not exist: " + file_path,
-                           file_op->location);
-      }
-      break;
-    }
-    default:
-      throw SemanticError("Unknown file operation", file_op->location);
+      workers = workers_val->int_val();
     }
+    run_http_server(url_val.str_val(), port_val->int_val(), body, workers,
+                    net_op.location);
     return;
   }
 
-  if (auto net_op = std::dynamic_pointer_cast<NetOp>(stmt)) {
-    Value url_val = eval(net_op->url, locals);
-    if (url_val.type != ValueType::STRING) {
-      throw TypeError("Network URL must be a string", net_op->location);
+  if (net_op.method == "post") {
+    if (!data_val) {
+      throw RuntimeError("POST requires a body argument", net_op.location);
     }
-
-    if (!net_op->transport.empty() && net_op->transport != "http" &&
-        net_op->transport != "https") {
-      throw RuntimeError("Unsupported network transport: " + net_op->transport,
-                         net_op->location);
-    }
-    if (net_op->method != "get" && net_op->method != "post" &&
-        net_op->method != "serve" && net_op->method != "run" &&
-        net_op->method != "route") {
-      throw RuntimeError("Unsupported network method: " + net_op->method,
-                         net_op->location);
-    }
-    if ((net_op->method == "serve" || net_op->method == "run") &&
-        net_op->transport == "https") {
-      throw RuntimeError("Local server currently supports HTTP only",
-                         net_op->location);
-    }
-
-    std::string body;
-    if ((net_op->method == "get" || net_op->method == "post") && net_op->data &&
-        url_val.str_val.rfind("/", 0) == 0) {
-      Value handler_val = eval(net_op->data, locals);
-      if (handler_val.type != ValueType::STRING &&
-          handler_val.type != ValueType::BYTES) {
-        throw TypeError("Route handler must be a string", net_op->location);
+    if (data_val->type() != ValueType::STRING) {
+      if (data_val->type() != ValueType::BYTES) {
+        throw TypeError("Network POST body must be a string or bytes",
+                        net_op.location);
       }
-      register_http_route(net_op->method, url_val.str_val, handler_val.str_val,
-                          net_op->location);
-      return;
     }
+    body = data_val->str_val();
+  }
 
-    if (net_op->method == "route") {
-      if (!net_op->path) {
-        throw RuntimeError("Route requires path and handler", net_op->location);
-      }
-      Value first_val = eval(net_op->url, locals);
-      Value second_val = eval(net_op->path, locals);
-      Value handler_val =
-          net_op->data ? eval(net_op->data, locals) : second_val;
-      std::string route_method = net_op->data ? first_val.str_val : "GET";
-      std::string route_path =
-          net_op->data ? second_val.str_val : first_val.str_val;
-      if (first_val.type != ValueType::STRING ||
-          second_val.type != ValueType::STRING) {
-        throw TypeError("Route arguments must be strings", net_op->location);
-      }
-      if (handler_val.type != ValueType::STRING &&
-          handler_val.type != ValueType::BYTES) {
-        throw TypeError("Route handler must be a string", net_op->location);
-      }
-      register_http_route(route_method, route_path, handler_val.str_val,
-                          net_op->location);
-      return;
-    }
+  std::string method = net_op.method == "post" ? "POST" : "GET";
+  std::string response = perform_http_request(
+      net_op.transport, method, url_val.str_val(), body, net_op.location);
+  std::cout << response << std::endl;
+}
 
-    if (net_op->method == "serve" || net_op->method == "run") {
-      if (!net_op->port) {
-        throw RuntimeError("Server requires host and port", net_op->location);
-      }
-      Value port_val = eval(net_op->port, locals);
-      if (port_val.type != ValueType::INT) {
-        throw TypeError("Server port must be an int", net_op->location);
-      }
-      if (net_op->data) {
-        Value body_val = eval(net_op->data, locals);
-        if (body_val.type != ValueType::STRING &&
-            body_val.type != ValueType::BYTES) {
-          throw TypeError("Server response body must be a string or bytes",
-                          net_op->location);
-        }
-        body = body_val.str_val;
-      }
-      run_http_server(url_val.str_val, port_val.int_val, body,
-                      net_op->location);
-      return;
+void Interpreter::load(const std::vector<AstNode *> &program) {
+  Resolver resolver;
+  for (const auto &node : program) {
+    if (auto var = node_cast<VarDecl>(node)) {
+      resolver.resolve_global(*var);
     }
-
-    if (net_op->method == "post") {
-      if (!net_op->data) {
-        throw RuntimeError("POST requires a body argument", net_op->location);
-      }
-      Value body_val = eval(net_op->data, locals);
-      if (body_val.type != ValueType::STRING) {
-        if (body_val.type != ValueType::BYTES) {
-          throw TypeError("Network POST body must be a string or bytes",
-                          net_op->location);
-        }
-      }
-      body = body_val.str_val;
+  }
+  for (const auto &node : program) {
+    if (auto f = node_cast<FunctionDef>(node)) {
+      resolver.resolve_function(*f);
     }
-
-    std::string method = net_op->method == "post" ? "POST" : "GET";
-    std::string response = perform_http_request(
-        net_op->transport, method, url_val.str_val, body, net_op->location);
-    std::cout << response << std::endl;
-    return;
   }
-}
+  global_names = resolver.globals();
+  globals.assign(global_names.size(), Value());
 
-void Interpreter::run(const std::vector<std::shared_ptr<AstNode>> &program) {
+  BytecodeCompiler compiler;
   for (const auto &node : program) {
-    if (auto klass = std::dynamic_pointer_cast<ClassDef>(node)) {
+    switch (node->kind) {
+    case NodeKind::CLASS_DEF: {
+      auto klass = static_cast<ClassDef *>(node);
       orm_models[klass->name] = klass;
-    } else if (auto f = std::dynamic_pointer_cast<FunctionDef>(node)) {
-      functions[f->name] = f;
+      break;
+    }
+    case NodeKind::FUNCTION_DEF: {
+      auto f = static_cast<FunctionDef *>(node);
+      functions[f->name] = {f, compiler.compile_function(*f)};
       for (const auto &route : f->routes) {
         register_http_route(route.method, route.path, f->name, route.location);
       }
-    } else if (auto var = std::dynamic_pointer_cast<VarDecl>(node)) {
-      Value val = coerce_value(eval(var->expr), var->type_name, var->location);
-      globals[var->name] = val;
+      break;
+    }
+    case NodeKind::VAR_DECL: {
+      auto var = static_cast<VarDecl *>(node);
+      auto chunk = compiler.compile_expression(var->expr, var->name);
+      size_t base = frame_stack.size();
+      frame_stack.resize(base + chunk->max_stack + 1);
+      frame_set.resize(frame_stack.size(), 0);
+      Value val;
+      run_chunk(*chunk, base, val);
+      val = coerce_value(val, var->type_name, var->location);
+      frame_stack.resize(base);
+      frame_set.resize(base);
+      globals[var->slot] = val;
       if (DEBUG)
         std::cout << "[DEBUG] Global var " << var->name << " = "
                   << val.to_string() << std::endl;
+      break;
+    }
+    default:
+      break;
     }
   }
+}
 
+void Interpreter::run_main() {
   if (functions.count("main")) {
     execute_function("main", {});
   }
 }
 
+void Interpreter::run(const std::vector<AstNode *> &program) {
+  load(program);
+  run_main();
+}
+
+void Interpreter::set_server_options(const HttpServerOptions &options) {
+  server_options = options;
+}
+
 Value Interpreter::execute_function(const std::string &name,
                                     const std::vector<Value> &call_args) {
-  if (!functions.count(name)) {
+  auto it = functions.find(name);
+  if (it == functions.end()) {
     throw UndefinedError(name, "function", SourceLocation());
   }
-  auto func = functions[name];
+  const FunctionDef &func = *it->second.def;
+  const Chunk &chunk = *it->second.chunk;
+
+  call_stack.push_back(func.location);
 
-  call_stack.push_back(func->location);
+  size_t base = frame_stack.size();
+  frame_stack.resize(base + chunk.frame_size + chunk.max_stack + 1);
+  frame_set.resize(frame_stack.size(), 0);
+  Value *slots = frame_stack.data() + base;
+  unsigned char *slot_set = frame_set.data() + base;
 
-  std::map<std::string, Value> locals;
-  if (!current_request.method.empty()) {
-    locals["request_method"] = Value(current_request.method);
-    locals["request_path"] = Value(current_request.path);
-    locals["request_body"] = Value(current_request.body);
+  if (!current_request.method.str_val().empty()) {
+    const Value *request_values[] = {
+        &current_request.method, &current_request.path, &current_request.body};
+    for (size_t i = 0; i < func.request_slots.size(); ++i) {
+      if (func.request_slots[i] >= 0) {
+        slots[func.request_slots[i]] = *request_values[i];
+        slot_set[func.request_slots[i]] = 1;
+      }
+    }
   }
 
   if (DEBUG)
     std::cout << "[DEBUG] Function " << name << " has "
-              << func->param_names.size() << " params, got " << call_args.size()
+              << func.param_names.size() << " params, got " << call_args.size()
               << " args" << std::endl;
-  for (size_t i = 0; i < func->param_names.size() && i < call_args.size();
-       ++i) {
-    std::string param_type =
-        i < func->param_types.size() ? func->param_types[i] : "";
-    locals[func->param_names[i]] =
-        param_type.empty()
-            ? call_args[i]
-            : coerce_value(call_args[i], param_type, func->location);
-    if (DEBUG)
-      std::cout << "[DEBUG] Param " << func->param_names[i] << " = "
-                << call_args[i].to_string() << std::endl;
-  }
-
+  Value result;
+  ExecStatus status = ExecStatus::NORMAL;
   try {
-    execute_block(func->body, locals);
-  } catch (const FunctionReturn &ret) {
-    call_stack.pop_back();
-    if (!ret.has_expr &&
-        (ret.value.type != ValueType::INT || ret.value.int_val != 1LL)) {
-      CompilerError e(
-          "Function '" + name +
-              "' must return 1 when using return without expression",
-          func->location);
-      e.traceback = call_stack;
-      throw e;
+    for (size_t i = 0; i < func.param_names.size() && i < call_args.size();
+         ++i) {
+      std::string param_type =
+          i < func.param_types.size() ? func.param_types[i] : "";
+      slots[func.param_slots[i]] =
+          param_type.empty()
+              ? call_args[i]
+              : coerce_value(call_args[i], param_type, func.location);
+      slot_set[func.param_slots[i]] = 1;
+      if (DEBUG)
+        std::cout << "[DEBUG] Param " << func.param_names[i] << " = "
+                  << call_args[i].to_string() << std::endl;
     }
-    return ret.value;
+    status = run_chunk(chunk, base, result);
   } catch (CompilerError &e) {
     if (e.traceback.empty()) {
       e.traceback = call_stack;
     }
+    frame_stack.resize(base);
+    frame_set.resize(base);
     call_stack.pop_back();
     throw;
   }
+  frame_stack.resize(base);
+  frame_set.resize(base);
+  if (status == ExecStatus::RETURN) {
+    call_stack.pop_back();
+    return result;
+  }
   CompilerError e("Function '" + name + "' must contain 'return 1'",
-                  func->location);
+                  func.location);
   e.traceback = call_stack;
   call_stack.pop_back();
   throw e;
 }
 
-Value Interpreter::eval(const std::shared_ptr<AstNode> &node,
-                        const std::map<std::string, Value> &locals) {
-  if (!node)
-    return Value();
-  if (auto lit = std::dynamic_pointer_cast<Literal>(node))
-    return lit->value;
-  if (auto builtin = std::dynamic_pointer_cast<BuiltinCallExpr>(node)) {
-    if (builtin->name == "read::file") {
-      if (builtin->args.size() != 1) {
-        throw RuntimeError("Builtin 'read::file' expects 1 argument",
-                           builtin->location);
-      }
-      Value arg = eval(builtin->args[0], locals);
-      return read_file_path(arg, builtin->location);
-    }
-    if (builtin->name.rfind("json::", 0) == 0) {
-      std::vector<Value> args;
-      for (const auto &arg : builtin->args) {
-        args.push_back(eval(arg, locals));
-      }
-      return execute_json_builtin(builtin->name, args, builtin->location);
-    }
-    if (builtin->name.rfind("request::", 0) == 0) {
-      std::vector<Value> args;
-      for (const auto &arg : builtin->args) {
-        args.push_back(eval(arg, locals));
-      }
-      return execute_request_builtin(builtin->name, args, builtin->location);
-    }
-    if (builtin->name.rfind("auth::", 0) == 0) {
-      std::vector<Value> args;
-      for (const auto &arg : builtin->args) {
-        args.push_back(eval(arg, locals));
-      }
-      return execute_auth_builtin(builtin->name, args, builtin->location);
-    }
-    if (builtin->name.rfind("jwt::", 0) == 0) {
-      std::vector<Value> args;
-      for (const auto &arg : builtin->args) {
-        args.push_back(eval(arg, locals));
-      }
-      return execute_jwt_builtin(builtin->name, args, builtin->location);
-    }
-    if (builtin->name.rfind("sql::", 0) == 0 ||
-        builtin->name.rfind("orm::", 0) == 0) {
-      std::vector<Value> args;
-      for (const auto &arg : builtin->args) {
-        args.push_back(eval(arg, locals));
-      }
-      return execute_sql_builtin(builtin->name, args, builtin->location);
-    }
-    if (is_log_builtin_name(builtin->name)) {
-      std::vector<Value> args;
-      for (const auto &arg : builtin->args) {
-        args.push_back(eval(arg, locals));
-      }
-      return execute_log_builtin(builtin->name, args, builtin->location);
-    }
-    if (builtin->name == "protocol") {
-      if (builtin->args.size() != 1) {
-        throw RuntimeError("Builtin 'protocol' expects 1 argument",
-                           builtin->location);
-      }
-      Value arg = eval(builtin->args[0], locals);
-      if (arg.type != ValueType::STRING && arg.type != ValueType::BYTES) {
-        throw TypeError("Builtin 'protocol' expects a string URL",
-                        builtin->location);
-      }
-      ParsedUrl parsed = parse_url(arg.str_val, builtin->location);
-      return Value(parsed.scheme);
-    }
-    if (builtin->name == "json_parse") {
-      if (builtin->args.size() != 1) {
-        throw RuntimeError("Builtin 'json_parse' expects 1 argument",
-                           builtin->location);
-      }
-      Value arg = eval(builtin->args[0], locals);
-      if (arg.type != ValueType::STRING && arg.type != ValueType::BYTES) {
-        throw TypeError("Builtin 'json_parse' expects a string",
-                        builtin->location);
-      }
-      return parse_json(arg.str_val, builtin->location);
-    }
-    if (builtin->name == "json_stringify") {
-      if (builtin->args.size() != 1) {
-        throw RuntimeError("Builtin 'json_stringify' expects 1 argument",
-                           builtin->location);
-      }
-      Value arg = eval(builtin->args[0], locals);
-      return Value(stringify_json(arg));
-    }
-    if (builtin->name == "read_file") {
-      if (builtin->args.size() != 1) {
-        throw RuntimeError("Builtin 'read_file' expects 1 argument",
-                           builtin->location);
-      }
-      Value arg = eval(builtin->args[0], locals);
-      return read_file_path(arg, builtin->location);
-    }
-    if (builtin->name == "open_log") {
-      if (builtin->args.size() != 1) {
-        throw RuntimeError("Builtin 'open_log' expects 1 argument",
-                           builtin->location);
-      }
-      Value arg = eval(builtin->args[0], locals);
-      return open_log_path(arg, builtin->location);
-    }
-    if (builtin->name == "request_method") {
-      if (!builtin->args.empty()) {
-        throw RuntimeError("Builtin 'request_method' expects 0 arguments",
-                           builtin->location);
-      }
-      return Value(current_request.method);
-    }
-    if (builtin->name == "request_path") {
-      if (!builtin->args.empty()) {
-        throw RuntimeError("Builtin 'request_path' expects 0 arguments",
-                           builtin->location);
-      }
-      return Value(current_request.path);
-    }
-    if (builtin->name == "request_body") {
-      if (!builtin->args.empty()) {
-        throw RuntimeError("Builtin 'request_body' expects 0 arguments",
-                           builtin->location);
-      }
-      return Value(current_request.body);
-    }
-    if (builtin->name == "request_json") {
-      if (!builtin->args.empty()) {
-        throw RuntimeError("Builtin 'request_json' expects 0 arguments",
-                           builtin->location);
-      }
-      return parse_json(current_request.body, builtin->location);
-    }
-    throw RuntimeError("Unknown builtin expression: " + builtin->name,
-                       builtin->location);
-  }
-  if (auto id = std::dynamic_pointer_cast<Identifier>(node)) {
-    if (locals.count(id->name)) {
-      return locals.at(id->name);
-    }
-    if (globals.count(id->name)) {
-      return globals[id->name];
-    }
-    UndefinedError err(id->name, "variable", id->location);
-    err.traceback = call_stack;
-    throw err;
+Value Interpreter::call_builtin(const BuiltinInfo &builtin,
+                                const std::vector<Value> &args,
+                                const SourceLocation &loc) {
+  switch (builtin.id) {
+  case BuiltinId::PROTOCOL: {
+    if (args[0].type() != ValueType::STRING &&
+        args[0].type() != ValueType::BYTES) {
+      throw TypeError("Builtin 'protocol' expects a string URL", loc);
+    }
+    ParsedUrl parsed = parse_url(args[0].str_val(), loc);
+    return Value(parsed.scheme);
+  }
+  case BuiltinId::READ_FILE:
+    return read_file_path(args[0], loc);
+  case BuiltinId::OPEN_LOG:
+    return open_log_path(args[0], loc);
+  case BuiltinId::REQUEST_METHOD:
+  case BuiltinId::REQUEST_PATH:
+  case BuiltinId::REQUEST_BODY:
+  case BuiltinId::REQUEST_JSON:
+  case BuiltinId::REQUEST_QUERY:
+  case BuiltinId::REQUEST_HEADER:
+  case BuiltinId::REQUEST_PARAM:
+    return execute_request_builtin(builtin, args, loc);
+  case BuiltinId::JSON_PARSE:
+  case BuiltinId::JSON_STRINGIFY:
+  case BuiltinId::JSON_WRITE:
+  case BuiltinId::JSON_READ:
+  case BuiltinId::JSON_GET:
+  case BuiltinId::JSON_OBJECT:
+    return execute_json_builtin(builtin, args, loc);
+  case BuiltinId::AUTH_HASH_PASSWORD:
+  case BuiltinId::AUTH_VERIFY_PASSWORD:
+    return execute_auth_builtin(builtin, args, loc);
+  case BuiltinId::JWT_SIGN:
+  case BuiltinId::JWT_VERIFY:
+    return execute_jwt_builtin(builtin, args, loc);
+  case BuiltinId::SQL_OPEN:
+  case BuiltinId::SQL_EXEC:
+  case BuiltinId::SQL_TABLE:
+  case BuiltinId::SQL_INSERT:
+  case BuiltinId::SQL_FIND:
+  case BuiltinId::ORM_MIGRATE:
+    return execute_sql_builtin(builtin, args, loc);
+  default:
+    return execute_log_builtin(builtin, args, loc);
   }
-  if (auto bin = std::dynamic_pointer_cast<BinaryOp>(node)) {
-    Value l = eval(bin->left, locals);
-    Value r = eval(bin->right, locals);
-
-    if (bin->op == T_GREATER || bin->op == T_LESS ||
-        bin->op == T_GREATER_EQUAL || bin->op == T_LESS_EQUAL ||
-        bin->op == T_EQUAL_EQUAL || bin->op == T_NOT_EQUAL) {
-      bool result = false;
+}
 
-      if (l.type == ValueType::STRING && r.type == ValueType::STRING) {
-        int cmp = l.str_val.compare(r.str_val);
-        switch (bin->op) {
+Value Interpreter::binary_op(TokenType op, const Value &l, const Value &r) {
+  if (op == T_GREATER || op == T_LESS || op == T_GREATER_EQUAL ||
+      op == T_LESS_EQUAL || op == T_EQUAL_EQUAL || op == T_NOT_EQUAL) {
+    bool result = false;
+
+    if (l.type() == ValueType::INT && r.type() == ValueType::INT) {
+      long long lv = l.int_val();
+      long long rv = r.int_val();
+      switch (op) {
+      case T_GREATER:
+        result = (lv > rv);
+        break;
+      case T_LESS:
+        result = (lv < rv);
+        break;
+      case T_GREATER_EQUAL:
+        result = (lv >= rv);
+        break;
+      case T_LESS_EQUAL:
+        result = (lv <= rv);
+        break;
+      case T_EQUAL_EQUAL:
+        result = (lv == rv);
+        break;
+      case T_NOT_EQUAL:
+        result = (lv != rv);
+        break;
+      default:
+        break;
+      }
+    } else if (l.type() == ValueType::STRING && r.type() == ValueType::STRING) {
+      int cmp = l.str_val().compare(r.str_val());
+      switch (op) {
+      case T_GREATER:
+        result = (cmp > 0);
+        break;
+      case T_LESS:
+        result = (cmp < 0);
+        break;
+      case T_GREATER_EQUAL:
+        result = (cmp >= 0);
+        break;
+      case T_LESS_EQUAL:
+        result = (cmp <= 0);
+        break;
+      case T_EQUAL_EQUAL:
+        result = (cmp == 0);
+        break;
+      case T_NOT_EQUAL:
+        result = (cmp != 0);
+        break;
+      }
+    } else {
+      if (l.type() == ValueType::STRING || r.type() == ValueType::STRING ||
+          l.type() == ValueType::BYTES || r.type() == ValueType::BYTES ||
+          l.type() == ValueType::NONE || r.type() == ValueType::NONE) {
+        std::string l_str =
+            (l.type() == ValueType::STRING || l.type() == ValueType::BYTES)
+                ? l.str_val()
+                : l.to_string();
+        std::string r_str =
+            (r.type() == ValueType::STRING || r.type() == ValueType::BYTES)
+                ? r.str_val()
+                : r.to_string();
+        if (DEBUG)
+          std::cout << "[DEBUG] Comparing: '" << l_str << "' "
+                    << (op == T_GREATER       ? ">"
+                        : op == T_LESS        ? "<"
+                        : op == T_EQUAL_EQUAL ? "=="
+                                              : "?")
+                    << " '" << r_str << "'" << std::endl;
+        int cmp = l_str.compare(r_str);
+        switch (op) {
         case T_GREATER:
           result = (cmp > 0);
           break;
@@ -2245,132 +2390,90 @@ Value Interpreter::eval(const std::shared_ptr<AstNode> &node,
           result = (cmp != 0);
           break;
         }
+        if (DEBUG)
+          std::cout << "[DEBUG] Comparison result: "
+                    << (result ? "true" : "false") << std::endl;
       } else {
-        if (l.type == ValueType::STRING || r.type == ValueType::STRING ||
-            l.type == ValueType::BYTES || r.type == ValueType::BYTES ||
-            l.type == ValueType::NONE || r.type == ValueType::NONE) {
-          std::string l_str =
-              (l.type == ValueType::STRING || l.type == ValueType::BYTES)
-                  ? l.str_val
-                  : l.to_string();
-          std::string r_str =
-              (r.type == ValueType::STRING || r.type == ValueType::BYTES)
-                  ? r.str_val
-                  : r.to_string();
-          if (DEBUG)
-            std::cout << "[DEBUG] Comparing: '" << l_str << "' "
-                      << (bin->op == T_GREATER       ? ">"
-                          : bin->op == T_LESS        ? "<"
-                          : bin->op == T_EQUAL_EQUAL ? "=="
-                                                     : "?")
-                      << " '" << r_str << "'" << std::endl;
-          int cmp = l_str.compare(r_str);
-          switch (bin->op) {
-          case T_GREATER:
-            result = (cmp > 0);
-            break;
-          case T_LESS:
-            result = (cmp < 0);
-            break;
-          case T_GREATER_EQUAL:
-            result = (cmp >= 0);
-            break;
-          case T_LESS_EQUAL:
-            result = (cmp <= 0);
-            break;
-          case T_EQUAL_EQUAL:
-            result = (cmp == 0);
-            break;
-          case T_NOT_EQUAL:
-            result = (cmp != 0);
-            break;
-          }
-          if (DEBUG)
-            std::cout << "[DEBUG] Comparison result: "
-                      << (result ? "true" : "false") << std::endl;
-        } else {
-          double lv, rv;
-          if (l.type == ValueType::FLOAT)
-            lv = l.float_val;
-          else if (l.type == ValueType::INT)
-            lv = l.int_val;
-          else if (l.type == ValueType::BOOL)
-            lv = l.bool_val ? 1.0 : 0.0;
-          else
-            lv = 0.0;
-
-          if (r.type == ValueType::FLOAT)
-            rv = r.float_val;
-          else if (r.type == ValueType::INT)
-            rv = r.int_val;
-          else if (r.type == ValueType::BOOL)
-            rv = r.bool_val ? 1.0 : 0.0;
-          else
-            rv = 0.0;
-
-          switch (bin->op) {
-          case T_GREATER:
-            result = (lv > rv);
-            break;
-          case T_LESS:
-            result = (lv < rv);
-            break;
-          case T_GREATER_EQUAL:
-            result = (lv >= rv);
-            break;
-          case T_LESS_EQUAL:
-            result = (lv <= rv);
-            break;
-          case T_EQUAL_EQUAL:
-            result = (lv == rv);
-            break;
-          case T_NOT_EQUAL:
-            result = (lv != rv);
-            break;
-          }
+        double lv, rv;
+        if (l.type() == ValueType::FLOAT)
+          lv = l.float_val();
+        else if (l.type() == ValueType::INT)
+          lv = l.int_val();
+        else if (l.type() == ValueType::BOOL)
+          lv = l.bool_val() ? 1.0 : 0.0;
+        else
+          lv = 0.0;
+
+        if (r.type() == ValueType::FLOAT)
+          rv = r.float_val();
+        else if (r.type() == ValueType::INT)
+          rv = r.int_val();
+        else if (r.type() == ValueType::BOOL)
+          rv = r.bool_val() ? 1.0 : 0.0;
+        else
+          rv = 0.0;
+
+        switch (op) {
+        case T_GREATER:
+          result = (lv > rv);
+          break;
+        case T_LESS:
+          result = (lv < rv);
+          break;
+        case T_GREATER_EQUAL:
+          result = (lv >= rv);
+          break;
+        case T_LESS_EQUAL:
+          result = (lv <= rv);
+          break;
+        case T_EQUAL_EQUAL:
+          result = (lv == rv);
+          break;
+        case T_NOT_EQUAL:
+          result = (lv != rv);
+          break;
         }
       }
-      return Value(result ? 1LL : 0LL);
-    }
-
-    if (l.type == ValueType::FLOAT || r.type == ValueType::FLOAT) {
-      double lv = (l.type == ValueType::FLOAT)
-                      ? l.float_val
-                      : (l.type == ValueType::BOOL ? (l.bool_val ? 1.0 : 0.0)
-                                                   : l.int_val);
-      double rv = (r.type == ValueType::FLOAT)
-                      ? r.float_val
-                      : (r.type == ValueType::BOOL ? (r.bool_val ? 1.0 : 0.0)
-                                                   : r.int_val);
-      switch (bin->op) {
-      case T_PLUS:
-        return Value(lv + rv);
-      case T_MINUS:
-        return Value(lv - rv);
-      case T_STAR:
-        return Value(lv * rv);
-      case T_SLASH:
-        return Value(rv != 0.0 ? lv / rv : 0.0);
-      }
     }
-    if ((l.type == ValueType::INT || l.type == ValueType::BOOL) &&
-        (r.type == ValueType::INT || r.type == ValueType::BOOL)) {
-      long long lv =
-          l.type == ValueType::BOOL ? (l.bool_val ? 1LL : 0LL) : l.int_val;
-      long long rv =
-          r.type == ValueType::BOOL ? (r.bool_val ? 1LL : 0LL) : r.int_val;
-      switch (bin->op) {
-      case T_PLUS:
-        return Value(lv + rv);
-      case T_MINUS:
-        return Value(lv - rv);
-      case T_STAR:
-        return Value(lv * rv);
-      case T_SLASH:
-        return Value(rv != 0 ? lv / rv : 0LL);
-      }
+    return Value(result ? 1LL : 0LL);
+  }
+
+  if (l.type() == ValueType::FLOAT || r.type() == ValueType::FLOAT) {
+    double lv = (l.type() == ValueType::FLOAT)
+                    ? l.float_val()
+                    : (l.type() == ValueType::BOOL ? (l.bool_val() ? 1.0 : 0.0)
+                                                 : l.int_val());
+    double rv = (r.type() == ValueType::FLOAT)
+                    ? r.float_val()
+                    : (r.type() == ValueType::BOOL ? (r.bool_val() ? 1.0 : 0.0)
+                                                 : r.int_val());
+    switch (op) {
+    case T_PLUS:
+      return Value(lv + rv);
+    case T_MINUS:
+      return Value(lv - rv);
+    case T_STAR:
+      return Value(lv * rv);
+    case T_SLASH:
+      return Value(rv != 0.0 ? lv / rv : 0.0);
+    }
+  }
+  if ((l.type() == ValueType::INT || l.type() == ValueType::BOOL) &&
+      (r.type() == ValueType::INT || r.type() == ValueType::BOOL)) {
+    long long lv =
+        l.type() == ValueType::BOOL ? (l.bool_val() ? 1LL : 0LL) : l.int_val();
+    long long rv =
+        r.type() == ValueType::BOOL ? (r.bool_val() ? 1LL : 0LL) : r.int_val();
+    switch (op) {
+    case T_PLUS:
+      return Value(lv + rv);
+    case T_MINUS:
+      return Value(lv - rv);
+    case T_STAR:
+      return Value(lv * rv);
+    case T_SLASH:
+      return Value(rv != 0 ? lv / rv : 0LL);
     }
-    return Value();
   }
   return Value();
 }
@@ -2378,14 +2481,16 @@ Value Interpreter::eval(const std::shared_ptr<AstNode> &node,
 void Interpreter::log_message(const std::string &message,
                               const std::string &level) {
   std::time_t now = std::time(nullptr);
+  std::tm local_time{};
+  localtime_r(&now, &local_time);
   char time_str[20];
-  std::strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S",
-                std::localtime(&now));
+  std::strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &local_time);
   std::string log_entry = "[" + std::string(time_str) + "] [" +
                           normalize_log_level(level) + "] " + message;
-  if (log_output == "file" && log_file.is_open()) {
-    log_file << log_entry << std::endl;
-    log_file.flush();
+  std::lock_guard<std::mutex> guard(log_sink->lock);
+  if (log_sink->output == "file" && log_sink->file.is_open()) {
+    log_sink->file << log_entry << std::endl;
+    log_sink->file.flush();
     return;
   }
   std::cout << log_entry << std::endl;
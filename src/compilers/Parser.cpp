@@ -6,82 +6,9 @@
 #include <vector>
 
 namespace {
-bool is_builtin_call_name(const std::string &name) {
-  static const std::vector<std::string> names = {"protocol",
-                                                 "json_parse",
-                                                 "json_stringify",
-                                                 "read_file",
-                                                 "open_log",
-                                                 "request_method",
-                                                 "request_path",
-                                                 "request_body",
-                                                 "request_json",
-                                                 "request::method",
-                                                 "request::path",
-                                                 "request::body",
-                                                 "request::json",
-                                                 "read::file",
-                                                 "log",
-                                                 "log_output",
-                                                 "set_log_output",
-                                                 "log_console",
-                                                 "log_file",
-                                                 "log::output",
-                                                 "log::set_output",
-                                                 "log::console",
-                                                 "log::file",
-                                                 "log::trace",
-                                                 "log::debug",
-                                                 "log::info",
-                                                 "log::notice",
-                                                 "log::warn",
-                                                 "log::warning",
-                                                 "log::error",
-                                                 "log::critical",
-                                                 "log::critecal",
-                                                 "log::fatal",
-                                                 "log_trace",
-                                                 "log_debug",
-                                                 "log_info",
-                                                 "log_notice",
-                                                 "log_warn",
-                                                 "log_warning",
-                                                 "log_error",
-                                                 "log_critical",
-                                                 "log_critecal",
-                                                 "log_fatal",
-                                                 "json::parse",
-                                                 "json::decode",
-                                                 "json::unmarshal",
-                                                 "json::stringify",
-                                                 "json::encode",
-                                                 "json::marshal",
-                                                 "json::write",
-                                                 "json::save",
-                                                 "json::read",
-                                                 "json::get",
-                                                 "json::object",
-                                                 "auth::hash_password",
-                                                 "auth::verify_password",
-                                                 "jwt::sign",
-                                                 "jwt::verify",
-                                                 "sql::open",
-                                                 "sql::connect",
-                                                 "sql::exec",
-                                                 "sql::table",
-                                                 "sql::insert",
-                                                 "sql::find",
-                                                 "orm::table",
-                                                 "orm::migrate",
-                                                 "orm::save",
-                                                 "orm::find"};
-
-  for (const auto &builtin_name : names) {
-    if (name == builtin_name) {
-      return true;
-    }
-  }
-  return false;
+const BuiltinInfo *find_statement_builtin(const std::string &name) {
+  const BuiltinInfo *builtin = find_builtin(name);
+  return builtin && builtin->statement ? builtin : nullptr;
 }
 
 bool is_namespaced_builtin_root(const Token &token) {
@@ -102,49 +29,22 @@ bool is_namespaced_builtin_member(const Token &token) {
          token.type == T_OBJECT || token.type == T_READ ||
          token.type == T_WRITE;
 }
-
-bool is_comment_token(TokenType type) {
-  return type == T_LINE_COMMENT || type == T_BLOCK_COMMENT;
-}
 } // namespace
 
-void Parser::load_tokens(std::vector<Token> t) {
-  tokens.clear();
-  tokens.reserve(t.size() + 1);
-  for (const auto &token : t) {
-    if (is_comment_token(token.type)) {
-      continue;
-    }
-    tokens.push_back(token);
-  }
-  pos = 0;
-  if (tokens.empty() || tokens.back().type != T_EOF)
-    tokens.push_back({T_EOF});
-}
+bool Parser::is_eof() { return current().type == T_EOF; }
 
-bool Parser::is_eof() const {
-  return pos >= tokens.size() || tokens[pos].type == T_EOF;
-}
+const Token &Parser::current() { return tokens.peek(); }
 
-const Token &Parser::current() const {
-  static const Token eof_token{T_EOF, "", 0};
-  if (tokens.empty())
-    return eof_token;
-  if (pos >= tokens.size())
-    return tokens.back();
-  return tokens[pos];
-}
-void Parser::advance() {
-  if (!is_eof())
-    ++pos;
-}
+const Token &Parser::peek(size_t offset) { return tokens.peek(offset); }
+
+void Parser::advance() { tokens.advance(); }
 
 std::string Parser::parse_type_name() {
   if (current().type == T_INT || current().type == T_FLOAT ||
       current().type == T_STRING || current().type == T_BOOL_TYPE ||
       current().type == T_BYTES || current().type == T_OBJECT ||
       current().type == T_ARRAY) {
-    std::string type_name = current().value;
+    std::string type_name(current().value);
     advance();
     return type_name;
   }
@@ -154,17 +54,17 @@ std::string Parser::parse_type_name() {
       SourceLocation(current().line, 0));
 }
 
-std::vector<std::shared_ptr<AstNode>> Parser::parse_program() {
+std::vector<AstNode *> Parser::parse_program() {
   has_package_decl = false;
   package_name.clear();
   has_return_zero = false;
   pending_routes.clear();
 
-  std::vector<std::shared_ptr<AstNode>> nodes;
-  size_t last_pos = pos;
+  std::vector<AstNode *> nodes;
+  size_t last_pos = tokens.position();
   size_t iterations = 0;
   while (!is_eof()) {
-    if (pos == last_pos) {
+    if (tokens.position() == last_pos) {
       iterations++;
       if (iterations > 1000) {
         if (DEBUG)
@@ -176,7 +76,7 @@ std::vector<std::shared_ptr<AstNode>> Parser::parse_program() {
     } else {
       iterations = 0;
     }
-    last_pos = pos;
+    last_pos = tokens.position();
 
     if (current().type == T_PACKAGE) {
       int package_line = current().line;
@@ -204,53 +104,48 @@ std::vector<std::shared_ptr<AstNode>> Parser::parse_program() {
       auto func = parse_function();
       if (func)
         nodes.push_back(func);
-    } else if (current().type == T_IDENTIFIER && pos + 1 < tokens.size() &&
-               tokens[pos + 1].type == T_PLUS) {
+    } else if (current().type == T_IDENTIFIER && peek(1).type == T_PLUS) {
       auto var = parse_var_decl();
       if (var)
         nodes.push_back(var);
     } else if (current().type == T_RETURN) {
-      size_t save_pos = pos;
-      advance();
-      if (!is_eof() && current().type == T_NUMBER && current().value == "0") {
+      if (peek(1).type == T_NUMBER && peek(1).value == "0") {
         has_return_zero = true;
       }
-      pos = save_pos;
       advance();
     } else {
       auto stmt = parse_statement();
       if (stmt) {
-        if (auto net_op = std::dynamic_pointer_cast<NetOp>(stmt)) {
+        if (auto net_op = node_cast<NetOp>(stmt)) {
           if ((net_op->method == "get" || net_op->method == "post") &&
               !net_op->data && !net_op->path && !net_op->port &&
               current().type == T_FUNCTION) {
-            if (auto lit = std::dynamic_pointer_cast<Literal>(net_op->url)) {
-              if (lit->value.type == ValueType::STRING &&
-                  lit->value.str_val.rfind("/", 0) == 0) {
+            if (auto lit = node_cast<Literal>(net_op->url)) {
+              if (lit->value.type() == ValueType::STRING &&
+                  lit->value.str_val().rfind("/", 0) == 0) {
                 pending_routes.push_back(
                     {net_op->method == "post" ? "POST" : "GET",
-                     lit->value.str_val, net_op->location});
+                     lit->value.str_val(), net_op->location});
                 continue;
               }
             }
           }
           if (net_op->method == "route" && !net_op->data && !net_op->port &&
               current().type == T_FUNCTION) {
-            if (auto path_lit =
-                    std::dynamic_pointer_cast<Literal>(net_op->url)) {
+            if (auto path_lit = node_cast<Literal>(net_op->url)) {
               std::string route_method = "GET";
               if (net_op->path) {
-                if (auto method_lit =
-                        std::dynamic_pointer_cast<Literal>(net_op->path)) {
-                  if (method_lit->value.type == ValueType::STRING) {
-                    route_method = method_lit->value.str_val;
+                if (auto method_lit = node_cast<Literal>(net_op->path)) {
+                  if (method_lit->value.type() == ValueType::STRING) {
+                    route_method = method_lit->value.str_val();
                   }
                 }
               }
-              if (path_lit->value.type == ValueType::STRING &&
-                  path_lit->value.str_val.rfind("/", 0) == 0) {
-                pending_routes.push_back(
-                    {route_method, path_lit->value.str_val, net_op->location});
+              if (path_lit->value.type() == ValueType::STRING &&
+                  path_lit->value.str_val().rfind("/", 0) == 0) {
+                pending_routes.push_back({route_method,
+                                          path_lit->value.str_val(),
+                                          net_op->location});
                 continue;
               }
             }
@@ -265,7 +160,7 @@ std::vector<std::shared_ptr<AstNode>> Parser::parse_program() {
   return nodes;
 }
 
-std::shared_ptr<ClassDef> Parser::parse_class() {
+ClassDef *Parser::parse_class() {
   int class_line = current().line;
   advance();
 
@@ -274,7 +169,7 @@ std::shared_ptr<ClassDef> Parser::parse_class() {
                       SourceLocation(class_line, 0));
   }
 
-  auto klass = std::make_shared<ClassDef>();
+  auto klass = arena.make<ClassDef>();
   klass->location = SourceLocation(class_line, 0);
   klass->name = current().value;
   advance();
@@ -336,7 +231,7 @@ OrmField Parser::parse_orm_field() {
                           "'",
                       SourceLocation(current().line, 0));
   }
-  std::string column_call = current().value;
+  std::string column_call(current().value);
   if (column_call != "db.Column" && column_call != "orm.Column") {
     throw SyntaxError("Expected db.Column(...) for ORM field '" + field.name +
                           "'",
@@ -360,7 +255,7 @@ OrmField Parser::parse_orm_field() {
   if (current().type == T_LPAREN) {
     advance();
     if (current().type == T_NUMBER) {
-      field.size = std::stoi(current().value);
+      field.size = std::stoi(std::string(current().value));
       advance();
     }
     if (current().type != T_RPAREN) {
@@ -376,7 +271,7 @@ OrmField Parser::parse_orm_field() {
       continue;
     }
     if (current().type == T_NUMBER) {
-      field.size = std::stoi(current().value);
+      field.size = std::stoi(std::string(current().value));
       advance();
       continue;
     }
@@ -404,14 +299,14 @@ OrmField Parser::parse_orm_field() {
   return field;
 }
 
-std::shared_ptr<FunctionDef> Parser::parse_function() {
+FunctionDef *Parser::parse_function() {
   advance();
   advance();
 
-  std::string name = current().value;
+  std::string name(current().value);
   advance();
 
-  auto func = std::make_shared<FunctionDef>();
+  auto func = arena.make<FunctionDef>();
   func->name = name;
   func->routes = pending_routes;
   pending_routes.clear();
@@ -420,10 +315,10 @@ std::shared_ptr<FunctionDef> Parser::parse_function() {
     advance();
 
   while (!is_eof() && current().type == T_IDENTIFIER) {
-    if (pos + 1 >= tokens.size() || tokens[pos + 1].type != T_PLUS)
+    if (peek(1).type != T_PLUS)
       break;
 
-    std::string param_name = current().value;
+    std::string param_name(current().value);
     advance();
     advance();
     std::string param_type = parse_type_name();
@@ -440,9 +335,9 @@ std::shared_ptr<FunctionDef> Parser::parse_function() {
   advance();
 
   size_t iterations = 0;
-  size_t last_pos = pos;
+  size_t last_pos = tokens.position();
   while (!is_eof() && current().type != T_RBRACE) {
-    if (pos == last_pos) {
+    if (tokens.position() == last_pos) {
       iterations++;
       if (iterations > 100) {
         if (DEBUG)
@@ -457,14 +352,15 @@ std::shared_ptr<FunctionDef> Parser::parse_function() {
     } else {
       iterations = 0;
     }
-    last_pos = pos;
+    last_pos = tokens.position();
 
-    size_t start_pos = pos;
+    size_t start_pos = tokens.position();
     try {
       auto stmt = parse_statement();
-      if (auto ret = std::dynamic_pointer_cast<ReturnStmt>(stmt)) {
-        if (auto lit = std::dynamic_pointer_cast<Literal>(ret->expr)) {
-          if (lit->value.type == ValueType::INT && lit->value.int_val == 1) {
+      if (auto ret = node_cast<ReturnStmt>(stmt)) {
+        if (auto lit = node_cast<Literal>(ret->expr)) {
+          if (lit->value.type() == ValueType::INT &&
+              lit->value.int_val() == 1) {
             func->has_return_one = true;
           }
         }
@@ -472,8 +368,8 @@ std::shared_ptr<FunctionDef> Parser::parse_function() {
       if (stmt) {
         func->body.push_back(stmt);
       } else {
-        if (pos == start_pos) {
-          std::string token_val = current().value;
+        if (tokens.position() == start_pos) {
+          std::string token_val(current().value);
           if (current().type == T_IDENTIFIER &&
               (token_val.find("write") != std::string::npos ||
                token_val.find("create") != std::string::npos ||
@@ -485,8 +381,9 @@ std::shared_ptr<FunctionDef> Parser::parse_function() {
                                   "'close', or 'delete'?",
                               SourceLocation(current().line, 0));
           }
-          throw SyntaxError("Unexpected token: '" + current().value +
-                                "' at line " + std::to_string(current().line),
+          throw SyntaxError("Unexpected token: '" +
+                                std::string(current().value) + "' at line " +
+                                std::to_string(current().line),
                             SourceLocation(current().line, 0));
         } else {
         }
@@ -510,7 +407,7 @@ std::shared_ptr<FunctionDef> Parser::parse_function() {
   return func;
 }
 
-std::shared_ptr<AstNode> Parser::parse_statement() {
+AstNode *Parser::parse_statement() {
   if (current().type == T_COUT) {
     return parse_input();
   }
@@ -527,25 +424,21 @@ std::shared_ptr<AstNode> Parser::parse_statement() {
   if ((current().type == T_CREATE || current().type == T_WRITE ||
        current().type == T_READ || current().type == T_CLOSE ||
        current().type == T_DELETE) &&
-      pos + 1 < tokens.size() && tokens[pos + 1].type == T_COLON_COLON &&
-      pos + 2 < tokens.size() && tokens[pos + 2].type == T_FILE) {
+      peek(1).type == T_COLON_COLON && peek(2).type == T_FILE) {
     return parse_file_op();
   }
   if (current().type == T_IDENTIFIER &&
       (current().value == "net" || current().value == "web") &&
-      pos + 1 < tokens.size() && tokens[pos + 1].type == T_COLON_COLON) {
+      peek(1).type == T_COLON_COLON) {
     return parse_net_op();
   }
-  if (is_namespaced_builtin_root(current()) && pos + 1 < tokens.size() &&
-      tokens[pos + 1].type == T_COLON_COLON) {
+  if (is_namespaced_builtin_root(current()) && peek(1).type == T_COLON_COLON) {
     return parse_namespaced_builtin_call_expr();
   }
-  if (current().type == T_IDENTIFIER && pos + 1 < tokens.size() &&
-      tokens[pos + 1].type == T_PLUS) {
+  if (current().type == T_IDENTIFIER && peek(1).type == T_PLUS) {
     return parse_var_decl();
   }
-  if (current().type == T_IDENTIFIER && pos + 1 < tokens.size() &&
-      tokens[pos + 1].type == T_LPAREN) {
+  if (current().type == T_IDENTIFIER && peek(1).type == T_LPAREN) {
     return parse_function_call();
   }
   if (current().type == T_CALL)
@@ -553,7 +446,7 @@ std::shared_ptr<AstNode> Parser::parse_statement() {
   if (current().type == T_RETURN) {
     int return_line = current().line;
     advance();
-    auto ret = std::make_shared<ReturnStmt>();
+    auto ret = arena.make<ReturnStmt>();
     ret->location = SourceLocation(return_line, 0);
     if (!is_eof() && current().type != T_RBRACE) {
       ret->expr = parse_expr();
@@ -563,10 +456,10 @@ std::shared_ptr<AstNode> Parser::parse_statement() {
   return nullptr;
 }
 
-std::shared_ptr<VarDecl> Parser::parse_var_decl() {
-  auto decl = std::make_shared<VarDecl>();
+VarDecl *Parser::parse_var_decl() {
+  auto decl = arena.make<VarDecl>();
   decl->location = SourceLocation(current().line, 0);
-  std::string name = current().value;
+  std::string name(current().value);
   advance();
   advance();
   std::string type_name = parse_type_name();
@@ -578,9 +471,9 @@ std::shared_ptr<VarDecl> Parser::parse_var_decl() {
   return decl;
 }
 
-std::shared_ptr<AstNode> Parser::parse_expr() { return parse_comparison(); }
+AstNode *Parser::parse_expr() { return parse_comparison(); }
 
-std::shared_ptr<AstNode> Parser::parse_comparison() {
+AstNode *Parser::parse_comparison() {
   auto node = parse_add_sub();
   while (!is_eof() &&
          (current().type == T_GREATER || current().type == T_LESS ||
@@ -590,7 +483,7 @@ std::shared_ptr<AstNode> Parser::parse_comparison() {
     TokenType op = current().type;
     advance();
     auto right = parse_add_sub();
-    auto bin = std::make_shared<BinaryOp>();
+    auto bin = arena.make<BinaryOp>();
     bin->location = SourceLocation(op_line, 0);
     bin->op = op;
     bin->left = node;
@@ -600,14 +493,14 @@ std::shared_ptr<AstNode> Parser::parse_comparison() {
   return node;
 }
 
-std::shared_ptr<AstNode> Parser::parse_add_sub() {
+AstNode *Parser::parse_add_sub() {
   auto node = parse_mul_div();
   while (!is_eof() && (current().type == T_PLUS || current().type == T_MINUS)) {
     int op_line = current().line;
     TokenType op = current().type;
     advance();
     auto right = parse_mul_div();
-    auto bin = std::make_shared<BinaryOp>();
+    auto bin = arena.make<BinaryOp>();
     bin->location = SourceLocation(op_line, 0);
     bin->op = op;
     bin->left = node;
@@ -617,14 +510,14 @@ std::shared_ptr<AstNode> Parser::parse_add_sub() {
   return node;
 }
 
-std::shared_ptr<AstNode> Parser::parse_mul_div() {
+AstNode *Parser::parse_mul_div() {
   auto node = parse_primary();
   while (!is_eof() && (current().type == T_STAR || current().type == T_SLASH)) {
     int op_line = current().line;
     TokenType op = current().type;
     advance();
     auto right = parse_primary();
-    auto bin = std::make_shared<BinaryOp>();
+    auto bin = arena.make<BinaryOp>();
     bin->location = SourceLocation(op_line, 0);
     bin->op = op;
     bin->left = node;
@@ -634,21 +527,22 @@ std::shared_ptr<AstNode> Parser::parse_mul_div() {
   return node;
 }
 
-std::shared_ptr<BuiltinCallExpr> Parser::parse_builtin_call_expr() {
+BuiltinCallExpr *Parser::parse_builtin_call_expr() {
   int call_line = current().line;
-  std::string name = current().value;
+  std::string name(current().value);
   advance();
 
   if (current().type != T_LPAREN) {
     throw SyntaxError("Expected '(' after builtin '" + name +
-                          "', got: " + current().value,
+                          "', got: " + std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
 
-  auto call = std::make_shared<BuiltinCallExpr>();
+  auto call = arena.make<BuiltinCallExpr>();
   call->location = SourceLocation(call_line, 0);
   call->name = name;
+  call->builtin = find_builtin(name);
 
   if (current().type != T_RPAREN) {
     call->args.push_back(parse_expr());
@@ -660,7 +554,7 @@ std::shared_ptr<BuiltinCallExpr> Parser::parse_builtin_call_expr() {
 
   if (is_eof() || current().type != T_RPAREN) {
     throw SyntaxError("Expected ')' after builtin call arguments, got: " +
-                          current().value,
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
@@ -668,42 +562,45 @@ std::shared_ptr<BuiltinCallExpr> Parser::parse_builtin_call_expr() {
   return call;
 }
 
-std::shared_ptr<BuiltinCallExpr> Parser::parse_namespaced_builtin_call_expr() {
+BuiltinCallExpr *Parser::parse_namespaced_builtin_call_expr() {
   int call_line = current().line;
-  std::string namespace_name = current().value;
+  std::string namespace_name(current().value);
   advance();
 
   if (current().type != T_COLON_COLON) {
     throw SyntaxError("Expected '::' after namespace '" + namespace_name +
-                          "', got: " + current().value,
+                          "', got: " + std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
 
   if (!is_namespaced_builtin_member(current())) {
     throw SyntaxError("Expected builtin name after '" + namespace_name +
-                          "::', got: " + current().value,
+                          "::', got: " + std::string(current().value),
                       SourceLocation(current().line, 0));
   }
 
-  std::string builtin_name = namespace_name + "::" + current().value;
+  std::string builtin_name =
+      namespace_name + "::" + std::string(current().value);
   advance();
 
-  if (!is_builtin_call_name(builtin_name)) {
+  const BuiltinInfo *builtin = find_builtin(builtin_name);
+  if (!builtin) {
     throw SyntaxError("Unknown builtin call: '" + builtin_name + "'",
                       SourceLocation(call_line, 0));
   }
 
   if (current().type != T_LPAREN) {
     throw SyntaxError("Expected '(' after builtin '" + builtin_name +
-                          "', got: " + current().value,
+                          "', got: " + std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
 
-  auto call = std::make_shared<BuiltinCallExpr>();
+  auto call = arena.make<BuiltinCallExpr>();
   call->location = SourceLocation(call_line, 0);
   call->name = builtin_name;
+  call->builtin = builtin;
 
   if (current().type != T_RPAREN) {
     call->args.push_back(parse_expr());
@@ -715,7 +612,7 @@ std::shared_ptr<BuiltinCallExpr> Parser::parse_namespaced_builtin_call_expr() {
 
   if (is_eof() || current().type != T_RPAREN) {
     throw SyntaxError("Expected ')' after builtin call arguments, got: " +
-                          current().value,
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
@@ -723,14 +620,14 @@ std::shared_ptr<BuiltinCallExpr> Parser::parse_namespaced_builtin_call_expr() {
   return call;
 }
 
-std::shared_ptr<AstNode> Parser::parse_primary() {
+AstNode *Parser::parse_primary() {
   if (is_eof())
     return nullptr;
   if (current().type == T_NUMBER) {
-    std::string num_str = current().value;
+    std::string num_str(current().value);
     int line = current().line;
     advance();
-    auto lit = std::make_shared<Literal>();
+    auto lit = arena.make<Literal>();
     lit->location = SourceLocation(line, 0);
     if (num_str.find('.') != std::string::npos) {
       lit->value = Value(std::stod(num_str));
@@ -740,29 +637,28 @@ std::shared_ptr<AstNode> Parser::parse_primary() {
     return lit;
   }
   if (current().type == T_STRING_LITERAL) {
-    auto lit = std::make_shared<Literal>();
+    auto lit = arena.make<Literal>();
     lit->location = SourceLocation(current().line, 0);
-    lit->value = Value(current().value);
+    lit->value = Value(std::string(current().value));
     advance();
     return lit;
   }
   if (current().type == T_TRUE || current().type == T_FALSE) {
-    auto lit = std::make_shared<Literal>();
+    auto lit = arena.make<Literal>();
     lit->location = SourceLocation(current().line, 0);
     lit->value = Value::Bool(current().type == T_TRUE);
     advance();
     return lit;
   }
-  if (current().type == T_IDENTIFIER && is_builtin_call_name(current().value) &&
-      pos + 1 < tokens.size() && tokens[pos + 1].type == T_LPAREN) {
+  if (current().type == T_IDENTIFIER && peek(1).type == T_LPAREN &&
+      find_builtin(current().value)) {
     return parse_builtin_call_expr();
   }
-  if (is_namespaced_builtin_root(current()) && pos + 1 < tokens.size() &&
-      tokens[pos + 1].type == T_COLON_COLON) {
+  if (is_namespaced_builtin_root(current()) && peek(1).type == T_COLON_COLON) {
     return parse_namespaced_builtin_call_expr();
   }
   if (current().type == T_IDENTIFIER || current().type == T_INPUT) {
-    auto id = std::make_shared<Identifier>();
+    auto id = arena.make<Identifier>();
     id->location = SourceLocation(current().line, 0);
     id->name = current().value;
     advance();
@@ -771,8 +667,8 @@ std::shared_ptr<AstNode> Parser::parse_primary() {
   return nullptr;
 }
 
-std::shared_ptr<PrintStmt> Parser::parse_print() {
-  auto p = std::make_shared<PrintStmt>();
+PrintStmt *Parser::parse_print() {
+  auto p = arena.make<PrintStmt>();
   p->location = SourceLocation(current().line, 0);
   TokenType print_type = current().type;
   bool is_printg = (print_type == T_PRINTG);
@@ -826,7 +722,7 @@ std::shared_ptr<PrintStmt> Parser::parse_print() {
   }
   if (current().type != T_RPAREN) {
     throw SyntaxError("Expected ')' after print arguments, got: " +
-                          current().value,
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
@@ -836,11 +732,11 @@ std::shared_ptr<PrintStmt> Parser::parse_print() {
   return p;
 }
 
-std::shared_ptr<InputStmt> Parser::parse_input() {
+InputStmt *Parser::parse_input() {
   advance();
   advance();
 
-  auto input = std::make_shared<InputStmt>();
+  auto input = arena.make<InputStmt>();
 
   if (current().type == T_INPUT) {
     input->var_name = "input";
@@ -862,7 +758,7 @@ std::shared_ptr<InputStmt> Parser::parse_input() {
   return input;
 }
 
-std::shared_ptr<CallStmt> Parser::parse_call() {
+CallStmt *Parser::parse_call() {
   int call_line = current().line;
   advance();
   advance();
@@ -876,9 +772,10 @@ std::shared_ptr<CallStmt> Parser::parse_call() {
     advance();
   }
 
-  auto call = std::make_shared<CallStmt>();
+  auto call = arena.make<CallStmt>();
   call->location = SourceLocation(call_line, 0);
   call->func_name = name;
+  call->builtin = find_statement_builtin(name);
 
   if (current().type == T_COMMA) {
     advance();
@@ -890,22 +787,23 @@ std::shared_ptr<CallStmt> Parser::parse_call() {
   }
   if (is_eof() || current().type != T_RPAREN) {
     throw SyntaxError("Expected ')' after function call arguments, got: " +
-                          current().value,
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
   return call;
 }
 
-std::shared_ptr<CallStmt> Parser::parse_function_call() {
+CallStmt *Parser::parse_function_call() {
   int call_line = current().line;
-  std::string name = current().value;
+  std::string name(current().value);
   advance();
   advance();
 
-  auto call = std::make_shared<CallStmt>();
+  auto call = arena.make<CallStmt>();
   call->location = SourceLocation(call_line, 0);
   call->func_name = name;
+  call->builtin = find_statement_builtin(name);
 
   if (current().type != T_RPAREN) {
     call->args.push_back(parse_expr());
@@ -918,7 +816,7 @@ std::shared_ptr<CallStmt> Parser::parse_function_call() {
   return call;
 }
 
-std::shared_ptr<ImportStmt> Parser::parse_import() {
+ImportStmt *Parser::parse_import() {
   int import_line = current().line;
   advance();
 
@@ -940,7 +838,7 @@ std::shared_ptr<ImportStmt> Parser::parse_import() {
   }
   advance();
 
-  auto import = std::make_shared<ImportStmt>();
+  auto import = arena.make<ImportStmt>();
   import->location = SourceLocation(import_line, 0);
   import->file_path = file_path;
 
@@ -983,31 +881,33 @@ std::shared_ptr<ImportStmt> Parser::parse_import() {
   return import;
 }
 
-std::shared_ptr<FileOp> Parser::parse_file_op() {
+FileOp *Parser::parse_file_op() {
   int op_line = current().line;
   TokenType operation = current().type;
   advance();
 
   if (current().type != T_COLON_COLON) {
     throw SyntaxError("Expected '::' after file operation, got: " +
-                          current().value,
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
 
   if (current().type != T_FILE) {
-    throw SyntaxError("Expected 'file' after '::', got: " + current().value,
+    throw SyntaxError("Expected 'file' after '::', got: " +
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
 
   if (current().type != T_LPAREN) {
-    throw SyntaxError("Expected '(' after 'file', got: " + current().value,
+    throw SyntaxError("Expected '(' after 'file', got: " +
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
 
-  auto file_op = std::make_shared<FileOp>();
+  auto file_op = arena.make<FileOp>();
   file_op->location = SourceLocation(op_line, 0);
   file_op->operation = operation;
   file_op->data = nullptr;
@@ -1041,7 +941,7 @@ std::shared_ptr<FileOp> Parser::parse_file_op() {
 
   if (is_eof() || current().type != T_RPAREN) {
     throw SyntaxError("Expected ')' after file operation arguments, got: " +
-                          current().value,
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
@@ -1049,24 +949,25 @@ std::shared_ptr<FileOp> Parser::parse_file_op() {
   return file_op;
 }
 
-std::shared_ptr<NetOp> Parser::parse_net_op() {
+NetOp *Parser::parse_net_op() {
   int op_line = current().line;
-  std::string namespace_name = current().value;
+  std::string namespace_name(current().value);
   advance();
 
   if (current().type != T_COLON_COLON) {
     throw SyntaxError("Expected '::' after '" + namespace_name +
-                          "', got: " + current().value,
+                          "', got: " + std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
 
   if (current().type != T_IDENTIFIER) {
     throw SyntaxError("Expected network method or transport after '" +
-                          namespace_name + "::', got: " + current().value,
+                          namespace_name + "::', got: " +
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
-  std::string first_part = current().value;
+  std::string first_part(current().value);
   advance();
 
   std::string transport;
@@ -1077,7 +978,7 @@ std::shared_ptr<NetOp> Parser::parse_net_op() {
 
     if (current().type != T_IDENTIFIER) {
       throw SyntaxError("Expected network method after transport, got: " +
-                            current().value,
+                            std::string(current().value),
                         SourceLocation(current().line, 0));
     }
     method = current().value;
@@ -1089,12 +990,12 @@ std::shared_ptr<NetOp> Parser::parse_net_op() {
 
   if (current().type != T_LPAREN) {
     throw SyntaxError("Expected '(' after network method, got: " +
-                          current().value,
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
 
-  auto net_op = std::make_shared<NetOp>();
+  auto net_op = arena.make<NetOp>();
   net_op->location = SourceLocation(op_line, 0);
   net_op->transport = transport;
   net_op->method = method;
@@ -1105,7 +1006,7 @@ std::shared_ptr<NetOp> Parser::parse_net_op() {
   net_op->url = parse_expr();
   if (!net_op->url) {
     throw SyntaxError("Expected URL in network operation, got: " +
-                          current().value,
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
 
@@ -1147,6 +1048,15 @@ std::shared_ptr<NetOp> Parser::parse_net_op() {
                           SourceLocation(current().line, 0));
       }
     }
+    if (current().type == T_COMMA) {
+      advance();
+      net_op->workers = parse_expr();
+      if (!net_op->workers) {
+        throw SyntaxError("Expected worker count in " + namespace_name +
+                              "::" + method,
+                          SourceLocation(current().line, 0));
+      }
+    }
   } else if ((method == "get" || method == "post") &&
              current().type == T_COMMA) {
     advance();
@@ -1155,7 +1065,7 @@ std::shared_ptr<NetOp> Parser::parse_net_op() {
 
   if (is_eof() || current().type != T_RPAREN) {
     throw SyntaxError("Expected ')' after network operation arguments, got: " +
-                          current().value,
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
@@ -1163,11 +1073,12 @@ std::shared_ptr<NetOp> Parser::parse_net_op() {
   return net_op;
 }
 
-std::shared_ptr<IfStmt> Parser::parse_if() {
+IfStmt *Parser::parse_if() {
   int if_line = current().line;
   advance();
   if (current().type != T_LPAREN) {
-    throw SyntaxError("Expected '(' after 'if', got: " + current().value,
+    throw SyntaxError("Expected '(' after 'if', got: " +
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
@@ -1176,28 +1087,28 @@ std::shared_ptr<IfStmt> Parser::parse_if() {
 
   if (current().type != T_RPAREN) {
     throw SyntaxError("Expected ')' after if condition, got: " +
-                          current().value,
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
 
   if (current().type != T_LBRACE) {
     throw SyntaxError("Expected '{' after if condition, got: " +
-                          current().value,
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
 
-  auto if_stmt = std::make_shared<IfStmt>();
+  auto if_stmt = arena.make<IfStmt>();
   if_stmt->location = SourceLocation(if_line, 0);
   if_stmt->condition = condition;
 
   while (!is_eof() && current().type != T_RBRACE) {
-    size_t start_pos = pos;
+    size_t start_pos = tokens.position();
     auto stmt = parse_statement();
     if (stmt) {
       if_stmt->then_body.push_back(stmt);
-    } else if (pos == start_pos) {
+    } else if (tokens.position() == start_pos) {
       advance();
     }
   }
@@ -1215,11 +1126,11 @@ std::shared_ptr<IfStmt> Parser::parse_if() {
     if (current().type == T_LBRACE) {
       advance();
       while (!is_eof() && current().type != T_RBRACE) {
-        size_t start_pos = pos;
+        size_t start_pos = tokens.position();
         auto stmt = parse_statement();
         if (stmt) {
           if_stmt->else_body.push_back(stmt);
-        } else if (pos == start_pos) {
+        } else if (tokens.position() == start_pos) {
           advance();
         }
       }
@@ -1236,11 +1147,11 @@ std::shared_ptr<IfStmt> Parser::parse_if() {
   return if_stmt;
 }
 
-std::shared_ptr<WhileStmt> Parser::parse_while() {
+WhileStmt *Parser::parse_while() {
   int while_line = current().line;
   advance();
 
-  std::shared_ptr<AstNode> condition;
+  AstNode *condition;
   bool has_parentheses = false;
 
   if (current().type == T_LPAREN) {
@@ -1251,14 +1162,14 @@ std::shared_ptr<WhileStmt> Parser::parse_while() {
   condition = parse_expr();
   if (!condition) {
     throw SyntaxError("Expected condition after 'while', got: " +
-                          current().value,
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
 
   if (has_parentheses) {
     if (current().type != T_RPAREN) {
       throw SyntaxError("Expected ')' after while condition, got: " +
-                            current().value,
+                            std::string(current().value),
                         SourceLocation(current().line, 0));
     }
     advance();
@@ -1266,21 +1177,21 @@ std::shared_ptr<WhileStmt> Parser::parse_while() {
 
   if (current().type != T_LBRACE) {
     throw SyntaxError("Expected '{' after while condition, got: " +
-                          current().value,
+                          std::string(current().value),
                       SourceLocation(current().line, 0));
   }
   advance();
 
-  auto while_stmt = std::make_shared<WhileStmt>();
+  auto while_stmt = arena.make<WhileStmt>();
   while_stmt->location = SourceLocation(while_line, 0);
   while_stmt->condition = condition;
 
   while (!is_eof() && current().type != T_RBRACE) {
-    size_t start_pos = pos;
+    size_t start_pos = tokens.position();
     auto stmt = parse_statement();
     if (stmt) {
       while_stmt->body.push_back(stmt);
-    } else if (pos == start_pos) {
+    } else if (tokens.position() == start_pos) {
       advance();
     }
   }
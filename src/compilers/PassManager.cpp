@@ -0,0 +1,343 @@
+#include "../include/optimizer/PassManager.h"
+#include "../include/interpreter/Interpreter.h"
+#include "../include/token/AstVisitor.h"
+#include "../include/utils/Utils.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+namespace {
+std::string assigned_name(const AstNode &stmt) {
+  switch (stmt.kind) {
+  case NodeKind::VAR_DECL:
+    return static_cast<const VarDecl &>(stmt).name;
+  case NodeKind::INPUT: {
+    auto &input = static_cast<const InputStmt &>(stmt);
+    return input.var_name.empty() ? "input" : input.var_name;
+  }
+  default:
+    return "";
+  }
+}
+
+// Names written anywhere in body, and whether it runs PGT functions that may
+// write globals (direct calls, or web handlers started by a net operation).
+void collect_effects(const std::vector<AstNode *> &body,
+                     std::set<std::string> &assigned, bool &calls) {
+  for (const auto &stmt : body) {
+    std::string name = assigned_name(*stmt);
+    if (!name.empty()) {
+      assigned.insert(name);
+    }
+    if (auto call = node_cast<CallStmt>(stmt)) {
+      calls = calls || !call->builtin;
+    } else if (stmt->kind == NodeKind::NET_OP) {
+      calls = true;
+    }
+    for_each_block(*stmt, [&](std::vector<AstNode *> &nested) {
+      collect_effects(nested, assigned, calls);
+    });
+  }
+}
+
+// The name a top-level function or model is reached by, or null for any other
+// statement.
+const std::string *definition_name(const AstNode &node) {
+  if (auto func = node_cast<FunctionDef>(&node)) {
+    return &func->name;
+  }
+  if (auto klass = node_cast<ClassDef>(&node)) {
+    return &klass->name;
+  }
+  return nullptr;
+}
+} // namespace
+
+void ConstantFoldingPass::fold_expr(AstNode *&expr) {
+  if (auto bin = node_cast<BinaryOp>(expr)) {
+    fold_expr(bin->left);
+    fold_expr(bin->right);
+    auto left = node_cast<Literal>(bin->left);
+    auto right = node_cast<Literal>(bin->right);
+    if (left && right) {
+      auto lit = arena.make<Literal>();
+      lit->location = bin->location;
+      lit->value = Interpreter::binary_op(bin->op, left->value, right->value);
+      expr = lit;
+    }
+  } else if (auto builtin = node_cast<BuiltinCallExpr>(expr)) {
+    for (auto &arg : builtin->args) {
+      fold_expr(arg);
+    }
+  }
+}
+
+void ConstantFoldingPass::fold_block(std::vector<AstNode *> &body) {
+  for (auto &stmt : body) {
+    for_each_operand(*stmt, [this](AstNode *&expr) { fold_expr(expr); });
+    for_each_block(*stmt, [this](std::vector<AstNode *> &block) {
+      fold_block(block);
+    });
+  }
+}
+
+void ConstantFoldingPass::run(std::vector<AstNode *> &program) {
+  fold_block(program);
+}
+
+void BranchPruningPass::prune_block(std::vector<AstNode *> &body) {
+  std::vector<AstNode *> pruned;
+  pruned.reserve(body.size());
+  for (auto &stmt : body) {
+    for_each_block(*stmt, [this](std::vector<AstNode *> &block) {
+      prune_block(block);
+    });
+    if (auto if_stmt = node_cast<IfStmt>(stmt)) {
+      if (auto cond = node_cast<Literal>(if_stmt->condition)) {
+        const auto &taken = Interpreter::is_truthy(cond->value)
+                                ? if_stmt->then_body
+                                : if_stmt->else_body;
+        pruned.insert(pruned.end(), taken.begin(), taken.end());
+        continue;
+      }
+    }
+    if (auto loop = node_cast<WhileStmt>(stmt)) {
+      auto cond = node_cast<Literal>(loop->condition);
+      if (cond && !Interpreter::is_truthy(cond->value)) {
+        continue;
+      }
+    }
+    pruned.push_back(stmt);
+  }
+  body.swap(pruned);
+}
+
+void BranchPruningPass::run(std::vector<AstNode *> &program) {
+  for (auto &node : program) {
+    for_each_block(*node, [this](std::vector<AstNode *> &body) {
+      prune_block(body);
+    });
+  }
+}
+
+bool LoopInvariantHoistingPass::is_invariant(
+    AstNode *expr, const std::set<std::string> &stable) const {
+  // The parser leaves an operand null for input such as `x = + 1`.
+  if (!expr) {
+    return false;
+  }
+  switch (expr->kind) {
+  case NodeKind::LITERAL:
+    return true;
+  case NodeKind::IDENTIFIER:
+    return stable.count(static_cast<Identifier *>(expr)->name) > 0;
+  case NodeKind::BINARY_OP: {
+    auto bin = static_cast<BinaryOp *>(expr);
+    return is_invariant(bin->left, stable) && is_invariant(bin->right, stable);
+  }
+  default:
+    return false;
+  }
+}
+
+void LoopInvariantHoistingPass::hoist_expr(
+    AstNode *&expr, const std::set<std::string> &stable,
+    std::vector<AstNode *> &hoisted) {
+  if (auto bin = node_cast<BinaryOp>(expr)) {
+    if (!is_invariant(expr, stable)) {
+      hoist_expr(bin->left, stable, hoisted);
+      hoist_expr(bin->right, stable, hoisted);
+      return;
+    }
+    // Temporaries use a name no PGT identifier can spell and no declared
+    // type, so the VM stores the value unconverted.
+    auto temp = arena.make<VarDecl>();
+    temp->location = bin->location;
+    temp->name = "$licm" + std::to_string(next_temp++);
+    temp->expr = expr;
+    hoisted.push_back(temp);
+
+    auto id = arena.make<Identifier>();
+    id->location = bin->location;
+    id->name = temp->name;
+    expr = id;
+  } else if (auto builtin = node_cast<BuiltinCallExpr>(expr)) {
+    for (auto &arg : builtin->args) {
+      hoist_expr(arg, stable, hoisted);
+    }
+  }
+}
+
+void LoopInvariantHoistingPass::hoist_loop(
+    WhileStmt &loop, const std::set<std::string> &defined,
+    std::vector<AstNode *> &hoisted) {
+  hoist_block(loop.body, defined);
+
+  std::set<std::string> assigned;
+  bool calls = false;
+  collect_effects(loop.body, assigned, calls);
+
+  // A name is stable when it is readable before the loop starts and nothing
+  // in the loop can write it. Any PGT call may write a global.
+  std::set<std::string> stable;
+  for (const auto &name : defined) {
+    if (!assigned.count(name) && !(calls && global_names.count(name))) {
+      stable.insert(name);
+    }
+  }
+  if (!calls) {
+    for (const auto &name : global_names) {
+      if (!assigned.count(name)) {
+        stable.insert(name);
+      }
+    }
+  }
+
+  hoist_expr(loop.condition, stable, hoisted);
+  std::vector<std::vector<AstNode *> *> blocks = {&loop.body};
+  while (!blocks.empty()) {
+    auto *block = blocks.back();
+    blocks.pop_back();
+    for (auto &stmt : *block) {
+      for_each_operand(*stmt, [&](AstNode *&expr) {
+        hoist_expr(expr, stable, hoisted);
+      });
+      for_each_block(*stmt, [&](std::vector<AstNode *> &inner) {
+        blocks.push_back(&inner);
+      });
+    }
+  }
+}
+
+void LoopInvariantHoistingPass::hoist_block(std::vector<AstNode *> &body,
+                                            std::set<std::string> defined) {
+  std::vector<AstNode *> result;
+  result.reserve(body.size());
+  for (auto &stmt : body) {
+    if (auto loop = node_cast<WhileStmt>(stmt)) {
+      std::vector<AstNode *> hoisted;
+      hoist_loop(*loop, defined, hoisted);
+      for (const auto &temp : hoisted) {
+        defined.insert(assigned_name(*temp));
+      }
+      result.insert(result.end(), hoisted.begin(), hoisted.end());
+    } else if (auto if_stmt = node_cast<IfStmt>(stmt)) {
+      hoist_block(if_stmt->then_body, defined);
+      hoist_block(if_stmt->else_body, defined);
+    }
+    result.push_back(stmt);
+    std::string name = assigned_name(*stmt);
+    if (!name.empty()) {
+      defined.insert(name);
+    }
+  }
+  body.swap(result);
+}
+
+void LoopInvariantHoistingPass::run(std::vector<AstNode *> &program) {
+  global_names.clear();
+  for (const auto &node : program) {
+    if (auto decl = node_cast<VarDecl>(node)) {
+      global_names.insert(decl->name);
+    }
+  }
+  for (auto &node : program) {
+    if (auto func = node_cast<FunctionDef>(node)) {
+      hoist_block(func->body, std::set<std::string>(func->param_names.begin(),
+                                                    func->param_names.end()));
+    }
+  }
+}
+
+void TreeShakingPass::reach(const std::string &name) {
+  if (reached.insert(name).second) {
+    pending.push_back(name);
+  }
+}
+
+void TreeShakingPass::scan(AstNode *node) {
+  if (!node) {
+    return;
+  }
+  if (auto call = node_cast<CallStmt>(node)) {
+    if (!call->builtin) {
+      reach(call->func_name);
+    }
+  } else if (auto ident = node_cast<Identifier>(node)) {
+    reach(ident->name);
+  } else if (auto lit = node_cast<Literal>(node)) {
+    if (lit->value.type() == ValueType::STRING) {
+      reach(lit->value.str_val());
+    }
+  }
+  for_each_operand(*node, [&](AstNode *&operand) { scan(operand); });
+  for_each_block(*node, [&](std::vector<AstNode *> &body) {
+    for (const auto &stmt : body) {
+      scan(stmt);
+    }
+  });
+}
+
+void TreeShakingPass::run(std::vector<AstNode *> &program) {
+  reached.clear();
+  pending.clear();
+  std::multimap<std::string, AstNode *> definitions;
+  for (const auto &node : program) {
+    if (auto func = node_cast<FunctionDef>(node)) {
+      definitions.emplace(func->name, node);
+      if (func->name == "main" || !func->routes.empty()) {
+        reach(func->name);
+      }
+    } else if (auto klass = node_cast<ClassDef>(node)) {
+      definitions.emplace(klass->name, node);
+    } else {
+      scan(node);
+    }
+  }
+
+  while (!pending.empty()) {
+    std::string name = std::move(pending.back());
+    pending.pop_back();
+    auto [first, last] = definitions.equal_range(name);
+    for (auto it = first; it != last; ++it) {
+      if (auto func = node_cast<FunctionDef>(it->second)) {
+        scan(func);
+      } else if (auto klass = node_cast<ClassDef>(it->second)) {
+        reach(klass->base);
+      }
+    }
+  }
+
+  size_t before = program.size();
+  auto unreached = [&](AstNode *node) {
+    const std::string *name = definition_name(*node);
+    return name && !reached.count(*name);
+  };
+  program.erase(std::remove_if(program.begin(), program.end(), unreached),
+                program.end());
+  if (DEBUG)
+    std::cout << "[DEBUG] Tree shaking dropped " << before - program.size()
+              << " definitions" << std::endl;
+}
+
+PassManager::PassManager(AstArena &arena, int opt_level) {
+  if (opt_level >= 1) {
+    add_pass(std::make_unique<ConstantFoldingPass>(arena));
+    add_pass(std::make_unique<BranchPruningPass>());
+  }
+  if (opt_level >= 2) {
+    add_pass(std::make_unique<LoopInvariantHoistingPass>(arena));
+  }
+}
+
+void PassManager::add_pass(std::unique_ptr<AstPass> pass) {
+  passes.push_back(std::move(pass));
+}
+
+void PassManager::run(std::vector<AstNode *> &program) {
+  for (const auto &pass : passes) {
+    if (DEBUG)
+      std::cout << "[DEBUG] Running pass " << pass->name() << std::endl;
+    pass->run(program);
+  }
+}
@@ -0,0 +1,142 @@
+#include "../include/vm/Resolver.h"
+#include "../include/token/AstVisitor.h"
+
+namespace {
+const char *const request_locals[] = {"request_method", "request_path",
+                                      "request_body"};
+
+bool is_request_local(const std::string &name) {
+  for (const char *request_local : request_locals) {
+    if (name == request_local) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename Fn> void for_each_child(AstNode &node, Fn &&fn) {
+  for_each_operand(node, fn);
+  for_each_block(node, [&](std::vector<AstNode *> &body) {
+    for (auto *stmt : body) {
+      fn(stmt);
+    }
+  });
+}
+} // namespace
+
+int Resolver::local_slot(const std::string &name) {
+  auto it = local_slots.find(name);
+  if (it != local_slots.end()) {
+    return it->second;
+  }
+  int slot = static_cast<int>(local_slots.size());
+  local_slots[name] = slot;
+  return slot;
+}
+
+void Resolver::declare_assignment(const std::string &name) {
+  if (!global_slots.count(name)) {
+    local_slot(name);
+  }
+}
+
+void Resolver::collect(AstNode *node) {
+  if (!node) {
+    return;
+  }
+  for_each_child(*node, [this](AstNode *child) { collect(child); });
+  switch (node->kind) {
+  case NodeKind::VAR_DECL:
+    declare_assignment(static_cast<VarDecl *>(node)->name);
+    break;
+  case NodeKind::INPUT: {
+    auto input = static_cast<InputStmt *>(node);
+    declare_assignment(input->var_name.empty() ? "input" : input->var_name);
+    break;
+  }
+  case NodeKind::IDENTIFIER: {
+    auto id = static_cast<Identifier *>(node);
+    if (is_request_local(id->name)) {
+      local_slot(id->name);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void Resolver::annotate_name(const std::string &name, int &slot,
+                             bool &is_global) {
+  auto global = global_slots.find(name);
+  if (global != global_slots.end()) {
+    slot = global->second;
+    is_global = true;
+    return;
+  }
+  slot = local_slot(name);
+  is_global = false;
+}
+
+void Resolver::annotate(AstNode *node) {
+  if (!node) {
+    return;
+  }
+  for_each_child(*node, [this](AstNode *child) { annotate(child); });
+  switch (node->kind) {
+  case NodeKind::VAR_DECL: {
+    auto decl = static_cast<VarDecl *>(node);
+    annotate_name(decl->name, decl->slot, decl->is_global);
+    break;
+  }
+  case NodeKind::INPUT: {
+    auto input = static_cast<InputStmt *>(node);
+    annotate_name(input->var_name.empty() ? "input" : input->var_name,
+                  input->slot, input->is_global);
+    break;
+  }
+  case NodeKind::IDENTIFIER: {
+    auto id = static_cast<Identifier *>(node);
+    auto local = local_slots.find(id->name);
+    auto global = global_slots.find(id->name);
+    id->slot = local != local_slots.end() ? local->second : -1;
+    id->global_slot = global != global_slots.end() ? global->second : -1;
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void Resolver::resolve_global(VarDecl &decl) {
+  local_slots.clear();
+  annotate(decl.expr);
+  auto it = global_slots.find(decl.name);
+  if (it == global_slots.end()) {
+    it = global_slots.emplace(decl.name, static_cast<int>(global_names.size()))
+             .first;
+    global_names.push_back(decl.name);
+  }
+  decl.slot = it->second;
+  decl.is_global = true;
+}
+
+void Resolver::resolve_function(FunctionDef &func) {
+  local_slots.clear();
+  func.param_slots.clear();
+  for (const auto &param : func.param_names) {
+    func.param_slots.push_back(local_slot(param));
+  }
+  for (const auto &stmt : func.body) {
+    collect(stmt);
+  }
+  for (const auto &stmt : func.body) {
+    annotate(stmt);
+  }
+  func.request_slots.clear();
+  for (const char *request_local : request_locals) {
+    auto it = local_slots.find(request_local);
+    func.request_slots.push_back(it != local_slots.end() ? it->second : -1);
+  }
+  func.frame_size = static_cast<int>(local_slots.size());
+}
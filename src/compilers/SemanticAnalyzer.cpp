@@ -2,44 +2,6 @@
 #include <iostream>
 
 namespace {
-bool is_log_builtin_name(const std::string &name) {
-  return name == "log" || name == "log_output" || name == "set_log_output" ||
-         name == "log_console" || name == "log_file" || name == "log::output" ||
-         name == "log::set_output" || name == "log::console" ||
-         name == "log::file" || name == "log::trace" || name == "log::debug" ||
-         name == "log::info" || name == "log::notice" || name == "log::warn" ||
-         name == "log::warning" || name == "log::error" ||
-         name == "log::critical" || name == "log::critecal" ||
-         name == "log::fatal" || name == "log_trace" || name == "log_debug" ||
-         name == "log_info" || name == "log_notice" || name == "log_warn" ||
-         name == "log_warning" || name == "log_error" ||
-         name == "log_critical" || name == "log_critecal" ||
-         name == "log_fatal";
-}
-
-bool is_log_config_builtin_name(const std::string &name) {
-  return name == "log_output" || name == "set_log_output" ||
-         name == "log_console" || name == "log_file" || name == "log::output" ||
-         name == "log::set_output" || name == "log::console" ||
-         name == "log::file";
-}
-
-bool is_json_builtin_name(const std::string &name) {
-  return name.rfind("json::", 0) == 0;
-}
-
-bool is_sql_builtin_name(const std::string &name) {
-  return name.rfind("sql::", 0) == 0 || name.rfind("orm::", 0) == 0;
-}
-
-bool is_request_builtin_name(const std::string &name) {
-  return name.rfind("request::", 0) == 0;
-}
-
-bool is_auth_builtin_name(const std::string &name) {
-  return name.rfind("auth::", 0) == 0 || name.rfind("jwt::", 0) == 0;
-}
-
 bool is_string_like(VarType type) {
   return type == VarType::STRING || type == VarType::BYTES ||
          type == VarType::UNKNOWN;
@@ -47,7 +9,7 @@ bool is_string_like(VarType type) {
 } // namespace
 
 VarType SemanticAnalyzer::get_value_type(const Value &val) {
-  switch (val.type) {
+  switch (val.type()) {
   case ValueType::INT:
     return VarType::INT;
   case ValueType::FLOAT:
@@ -132,326 +94,44 @@ bool SemanticAnalyzer::is_assignable(VarType expected, VarType actual) {
   return false;
 }
 
-VarType
-SemanticAnalyzer::infer_expr_type(const std::shared_ptr<AstNode> &node) {
-  if (auto lit = std::dynamic_pointer_cast<Literal>(node)) {
-    return get_value_type(lit->value);
+VarType SemanticAnalyzer::infer_expr_type(AstNode *node) {
+  if (!node) {
+    return VarType::UNKNOWN;
   }
-  if (auto builtin = std::dynamic_pointer_cast<BuiltinCallExpr>(node)) {
-    if (builtin->name == "read::file") {
-      if (builtin->args.size() != 1) {
-        throw SemanticError("Builtin 'read::file' expects 1 argument",
-                            builtin->location);
-      }
-      VarType arg_type = infer_expr_type(builtin->args[0]);
-      if (!is_string_like(arg_type)) {
-        throw TypeError("Builtin 'read::file' expects a string path",
-                        builtin->location);
-      }
-      return VarType::STRING;
-    }
-    if (is_request_builtin_name(builtin->name)) {
-      if (!builtin->args.empty()) {
-        throw SemanticError("Builtin '" + builtin->name +
-                                "' expects 0 arguments",
-                            builtin->location);
-      }
-      if (builtin->name == "request::json") {
-        return VarType::OBJECT;
-      }
-      return VarType::STRING;
-    }
-    if (is_json_builtin_name(builtin->name)) {
-      if (builtin->name == "json::parse" || builtin->name == "json::decode" ||
-          builtin->name == "json::unmarshal" || builtin->name == "json::read") {
-        if (builtin->args.size() != 1) {
-          throw SemanticError("Builtin '" + builtin->name +
-                                  "' expects 1 argument",
-                              builtin->location);
-        }
-        VarType arg_type = infer_expr_type(builtin->args[0]);
-        if (!is_string_like(arg_type)) {
-          throw TypeError("Builtin '" + builtin->name +
-                              "' expects a string argument",
-                          builtin->location);
-        }
-        return VarType::OBJECT;
-      }
-      if (builtin->name == "json::stringify" ||
-          builtin->name == "json::encode" || builtin->name == "json::marshal") {
-        if (builtin->args.size() != 1) {
-          throw SemanticError("Builtin '" + builtin->name +
-                                  "' expects 1 argument",
-                              builtin->location);
-        }
-        analyze_expr(builtin->args[0]);
-        return VarType::STRING;
-      }
-      if (builtin->name == "json::write" || builtin->name == "json::save") {
-        if (builtin->args.size() != 2) {
-          throw SemanticError("Builtin '" + builtin->name +
-                                  "' expects path and value",
-                              builtin->location);
-        }
-        VarType path_type = infer_expr_type(builtin->args[0]);
-        if (!is_string_like(path_type)) {
-          throw TypeError("JSON file path must be a string", builtin->location);
-        }
-        analyze_expr(builtin->args[1]);
-        return VarType::BOOL;
-      }
-      if (builtin->name == "json::object") {
-        if (builtin->args.size() % 2 != 0) {
-          throw SemanticError("Builtin 'json::object' expects key/value pairs",
-                              builtin->location);
-        }
-        for (size_t i = 0; i < builtin->args.size(); i += 2) {
-          VarType key_type = infer_expr_type(builtin->args[i]);
-          if (!is_string_like(key_type)) {
-            throw TypeError("JSON object keys must be strings",
-                            builtin->location);
-          }
-          analyze_expr(builtin->args[i + 1]);
-        }
-        return VarType::OBJECT;
-      }
-      if (builtin->name == "json::get") {
-        if (builtin->args.size() != 2) {
-          throw SemanticError("Builtin 'json::get' expects object and key",
-                              builtin->location);
-        }
-        analyze_expr(builtin->args[0]);
-        VarType key_type = infer_expr_type(builtin->args[1]);
-        if (!is_string_like(key_type)) {
-          throw TypeError("JSON object key must be a string",
+  switch (node->kind) {
+  case NodeKind::LITERAL:
+    return get_value_type(static_cast<Literal *>(node)->value);
+  case NodeKind::BUILTIN_CALL: {
+    auto builtin = static_cast<BuiltinCallExpr *>(node);
+    if (!builtin->builtin) {
+      throw SemanticError("Unknown builtin expression: '" + builtin->name +
+                              "'",
                           builtin->location);
-        }
-        return VarType::UNKNOWN;
-      }
     }
-    if (is_sql_builtin_name(builtin->name)) {
-      if (builtin->name == "sql::open" || builtin->name == "sql::connect" ||
-          builtin->name == "sql::exec" || builtin->name == "orm::migrate") {
-        if (builtin->args.size() != 1) {
-          throw SemanticError("Builtin '" + builtin->name +
-                                  "' expects 1 argument",
+    return infer_builtin_type(*builtin->builtin, builtin->name, builtin->args,
                               builtin->location);
-        }
-        VarType arg_type = infer_expr_type(builtin->args[0]);
-        if (!is_string_like(arg_type)) {
-          throw TypeError("Builtin '" + builtin->name +
-                              "' expects a string argument",
-                          builtin->location);
-        }
-        return builtin->name == "sql::exec" || builtin->name == "orm::migrate"
-                   ? VarType::STRING
-                   : VarType::BOOL;
-      }
-      if (builtin->name == "sql::table" || builtin->name == "orm::table" ||
-          builtin->name == "sql::insert" || builtin->name == "orm::save") {
-        if (builtin->args.size() != 2) {
-          throw SemanticError("Builtin '" + builtin->name +
-                                  "' expects 2 arguments",
-                              builtin->location);
-        }
-        VarType table_type = infer_expr_type(builtin->args[0]);
-        if (!is_string_like(table_type)) {
-          throw TypeError("SQL table name must be a string", builtin->location);
-        }
-        analyze_expr(builtin->args[1]);
-        return VarType::STRING;
-      }
-      if (builtin->name == "orm::find" || builtin->name == "sql::find") {
-        if (builtin->args.size() != 3) {
-          throw SemanticError("Builtin '" + builtin->name +
-                                  "' expects 3 arguments",
-                              builtin->location);
-        }
-        VarType table_type = infer_expr_type(builtin->args[0]);
-        VarType field_type = infer_expr_type(builtin->args[1]);
-        if (!is_string_like(table_type) || !is_string_like(field_type)) {
-          throw TypeError("SQL table and field names must be strings",
-                          builtin->location);
-        }
-        analyze_expr(builtin->args[2]);
-        return VarType::OBJECT;
-      }
-    }
-    if (is_auth_builtin_name(builtin->name)) {
-      if (builtin->name == "auth::hash_password") {
-        if (builtin->args.size() != 1) {
-          throw SemanticError(
-              "Builtin 'auth::hash_password' expects 1 argument",
-              builtin->location);
-        }
-        VarType arg_type = infer_expr_type(builtin->args[0]);
-        if (!is_string_like(arg_type)) {
-          throw TypeError("Password must be a string", builtin->location);
-        }
-        return VarType::STRING;
-      }
-      if (builtin->name == "auth::verify_password" ||
-          builtin->name == "jwt::verify") {
-        if (builtin->args.size() != 2) {
-          throw SemanticError("Builtin '" + builtin->name +
-                                  "' expects 2 arguments",
-                              builtin->location);
-        }
-        for (const auto &arg : builtin->args) {
-          VarType arg_type = infer_expr_type(arg);
-          if (!is_string_like(arg_type)) {
-            throw TypeError("Builtin '" + builtin->name +
-                                "' expects string arguments",
-                            builtin->location);
-          }
-        }
-        return VarType::BOOL;
-      }
-      if (builtin->name == "jwt::sign") {
-        if (builtin->args.size() != 2) {
-          throw SemanticError("Builtin 'jwt::sign' expects payload and secret",
-                              builtin->location);
-        }
-        analyze_expr(builtin->args[0]);
-        VarType secret_type = infer_expr_type(builtin->args[1]);
-        if (!is_string_like(secret_type)) {
-          throw TypeError("JWT secret must be a string", builtin->location);
-        }
-        return VarType::STRING;
-      }
-    }
-    if (is_log_config_builtin_name(builtin->name)) {
-      if (builtin->name == "log_console" || builtin->name == "log::console") {
-        if (!builtin->args.empty()) {
-          throw SemanticError("Builtin 'log_console' expects 0 arguments",
-                              builtin->location);
-        }
-        return VarType::BOOL;
-      }
-      if (builtin->args.size() != 1) {
-        throw SemanticError("Builtin '" + builtin->name +
-                                "' expects 1 argument",
-                            builtin->location);
-      }
-      VarType arg_type = infer_expr_type(builtin->args[0]);
-      if (arg_type != VarType::STRING && arg_type != VarType::BYTES &&
-          arg_type != VarType::UNKNOWN) {
-        throw TypeError("Builtin '" + builtin->name +
-                            "' expects a string argument",
-                        builtin->location);
-      }
-      return VarType::BOOL;
-    }
-    if (is_log_builtin_name(builtin->name)) {
-      if (builtin->args.empty()) {
-        throw SemanticError("Builtin '" + builtin->name +
-                                "' expects at least 1 argument",
-                            builtin->location);
-      }
-      if (builtin->name == "log" && builtin->args.size() > 1) {
-        VarType first_type = infer_expr_type(builtin->args[0]);
-        VarType last_type = infer_expr_type(builtin->args.back());
-        bool first_can_be_level = first_type == VarType::STRING ||
-                                  first_type == VarType::BYTES ||
-                                  first_type == VarType::UNKNOWN;
-        bool last_can_be_level = last_type == VarType::STRING ||
-                                 last_type == VarType::BYTES ||
-                                 last_type == VarType::UNKNOWN;
-        if (!first_can_be_level && !last_can_be_level) {
-          throw TypeError(
-              "Builtin 'log' level must be a string as first or last argument",
-              builtin->location);
-        }
-      }
-      for (const auto &arg : builtin->args) {
-        analyze_expr(arg);
-      }
-      return VarType::BOOL;
-    }
-    if (builtin->name == "protocol") {
-      if (builtin->args.size() != 1) {
-        throw SemanticError("Builtin 'protocol' expects 1 argument",
-                            builtin->location);
-      }
-      VarType arg_type = infer_expr_type(builtin->args[0]);
-      if (arg_type != VarType::STRING && arg_type != VarType::UNKNOWN) {
-        throw TypeError("Builtin 'protocol' expects a string URL",
-                        builtin->location);
-      }
-      return VarType::STRING;
-    }
-    if (builtin->name == "json_parse") {
-      if (builtin->args.size() != 1) {
-        throw SemanticError("Builtin 'json_parse' expects 1 argument",
-                            builtin->location);
-      }
-      VarType arg_type = infer_expr_type(builtin->args[0]);
-      if (arg_type != VarType::STRING && arg_type != VarType::UNKNOWN) {
-        throw TypeError("Builtin 'json_parse' expects a string",
-                        builtin->location);
-      }
-      return VarType::OBJECT;
-    }
-    if (builtin->name == "json_stringify") {
-      if (builtin->args.size() != 1) {
-        throw SemanticError("Builtin 'json_stringify' expects 1 argument",
-                            builtin->location);
-      }
-      return VarType::STRING;
-    }
-    if (builtin->name == "read_file") {
-      if (builtin->args.size() != 1) {
-        throw SemanticError("Builtin 'read_file' expects 1 argument",
-                            builtin->location);
-      }
-      VarType arg_type = infer_expr_type(builtin->args[0]);
-      if (arg_type != VarType::STRING && arg_type != VarType::UNKNOWN) {
-        throw TypeError("Builtin 'read_file' expects a string path",
-                        builtin->location);
-      }
-      return VarType::STRING;
-    }
-    if (builtin->name == "open_log") {
-      if (builtin->args.size() != 1) {
-        throw SemanticError("Builtin 'open_log' expects 1 argument",
-                            builtin->location);
-      }
-      VarType arg_type = infer_expr_type(builtin->args[0]);
-      if (arg_type != VarType::STRING && arg_type != VarType::UNKNOWN) {
-        throw TypeError("Builtin 'open_log' expects a string path",
-                        builtin->location);
-      }
-      return VarType::BOOL;
-    }
-    if (builtin->name == "request_method" || builtin->name == "request_path" ||
-        builtin->name == "request_body") {
-      if (!builtin->args.empty()) {
-        throw SemanticError("Builtin '" + builtin->name +
-                                "' expects 0 arguments",
-                            builtin->location);
-      }
-      return VarType::STRING;
-    }
-    if (builtin->name == "request_json") {
-      if (!builtin->args.empty()) {
-        throw SemanticError("Builtin 'request_json' expects 0 arguments",
-                            builtin->location);
-      }
-      return VarType::OBJECT;
-    }
-    throw SemanticError("Unknown builtin expression: '" + builtin->name + "'",
-                        builtin->location);
   }
-  if (auto id = std::dynamic_pointer_cast<Identifier>(node)) {
-    auto *var = find_variable(id->name);
+  case NodeKind::IDENTIFIER: {
+    auto *var = find_variable(static_cast<Identifier *>(node)->name);
     if (var) {
       return var->type;
     }
     return VarType::UNKNOWN;
   }
-  if (auto bin = std::dynamic_pointer_cast<BinaryOp>(node)) {
+  case NodeKind::BINARY_OP: {
+    auto bin = static_cast<BinaryOp *>(node);
     VarType left_type = infer_expr_type(bin->left);
     VarType right_type = infer_expr_type(bin->right);
+    bool left_numeric =
+        left_type == VarType::INT || left_type == VarType::FLOAT;
+    bool right_numeric =
+        right_type == VarType::INT || right_type == VarType::FLOAT;
+    if (left_numeric && right_numeric) {
+      bin->operand_type =
+          left_type == VarType::INT && right_type == VarType::INT
+              ? ValueType::INT
+              : ValueType::FLOAT;
+    }
 
     if (bin->op == T_PLUS || bin->op == T_MINUS || bin->op == T_STAR ||
         bin->op == T_SLASH) {
@@ -482,6 +162,148 @@ SemanticAnalyzer::infer_expr_type(const std::shared_ptr<AstNode> &node) {
         bin->op == T_LESS_EQUAL) {
       return VarType::INT;
     }
+    break;
+  }
+  default:
+    break;
+  }
+  return VarType::UNKNOWN;
+}
+
+void SemanticAnalyzer::expect_string_arg(AstNode *arg,
+                                         const std::string &message,
+                                         const SourceLocation &loc) {
+  if (!is_string_like(infer_expr_type(arg))) {
+    throw TypeError(message, loc);
+  }
+}
+
+VarType SemanticAnalyzer::infer_builtin_type(
+    const BuiltinInfo &builtin, const std::string &name,
+    const std::vector<AstNode *> &args, const SourceLocation &loc) {
+  int argc = static_cast<int>(args.size());
+  if (argc < builtin.min_args ||
+      (builtin.max_args >= 0 && argc > builtin.max_args)) {
+    throw SemanticError("Builtin '" + name + "' expects " + builtin.arity,
+                        loc);
+  }
+
+  switch (builtin.id) {
+  case BuiltinId::PROTOCOL:
+    expect_string_arg(args[0], "Builtin '" + name + "' expects a string URL",
+                      loc);
+    return VarType::STRING;
+  case BuiltinId::READ_FILE:
+    expect_string_arg(args[0], "Builtin '" + name + "' expects a string path",
+                      loc);
+    return VarType::STRING;
+  case BuiltinId::OPEN_LOG:
+    expect_string_arg(args[0], "Builtin '" + name + "' expects a string path",
+                      loc);
+    return VarType::BOOL;
+
+  case BuiltinId::REQUEST_METHOD:
+  case BuiltinId::REQUEST_PATH:
+  case BuiltinId::REQUEST_BODY:
+    return VarType::STRING;
+  case BuiltinId::REQUEST_JSON:
+    return VarType::OBJECT;
+  case BuiltinId::REQUEST_QUERY:
+  case BuiltinId::REQUEST_HEADER:
+  case BuiltinId::REQUEST_PARAM:
+    for (AstNode *arg : args) {
+      expect_string_arg(arg, "Builtin '" + name + "' expects a string name",
+                        loc);
+    }
+    return VarType::STRING;
+
+  case BuiltinId::JSON_PARSE:
+  case BuiltinId::JSON_READ:
+    expect_string_arg(args[0],
+                      "Builtin '" + name + "' expects a string argument", loc);
+    return VarType::OBJECT;
+  case BuiltinId::JSON_STRINGIFY:
+    analyze_expr(args[0]);
+    return VarType::STRING;
+  case BuiltinId::JSON_WRITE:
+    expect_string_arg(args[0], "JSON file path must be a string", loc);
+    analyze_expr(args[1]);
+    return VarType::BOOL;
+  case BuiltinId::JSON_GET:
+    analyze_expr(args[0]);
+    expect_string_arg(args[1], "JSON object key must be a string", loc);
+    return VarType::UNKNOWN;
+  case BuiltinId::JSON_OBJECT:
+    if (args.size() % 2 != 0) {
+      throw SemanticError("Builtin '" + name + "' expects key/value pairs",
+                          loc);
+    }
+    for (size_t i = 0; i < args.size(); i += 2) {
+      expect_string_arg(args[i], "JSON object keys must be strings", loc);
+      analyze_expr(args[i + 1]);
+    }
+    return VarType::OBJECT;
+
+  case BuiltinId::AUTH_HASH_PASSWORD:
+    expect_string_arg(args[0], "Password must be a string", loc);
+    return VarType::STRING;
+  case BuiltinId::AUTH_VERIFY_PASSWORD:
+  case BuiltinId::JWT_VERIFY:
+    for (const auto &arg : args) {
+      expect_string_arg(arg, "Builtin '" + name + "' expects string arguments",
+                        loc);
+    }
+    return VarType::BOOL;
+  case BuiltinId::JWT_SIGN:
+    analyze_expr(args[0]);
+    expect_string_arg(args[1], "JWT secret must be a string", loc);
+    return VarType::STRING;
+
+  case BuiltinId::SQL_OPEN:
+  case BuiltinId::SQL_EXEC:
+  case BuiltinId::ORM_MIGRATE:
+    expect_string_arg(args[0],
+                      "Builtin '" + name + "' expects a string argument", loc);
+    return builtin.id == BuiltinId::SQL_OPEN ? VarType::BOOL : VarType::STRING;
+  case BuiltinId::SQL_TABLE:
+  case BuiltinId::SQL_INSERT:
+    expect_string_arg(args[0], "SQL table name must be a string", loc);
+    analyze_expr(args[1]);
+    return VarType::STRING;
+  case BuiltinId::SQL_FIND:
+    expect_string_arg(args[0], "SQL table and field names must be strings",
+                      loc);
+    expect_string_arg(args[1], "SQL table and field names must be strings",
+                      loc);
+    analyze_expr(args[2]);
+    return VarType::OBJECT;
+
+  case BuiltinId::LOG_OUTPUT:
+  case BuiltinId::LOG_FILE:
+    expect_string_arg(args[0],
+                      "Builtin '" + name + "' expects a string argument", loc);
+    return VarType::BOOL;
+  case BuiltinId::LOG_CONSOLE:
+    return VarType::BOOL;
+  case BuiltinId::LOG:
+    if (args.size() > 1 && !is_string_like(infer_expr_type(args[0])) &&
+        !is_string_like(infer_expr_type(args.back()))) {
+      throw TypeError(
+          "Builtin 'log' level must be a string as first or last argument",
+          loc);
+    }
+    [[fallthrough]];
+  case BuiltinId::LOG_TRACE:
+  case BuiltinId::LOG_DEBUG:
+  case BuiltinId::LOG_INFO:
+  case BuiltinId::LOG_NOTICE:
+  case BuiltinId::LOG_WARN:
+  case BuiltinId::LOG_ERROR:
+  case BuiltinId::LOG_CRITICAL:
+    for (const auto &arg : args) {
+      analyze_expr(arg);
+    }
+    return VarType::BOOL;
   }
   return VarType::UNKNOWN;
 }
@@ -529,10 +351,9 @@ VariableInfo *SemanticAnalyzer::find_variable(const std::string &name) {
   return nullptr;
 }
 
-void SemanticAnalyzer::analyze_program(
-    const std::vector<std::shared_ptr<AstNode>> &program) {
+void SemanticAnalyzer::analyze_program(const std::vector<AstNode *> &program) {
   for (const auto &node : program) {
-    if (auto func = std::dynamic_pointer_cast<FunctionDef>(node)) {
+    if (auto func = node_cast<FunctionDef>(node)) {
       if (functions.count(func->name)) {
         throw SemanticError("Function '" + func->name + "' already declared",
                             func->location);
@@ -551,16 +372,15 @@ void SemanticAnalyzer::analyze_program(
   }
 
   for (const auto &node : program) {
-    if (auto func = std::dynamic_pointer_cast<FunctionDef>(node)) {
+    if (auto func = node_cast<FunctionDef>(node)) {
       analyze_function(func);
-    } else if (auto var = std::dynamic_pointer_cast<VarDecl>(node)) {
+    } else if (auto var = node_cast<VarDecl>(node)) {
       analyze_var_decl(var);
     }
   }
 }
 
-void SemanticAnalyzer::analyze_function(
-    const std::shared_ptr<FunctionDef> &func) {
+void SemanticAnalyzer::analyze_function(FunctionDef *func) {
   if (!functions.count(func->name)) {
     throw SemanticError("Function '" + func->name + "' not registered",
                         func->location);
@@ -575,9 +395,9 @@ void SemanticAnalyzer::analyze_function(
   }
 
   for (const auto &stmt : func->body) {
-    if (auto input = std::dynamic_pointer_cast<InputStmt>(stmt)) {
+    if (auto input = node_cast<InputStmt>(stmt)) {
       analyze_input(input);
-    } else if (auto decl = std::dynamic_pointer_cast<VarDecl>(stmt)) {
+    } else if (auto decl = node_cast<VarDecl>(stmt)) {
       declare_variable(decl->name, type_from_name(decl->type_name),
                        decl->location);
     }
@@ -590,31 +410,44 @@ void SemanticAnalyzer::analyze_function(
   exit_scope();
 }
 
-void SemanticAnalyzer::analyze_statement(const std::shared_ptr<AstNode> &stmt) {
-  if (auto decl = std::dynamic_pointer_cast<VarDecl>(stmt)) {
-    analyze_var_decl(decl);
-  } else if (auto print = std::dynamic_pointer_cast<PrintStmt>(stmt)) {
-    analyze_print(print);
-  } else if (auto input = std::dynamic_pointer_cast<InputStmt>(stmt)) {
-    analyze_input(input);
-  } else if (auto if_stmt = std::dynamic_pointer_cast<IfStmt>(stmt)) {
-    analyze_if(if_stmt);
-  } else if (auto while_stmt = std::dynamic_pointer_cast<WhileStmt>(stmt)) {
-    analyze_while(while_stmt);
-  } else if (auto call = std::dynamic_pointer_cast<CallStmt>(stmt)) {
-    analyze_call(call);
-  } else if (auto ret = std::dynamic_pointer_cast<ReturnStmt>(stmt)) {
-    analyze_return(ret);
-  } else if (auto builtin = std::dynamic_pointer_cast<BuiltinCallExpr>(stmt)) {
-    analyze_expr(builtin);
-  } else if (auto net_op = std::dynamic_pointer_cast<NetOp>(stmt)) {
-    analyze_net_op(net_op);
-  } else if (auto file_op = std::dynamic_pointer_cast<FileOp>(stmt)) {
-    analyze_file_op(file_op);
+void SemanticAnalyzer::analyze_statement(AstNode *stmt) {
+  switch (stmt->kind) {
+  case NodeKind::VAR_DECL:
+    analyze_var_decl(static_cast<VarDecl *>(stmt));
+    break;
+  case NodeKind::PRINT:
+    analyze_print(static_cast<PrintStmt *>(stmt));
+    break;
+  case NodeKind::INPUT:
+    analyze_input(static_cast<InputStmt *>(stmt));
+    break;
+  case NodeKind::IF:
+    analyze_if(static_cast<IfStmt *>(stmt));
+    break;
+  case NodeKind::WHILE:
+    analyze_while(static_cast<WhileStmt *>(stmt));
+    break;
+  case NodeKind::CALL:
+    analyze_call(static_cast<CallStmt *>(stmt));
+    break;
+  case NodeKind::RETURN:
+    analyze_return(static_cast<ReturnStmt *>(stmt));
+    break;
+  case NodeKind::BUILTIN_CALL:
+    analyze_expr(stmt);
+    break;
+  case NodeKind::NET_OP:
+    analyze_net_op(static_cast<NetOp *>(stmt));
+    break;
+  case NodeKind::FILE_OP:
+    analyze_file_op(static_cast<FileOp *>(stmt));
+    break;
+  default:
+    break;
   }
 }
 
-void SemanticAnalyzer::analyze_var_decl(const std::shared_ptr<VarDecl> &decl) {
+void SemanticAnalyzer::analyze_var_decl(VarDecl *decl) {
   try {
     VarType expr_type = infer_expr_type(decl->expr);
     VarType declared_type = type_from_name(decl->type_name);
@@ -643,20 +476,20 @@ void SemanticAnalyzer::analyze_var_decl(const std::shared_ptr<VarDecl> &decl) {
   }
 }
 
-void SemanticAnalyzer::analyze_expr(const std::shared_ptr<AstNode> &expr) {
+void SemanticAnalyzer::analyze_expr(AstNode *expr) {
   try {
     infer_expr_type(expr);
   } catch (const UndefinedError &) {
   }
 }
 
-void SemanticAnalyzer::analyze_print(const std::shared_ptr<PrintStmt> &print) {
+void SemanticAnalyzer::analyze_print(PrintStmt *print) {
   for (const auto &arg : print->args) {
     analyze_expr(arg);
   }
 }
 
-void SemanticAnalyzer::analyze_input(const std::shared_ptr<InputStmt> &input) {
+void SemanticAnalyzer::analyze_input(InputStmt *input) {
   std::string var_name = input->var_name.empty() ? "input" : input->var_name;
   VarType var_type = VarType::UNKNOWN;
   if (input->format == "{int}") {
@@ -677,7 +510,7 @@ void SemanticAnalyzer::analyze_input(const std::shared_ptr<InputStmt> &input) {
   }
 }
 
-void SemanticAnalyzer::analyze_if(const std::shared_ptr<IfStmt> &if_stmt) {
+void SemanticAnalyzer::analyze_if(IfStmt *if_stmt) {
   try {
     VarType cond_type = infer_expr_type(if_stmt->condition);
     if (cond_type != VarType::INT && cond_type != VarType::BOOL &&
@@ -703,8 +536,7 @@ void SemanticAnalyzer::analyze_if(const std::shared_ptr<IfStmt> &if_stmt) {
   exit_scope();
 }
 
-void SemanticAnalyzer::analyze_while(
-    const std::shared_ptr<WhileStmt> &while_stmt) {
+void SemanticAnalyzer::analyze_while(WhileStmt *while_stmt) {
   try {
     VarType cond_type = infer_expr_type(while_stmt->condition);
     if (cond_type != VarType::INT && cond_type != VarType::BOOL &&
@@ -724,68 +556,10 @@ void SemanticAnalyzer::analyze_while(
   exit_scope();
 }
 
-void SemanticAnalyzer::analyze_call(const std::shared_ptr<CallStmt> &call) {
-  if (is_log_config_builtin_name(call->func_name)) {
-    if (call->func_name == "log_console" || call->func_name == "log::console") {
-      if (!call->args.empty()) {
-        throw SemanticError("Builtin 'log_console' expects 0 arguments",
-                            call->location);
-      }
-      return;
-    }
-    if (call->args.size() != 1) {
-      throw SemanticError("Builtin '" + call->func_name +
-                              "' expects 1 argument",
-                          call->location);
-    }
-    VarType arg_type = infer_expr_type(call->args[0]);
-    if (arg_type != VarType::STRING && arg_type != VarType::BYTES &&
-        arg_type != VarType::UNKNOWN) {
-      throw TypeError("Builtin '" + call->func_name +
-                          "' expects a string argument",
-                      call->location);
-    }
-    return;
-  }
-
-  if (is_log_builtin_name(call->func_name)) {
-    if (call->args.empty()) {
-      throw SemanticError("Builtin '" + call->func_name +
-                              "' expects at least 1 argument",
-                          call->location);
-    }
-    if (call->func_name == "log" && call->args.size() > 1) {
-      VarType first_type = infer_expr_type(call->args[0]);
-      VarType last_type = infer_expr_type(call->args.back());
-      bool first_can_be_level = first_type == VarType::STRING ||
-                                first_type == VarType::BYTES ||
-                                first_type == VarType::UNKNOWN;
-      bool last_can_be_level = last_type == VarType::STRING ||
-                               last_type == VarType::BYTES ||
-                               last_type == VarType::UNKNOWN;
-      if (!first_can_be_level && !last_can_be_level) {
-        throw TypeError(
-            "Builtin 'log' level must be a string as first or last argument",
-            call->location);
-      }
-    }
-    for (const auto &arg : call->args) {
-      analyze_expr(arg);
-    }
-    return;
-  }
-
-  if (call->func_name == "open_log") {
-    if (call->args.size() != 1) {
-      throw SemanticError("Builtin 'open_log' expects 1 argument",
-                          call->location);
-    }
-    VarType arg_type = infer_expr_type(call->args[0]);
-    if (arg_type != VarType::STRING && arg_type != VarType::BYTES &&
-        arg_type != VarType::UNKNOWN) {
-      throw TypeError("Builtin 'open_log' expects a string path",
-                      call->location);
-    }
+void SemanticAnalyzer::analyze_call(CallStmt *call) {
+  if (call->builtin) {
+    infer_builtin_type(*call->builtin, call->func_name, call->args,
+                       call->location);
     return;
   }
 
@@ -817,13 +591,13 @@ void SemanticAnalyzer::analyze_call(const std::shared_ptr<CallStmt> &call) {
   }
 }
 
-void SemanticAnalyzer::analyze_return(const std::shared_ptr<ReturnStmt> &ret) {
+void SemanticAnalyzer::analyze_return(ReturnStmt *ret) {
   if (ret->expr) {
     analyze_expr(ret->expr);
   }
 }
 
-void SemanticAnalyzer::analyze_net_op(const std::shared_ptr<NetOp> &net_op) {
+void SemanticAnalyzer::analyze_net_op(NetOp *net_op) {
   if (!net_op->transport.empty() && net_op->transport != "http" &&
       net_op->transport != "https") {
     throw SemanticError("Unsupported network transport: '" + net_op->transport +
@@ -881,13 +655,24 @@ void SemanticAnalyzer::analyze_net_op(const std::shared_ptr<NetOp> &net_op) {
     if (net_op->data) {
       analyze_expr(net_op->data);
       VarType data_type = infer_expr_type(net_op->data);
+      // web::run(host, port, workers) passes the worker count in place of
+      // the response body.
+      bool worker_count = !net_op->workers && data_type == VarType::INT;
       if (data_type != VarType::STRING && data_type != VarType::BYTES &&
-          data_type != VarType::UNKNOWN) {
+          data_type != VarType::UNKNOWN && !worker_count) {
         throw TypeError(
             "Network server response body must be a string or bytes",
             net_op->location);
       }
     }
+    if (net_op->workers) {
+      analyze_expr(net_op->workers);
+      VarType workers_type = infer_expr_type(net_op->workers);
+      if (workers_type != VarType::INT && workers_type != VarType::UNKNOWN) {
+        throw TypeError("Network server worker count must be an int",
+                        net_op->location);
+      }
+    }
   } else if (net_op->method == "get" && net_op->data) {
     analyze_expr(net_op->data);
     VarType data_type = infer_expr_type(net_op->data);
@@ -914,7 +699,7 @@ void SemanticAnalyzer::analyze_net_op(const std::shared_ptr<NetOp> &net_op) {
   }
 }
 
-void SemanticAnalyzer::analyze_file_op(const std::shared_ptr<FileOp> &file_op) {
+void SemanticAnalyzer::analyze_file_op(FileOp *file_op) {
   analyze_expr(file_op->file_path);
   if (file_op->operation == T_WRITE && file_op->data) {
     analyze_expr(file_op->data);
@@ -926,7 +711,6 @@ void SemanticAnalyzer::analyze_file_op(const std::shared_ptr<FileOp> &file_op) {
   }
 }
 
-void SemanticAnalyzer::analyze(
-    const std::vector<std::shared_ptr<AstNode>> &program) {
+void SemanticAnalyzer::analyze(const std::vector<AstNode *> &program) {
   analyze_program(program);
 }
@@ -0,0 +1,227 @@
+#include "../include/interpreter/Interpreter.h"
+#include "../include/utils/Error.h"
+#include "../include/utils/Utils.h"
+#include <iostream>
+
+namespace {
+template <typename T> Value numeric_binary(TokenType op, T l, T r) {
+  switch (op) {
+  case T_PLUS:
+    return Value(l + r);
+  case T_MINUS:
+    return Value(l - r);
+  case T_STAR:
+    return Value(l * r);
+  case T_SLASH:
+    return Value(r != 0 ? l / r : T(0));
+  case T_GREATER:
+    return Value(l > r ? 1LL : 0LL);
+  case T_LESS:
+    return Value(l < r ? 1LL : 0LL);
+  case T_GREATER_EQUAL:
+    return Value(l >= r ? 1LL : 0LL);
+  case T_LESS_EQUAL:
+    return Value(l <= r ? 1LL : 0LL);
+  case T_EQUAL_EQUAL:
+    return Value(l == r ? 1LL : 0LL);
+  case T_NOT_EQUAL:
+    return Value(l != r ? 1LL : 0LL);
+  default:
+    return Value();
+  }
+}
+
+bool is_number(ValueType type) {
+  return type == ValueType::INT || type == ValueType::FLOAT;
+}
+
+double as_double(const Value &value) {
+  return value.type() == ValueType::FLOAT
+             ? value.float_val()
+             : static_cast<double>(value.int_val());
+}
+} // namespace
+
+ExecStatus Interpreter::run_chunk(const Chunk &chunk, size_t base,
+                                  Value &result) {
+  Value *slots = frame_stack.data() + base;
+  unsigned char *slot_set = frame_set.data() + base;
+  Value *stack = slots + chunk.frame_size;
+  size_t sp = 0;
+  const Instruction *code = chunk.code.data();
+  size_t pc = 0;
+
+  for (;;) {
+    const Instruction &ins = code[pc++];
+    switch (ins.op) {
+    case OpCode::CONST:
+      stack[sp++] = chunk.constants[ins.a];
+      break;
+
+    case OpCode::LOAD_LOCAL:
+      if (slot_set[ins.a]) {
+        stack[sp++] = slots[ins.a];
+        break;
+      }
+      if (ins.b >= 0) {
+        stack[sp++] = globals[ins.b];
+        break;
+      }
+      [[fallthrough]];
+    case OpCode::LOAD_NAME: {
+      UndefinedError err(static_cast<const Identifier *>(ins.node)->name,
+                         "variable", ins.node->location);
+      err.traceback = call_stack;
+      throw err;
+    }
+
+    case OpCode::LOAD_GLOBAL:
+      stack[sp++] = globals[ins.a];
+      break;
+
+    case OpCode::STORE_LOCAL:
+    case OpCode::STORE_GLOBAL: {
+      bool is_global = ins.op == OpCode::STORE_GLOBAL;
+      Value &target = is_global ? globals[ins.a] : slots[ins.a];
+      target = ins.b < 0 ? std::move(stack[--sp])
+                         : coerce_value(stack[--sp], chunk.names[ins.b],
+                                        ins.node->location);
+      if (!is_global) {
+        slot_set[ins.a] = 1;
+      }
+      if (DEBUG) {
+        std::cout << "[DEBUG] Set " << (is_global ? "global" : "local")
+                  << " var " << static_cast<const VarDecl *>(ins.node)->name
+                  << " = " << target.to_string() << std::endl;
+      }
+      break;
+    }
+
+    case OpCode::BINARY: {
+      --sp;
+      stack[sp - 1] = binary_op(static_cast<TokenType>(ins.a), stack[sp - 1],
+                                stack[sp]);
+      break;
+    }
+
+    case OpCode::BINARY_INT: {
+      --sp;
+      Value &l = stack[sp - 1];
+      const Value &r = stack[sp];
+      TokenType op = static_cast<TokenType>(ins.a);
+      l = l.type() == ValueType::INT && r.type() == ValueType::INT
+              ? numeric_binary(op, l.int_val(), r.int_val())
+              : binary_op(op, l, r);
+      break;
+    }
+
+    case OpCode::BINARY_FLOAT: {
+      --sp;
+      Value &l = stack[sp - 1];
+      const Value &r = stack[sp];
+      TokenType op = static_cast<TokenType>(ins.a);
+      bool fast =
+          is_number(l.type()) && is_number(r.type()) &&
+          (l.type() == ValueType::FLOAT || r.type() == ValueType::FLOAT);
+      l = fast ? numeric_binary(op, as_double(l), as_double(r))
+               : binary_op(op, l, r);
+      break;
+    }
+
+    case OpCode::INC_LOCAL_INT:
+      if (slot_set[ins.a] && slots[ins.a].type() == ValueType::INT) {
+        slots[ins.a] = Value(slots[ins.a].int_val() + ins.b);
+        pc = ins.c;
+      }
+      break;
+
+    case OpCode::POP:
+      --sp;
+      break;
+
+    case OpCode::JUMP:
+      pc = ins.a;
+      break;
+
+    case OpCode::JUMP_IF_FALSE: {
+      const Value &cond = stack[--sp];
+      if (cond.type() == ValueType::INT ? cond.int_val() == 0
+                                        : !is_truthy(cond)) {
+        pc = ins.a;
+      }
+      break;
+    }
+
+    case OpCode::PRINT_VALUE:
+      std::cout << stack[--sp].to_string(chunk.names[ins.a]);
+      break;
+
+    case OpCode::PRINT_END:
+      if (ins.a) {
+        std::cout << std::endl;
+      }
+      break;
+
+    case OpCode::CALL: {
+      const std::string &name = chunk.names[ins.a];
+      sp -= ins.b;
+      std::vector<Value> args(stack + sp, stack + sp + ins.b);
+      if (DEBUG) {
+        std::cout << "[DEBUG] Calling " << name << " with " << args.size()
+                  << " args" << std::endl;
+      }
+      try {
+        execute_function(name, args);
+      } catch (CompilerError &e) {
+        e.traceback.push_back(ins.node->location);
+        throw;
+      }
+      slots = frame_stack.data() + base;
+      slot_set = frame_set.data() + base;
+      stack = slots + chunk.frame_size;
+      break;
+    }
+
+    case OpCode::BUILTIN: {
+      sp -= ins.b;
+      std::vector<Value> args(stack + sp, stack + sp + ins.b);
+      stack[sp++] =
+          call_builtin(*chunk.builtins[ins.a], args, ins.node->location);
+      break;
+    }
+
+    case OpCode::INPUT: {
+      Value val = execute_input(*static_cast<const InputStmt *>(ins.node));
+      if (ins.b) {
+        globals[ins.a] = val;
+      } else {
+        slots[ins.a] = val;
+        slot_set[ins.a] = 1;
+      }
+      break;
+    }
+
+    case OpCode::FILE_OP:
+      sp -= ins.a;
+      execute_file_op(*static_cast<const FileOp *>(ins.node), &stack[sp]);
+      break;
+
+    case OpCode::NET_OP: {
+      sp -= ins.a;
+      std::vector<Value> operands(stack + sp, stack + sp + ins.a);
+      execute_net_op(*static_cast<const NetOp *>(ins.node), operands.data());
+      slots = frame_stack.data() + base;
+      slot_set = frame_set.data() + base;
+      stack = slots + chunk.frame_size;
+      break;
+    }
+
+    case OpCode::RETURN:
+      result = std::move(stack[--sp]);
+      return ExecStatus::RETURN;
+
+    case OpCode::END:
+      return ExecStatus::NORMAL;
+    }
+  }
+}
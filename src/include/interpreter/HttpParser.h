@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct HttpHeader {
+  std::string_view name;
+  std::string_view value;
+};
+
+// Decodes the percent-escapes in one component of a URL; a '%' that is not
+// followed by two hex digits is kept as it is. form_encoded also turns '+'
+// into a space, as application/x-www-form-urlencoded does.
+std::string decode_url_component(std::string_view text, bool form_encoded);
+
+// One request read off a connection. Every view points into the connection's
+// input buffer, so they are only valid until the handler returns.
+struct HttpRequestMessage {
+  std::string_view method;
+  std::string_view target;
+  // target up to the first '?', and what follows it.
+  std::string_view path;
+  std::string_view query;
+  std::vector<HttpHeader> headers;
+  std::string_view body;
+  bool keep_alive = false;
+
+  // The first header called name, compared case-insensitively; empty if the
+  // request has none.
+  std::string_view header(std::string_view name) const;
+  // The value of name in the query string with percent-escapes and '+'
+  // decoded; empty if it is absent.
+  std::string query_param(std::string_view name) const;
+};
+
+// An incremental HTTP/1.1 request parser. Bytes are appended to the
+// connection's buffer as they arrive and parse() is called again; it resumes
+// where it stopped instead of scanning the request from its start. Bodies
+// are framed by Content-Length or chunked transfer coding. Chunked bodies are
+// decoded in place, so the request's body is a contiguous view whatever the
+// framing, without being copied out of the buffer.
+class HttpRequestParser {
+public:
+  enum class Status {
+    COMPLETE,
+    INCOMPLETE,
+    BAD_REQUEST,
+    HEADERS_TOO_LARGE,
+    BODY_TOO_LARGE
+  };
+
+  static constexpr size_t max_header_bytes = 64 * 1024;
+  static constexpr size_t max_headers = 100;
+  static constexpr size_t max_body_bytes = 8 * 1024 * 1024;
+  // Bytes a client may send for one request, chunk framing included. A
+  // connection that has buffered this much is answered before reading on.
+  static constexpr size_t max_request_bytes = max_header_bytes + max_body_bytes;
+
+  // Parses the request that begins at start in buffer. Between calls the
+  // caller may append to buffer or erase bytes before start, as long as start
+  // is moved along with them. On COMPLETE, request views into buffer, the
+  // request occupied consumed() bytes from start, and the parser is ready for
+  // the next one.
+  Status parse(std::string &buffer, size_t start, HttpRequestMessage &request);
+  size_t consumed() const { return done; }
+  // True, once per request, when the request being read sent
+  // "Expect: 100-continue" and its head has been accepted; the client holds
+  // the body back until it is answered with 100 Continue.
+  bool take_continue();
+
+private:
+  enum class Stage { HEAD, BODY, CHUNK_SIZE, CHUNK_DATA, TRAILERS };
+
+  struct Span {
+    size_t offset = 0;
+    size_t length = 0;
+  };
+
+  // All positions are relative to the start of the request.
+  Stage stage = Stage::HEAD;
+  size_t scanned = 0;
+  size_t body_start = 0;
+  size_t content_length = 0;
+  // Chunked decoding: compacted body bytes end at body_end, raw input has
+  // been read up to cursor, and chunk_left bytes of the current chunk remain.
+  size_t body_end = 0;
+  size_t cursor = 0;
+  size_t chunk_left = 0;
+  size_t done = 0;
+  bool keep_alive = false;
+  bool expect_continue = false;
+  Span method;
+  Span target;
+  std::vector<std::pair<Span, Span>> headers;
+
+  Status parse_head(const std::string &buffer, size_t start);
+  Status parse_chunks(std::string &buffer, size_t start);
+  Status finish(const std::string &buffer, size_t start,
+                HttpRequestMessage &request);
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "HttpParser.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+// What the application answers; the reactor adds the framing headers.
+struct HttpReply {
+  int status = 200;
+  std::string reason = "OK";
+  std::string content_type = "text/plain; charset=utf-8";
+  std::string body;
+};
+
+// A single-threaded epoll loop over a listening socket. Connections are
+// non-blocking and kept alive between requests; requests pipelined on one
+// connection are answered in order, and a connection that stays quiet for
+// idle_timeout is closed. Handlers run on the loop thread, one at a time.
+class HttpReactor {
+public:
+  using Handler = std::function<HttpReply(const HttpRequestMessage &)>;
+  using Logger =
+      std::function<void(const std::string &message, const std::string &level)>;
+
+  static constexpr std::chrono::seconds idle_timeout{15};
+
+  // Takes ownership of listen_fd, which must already be bound and listening.
+  HttpReactor(int listen_fd, Handler handler, Logger log);
+  ~HttpReactor();
+  HttpReactor(const HttpReactor &) = delete;
+  HttpReactor &operator=(const HttpReactor &) = delete;
+
+  // Serves until drain() has been called and every open connection has been
+  // answered; throws RuntimeError if epoll itself fails.
+  void run();
+  // Stops accepting new connections. Requests already being read are still
+  // answered, with Connection: close. Safe to call from the handler.
+  void drain();
+
+private:
+  struct Connection {
+    std::string input;
+    HttpRequestParser parser;
+    // Reused for every request on the connection to keep its header list.
+    HttpRequestMessage request;
+    std::string output;
+    size_t output_sent = 0;
+    size_t requests = 0;
+    uint32_t events = 0;
+    // The peer has finished sending; answer what is buffered, then close.
+    bool eof = false;
+    // Close once the output has drained; nothing more is read or served.
+    bool closing = false;
+    std::chrono::steady_clock::time_point last_active;
+  };
+
+  int listen_fd;
+  int epoll_fd = -1;
+  bool draining = false;
+  Handler handler;
+  Logger log;
+  std::unordered_map<int, Connection> connections;
+
+  void accept_clients();
+  void handle(int fd, uint32_t events);
+  bool read_client(int fd, Connection &conn);
+  void serve_buffered(Connection &conn);
+  bool flush(int fd, Connection &conn);
+  void progress(int fd, Connection &conn);
+  void watch(int fd, Connection &conn);
+  void close_client(int fd);
+  void close_idle_clients();
+  void close_quiet_clients();
+
+  static void append_reply(std::string &output, const HttpReply &reply,
+                           bool keep_alive);
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "../utils/Error.h"
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct RouteParam {
+  std::string_view name;
+  std::string_view value;
+};
+
+// What a lookup found: the route's id and the path parameters it captured.
+// Names view into the router and values into the looked-up path.
+struct RouteMatch {
+  static constexpr size_t max_params = 16;
+
+  size_t route = 0;
+  size_t param_count = 0;
+  std::array<RouteParam, max_params> params;
+
+  // The value captured for name, or empty if the route has no such
+  // parameter.
+  std::string_view param(std::string_view name) const;
+};
+
+// A compressed radix tree of route paths for each method. A path segment
+// written `:name` matches any one non-empty segment, and a last segment
+// written `*name` matches the rest of the path, slashes included. When
+// several routes could match, literal text wins over a parameter and a
+// parameter over a catch-all. Lookups only read the tree and never allocate.
+class HttpRouter {
+public:
+  static constexpr size_t no_route = static_cast<size_t>(-1);
+
+  // Returns the slot holding the route id for method and pattern, no_route
+  // if the pattern is new; it stays valid until the next add. Throws
+  // RuntimeError for a malformed pattern or one that names a parameter
+  // differently from a route already sharing it.
+  size_t &add(const std::string &method, std::string_view pattern,
+              const SourceLocation &loc);
+  bool find(std::string_view method, std::string_view path,
+            RouteMatch &match) const;
+
+private:
+  struct Node {
+    // Literal text matched on the way into this node; empty for the root
+    // and for parameter nodes.
+    std::string prefix;
+    // First byte of each literal child's prefix, in the order of children,
+    // so a lookup can pick its branch without visiting the others.
+    std::string first_bytes;
+    std::vector<size_t> children;
+    size_t param = no_route;
+    std::string param_name;
+    std::string catch_all_name;
+    size_t catch_all_route = no_route;
+    size_t route = no_route;
+  };
+
+  std::vector<Node> nodes;
+  // Root node of each method's tree; methods are stored uppercased.
+  std::vector<std::pair<std::string, size_t>> roots;
+
+  size_t add_node();
+  size_t insert_literal(size_t node, std::string_view text);
+  bool match(size_t node, std::string_view rest, RouteMatch &match) const;
+};
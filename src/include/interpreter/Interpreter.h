@@ -2,34 +2,74 @@
 
 #include "../token/Ast.h"
 #include "../utils/Utils.h"
+#include "../vm/Bytecode.h"
+#include "HttpReactor.h"
+#include "HttpRouter.h"
 #include <fstream>
 #include <map>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 struct sqlite3;
 
+// How web::run runs its workers, set from the `pgt run` command line.
+struct HttpServerOptions {
+  // Fork the workers as processes under a supervisor instead of starting
+  // threads, so a crashing worker takes down only itself.
+  bool prefork = false;
+  // A preforked worker is replaced once it has served this many requests or
+  // its peak resident memory passes this many MiB; 0 means no limit.
+  uint64_t max_requests = 0;
+  uint64_t max_memory_mb = 0;
+};
+
 class Interpreter {
-  std::map<std::string, std::shared_ptr<FunctionDef>> functions;
-  std::map<std::string, std::shared_ptr<ClassDef>> orm_models;
-  std::map<std::string, Value> globals;
+  struct CompiledFunction {
+    FunctionDef *def;
+    std::shared_ptr<Chunk> chunk;
+  };
+
+  std::map<std::string, CompiledFunction> functions;
+  std::map<std::string, ClassDef *> orm_models;
+  std::vector<Value> globals;
+  std::vector<std::string> global_names;
+  std::vector<Value> frame_stack;
+  std::vector<unsigned char> frame_set;
   std::vector<SourceLocation> call_stack;
   std::map<std::string, std::unique_ptr<std::fstream>> open_files;
-  std::ofstream log_file;
-  std::string log_output = "console";
   sqlite3 *sqlite_db = nullptr;
   std::string sql_output_path;
 
+  // Where log_message writes. Server workers share one sink.
+  struct LogSink {
+    std::mutex lock;
+    std::ofstream file;
+    std::string output = "console";
+  };
+  std::shared_ptr<LogSink> log_sink = std::make_shared<LogSink>();
+  HttpServerOptions server_options;
+
+  static constexpr long long max_http_workers = 1024;
+  static constexpr int sqlite_busy_timeout_ms = 5000;
+
   struct HttpRoute {
     std::string handler;
     SourceLocation location;
   };
 
   struct HttpRequest {
-    std::string method;
-    std::string path;
-    std::string body;
+    Value method = Value(std::string());
+    Value path = Value(std::string());
+    Value body = Value(std::string());
+    Value json;
+    bool json_parsed = false;
+    // Headers and query string are looked up here when asked for rather than
+    // copied into every request.
+    const HttpRequestMessage *message = nullptr;
+    const RouteMatch *route = nullptr;
   };
 
   struct ParsedUrl {
@@ -39,14 +79,13 @@ class Interpreter {
     std::string path;
   };
 
-  std::map<std::string, HttpRoute> http_routes;
+  // Routes in registration order; http_router maps a request to its index.
+  std::vector<HttpRoute> http_routes;
+  HttpRouter http_router;
   HttpRequest current_request;
 
-  bool is_truthy(const Value &value) const;
   Value coerce_value(const Value &value, const std::string &type_name,
                      const SourceLocation &loc) const;
-  void assign_value(const std::string &name, const Value &value,
-                    std::map<std::string, Value> &locals);
   ParsedUrl parse_url(const std::string &url, const SourceLocation &loc) const;
   std::string extract_http_body(const std::string &response) const;
   std::string perform_http_request(const std::string &transport,
@@ -55,36 +94,59 @@ class Interpreter {
                                    const std::string &body,
                                    const SourceLocation &loc) const;
   void run_http_server(const std::string &host, long long port,
-                       const std::string &body, const SourceLocation &loc);
+                       const std::string &body, long long workers,
+                       const SourceLocation &loc);
+  // A context for one more server worker. It shares the compiled functions,
+  // models, routes and log with this one, opens its own connection to the
+  // same database and starts from a copy of the globals: once a server runs
+  // several workers, each reads and writes globals of its own.
+  std::unique_ptr<Interpreter>
+  make_worker_context(const SourceLocation &loc) const;
+  void serve_http(int listen_fd, const std::string &body,
+                  const SourceLocation &loc);
+  // Forks the workers and replaces each one that exits, until the server is
+  // told to stop by SIGINT or SIGTERM.
+  [[noreturn]] void supervise_http_workers(int listen_fd,
+                                           const std::string &body,
+                                           long long workers,
+                                           const SourceLocation &loc);
+  [[noreturn]] void run_http_worker_process(int listen_fd,
+                                            const std::string &body,
+                                            bool open_database,
+                                            const SourceLocation &loc);
+  bool http_worker_spent(uint64_t served) const;
+  HttpReply serve_http_request(const HttpRequestMessage &request,
+                               const std::string &body,
+                               const SourceLocation &loc);
   void register_http_route(const std::string &method, const std::string &path,
                            const std::string &handler,
                            const SourceLocation &loc);
-  std::string make_route_key(const std::string &method,
-                             const std::string &path) const;
   std::string normalize_http_method(const std::string &method) const;
   std::string read_response_body(const std::string &body,
                                  const SourceLocation &loc) const;
   Value call_http_handler(const HttpRoute &route, const std::string &method,
-                          const std::string &path, const std::string &body);
+                          const HttpRequestMessage &request,
+                          const RouteMatch &match);
   std::string response_content_type(const Value &value) const;
   std::string response_body_from_value(const Value &value) const;
   Value parse_json(const std::string &json_str,
                    const SourceLocation &loc) const;
   std::string stringify_json(const Value &value) const;
   Value read_file_path(const Value &arg, const SourceLocation &loc) const;
-  Value execute_json_builtin(const std::string &name,
+  Value execute_json_builtin(const BuiltinInfo &builtin,
                              const std::vector<Value> &args,
                              const SourceLocation &loc);
-  Value execute_auth_builtin(const std::string &name,
+  Value execute_auth_builtin(const BuiltinInfo &builtin,
                              const std::vector<Value> &args,
                              const SourceLocation &loc);
-  Value execute_jwt_builtin(const std::string &name,
+  Value execute_jwt_builtin(const BuiltinInfo &builtin,
                             const std::vector<Value> &args,
                             const SourceLocation &loc);
-  Value execute_request_builtin(const std::string &name,
+  Value request_json(const SourceLocation &loc);
+  Value execute_request_builtin(const BuiltinInfo &builtin,
                                 const std::vector<Value> &args,
                                 const SourceLocation &loc);
-  Value execute_sql_builtin(const std::string &name,
+  Value execute_sql_builtin(const BuiltinInfo &builtin,
                             const std::vector<Value> &args,
                             const SourceLocation &loc);
   std::string escape_sql_identifier(const std::string &identifier,
@@ -100,25 +162,25 @@ class Interpreter {
                        const Value &value, const SourceLocation &loc) const;
   void execute_sql_statement(const std::string &statement,
                              const SourceLocation &loc) const;
+  void open_sqlite(const std::string &path, const SourceLocation &loc);
   std::string normalize_log_level(const std::string &level) const;
   bool is_known_log_level(const std::string &level) const;
-  std::string log_level_from_builtin(const std::string &name) const;
-  bool is_log_builtin_name(const std::string &name) const;
+  std::string log_level_from_builtin(BuiltinId id) const;
   Value set_log_output(const Value &arg, const SourceLocation &loc);
-  Value execute_log_builtin(const std::string &name,
+  Value execute_log_builtin(const BuiltinInfo &builtin,
                             const std::vector<Value> &args,
                             const SourceLocation &loc);
   Value open_log_path(const Value &arg, const SourceLocation &loc);
   void log_message(const std::string &message,
                    const std::string &level = "INFO");
-  void execute_statement(const std::shared_ptr<AstNode> &stmt,
-                         std::map<std::string, Value> &locals);
-  void execute_block(const std::vector<std::shared_ptr<AstNode>> &body,
-                     std::map<std::string, Value> &locals);
+  Value call_builtin(const BuiltinInfo &builtin, const std::vector<Value> &args,
+                     const SourceLocation &loc);
+  Value execute_input(const InputStmt &input);
+  void execute_file_op(const FileOp &file_op, const Value *operands);
+  void execute_net_op(const NetOp &net_op, const Value *operands);
+  ExecStatus run_chunk(const Chunk &chunk, size_t base, Value &result);
   Value execute_function(const std::string &name,
                          const std::vector<Value> &call_args);
-  Value eval(const std::shared_ptr<AstNode> &node,
-             const std::map<std::string, Value> &locals = {});
 
 private:
   Value parse_json_value(const std::string &json_str, size_t &pos,
@@ -140,6 +202,13 @@ private:
   void skip_whitespace(const std::string &json_str, size_t &pos) const;
 
 public:
+  static bool is_truthy(const Value &value);
+  static Value binary_op(TokenType op, const Value &l, const Value &r);
+
   ~Interpreter();
-  void run(const std::vector<std::shared_ptr<AstNode>> &program);
+  // Registers functions, models and routes and evaluates globals.
+  void load(const std::vector<AstNode *> &program);
+  void run_main();
+  void run(const std::vector<AstNode *> &program);
+  void set_server_options(const HttpServerOptions &options);
 };
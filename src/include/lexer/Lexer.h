@@ -1,11 +1,17 @@
 #pragma once
 
 #include "../token/Token.h"
+#include "Scan.h"
+#include "SourceFile.h"
 #include <string>
+#include <string_view>
 #include <vector>
 
+// Token values are views into file's text, so file must outlive them.
 class Lexer {
-  std::string source;
+  SourceFile &file;
+  const Scanner &scan;
+  std::string_view source;
   size_t pos = 0;
   int line = 1;
   int column = 1;
@@ -13,8 +19,10 @@ class Lexer {
   char peek() const;
   char peek_next() const;
   char get();
+  void advance(size_t count, bool count_cr);
+  std::string_view decode_string(std::string_view raw);
 
 public:
-  explicit Lexer(std::string src);
+  explicit Lexer(SourceFile &file);
   Token next_token();
 };
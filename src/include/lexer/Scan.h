@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+// Newlines in a scanned span, and how many bytes follow the last one (the
+// span's length when there is none).
+struct LineSpan {
+  size_t lines = 0;
+  size_t tail = 0;
+};
+
+// Byte-scanning kernels for the lexer. Each returns a count of bytes from p,
+// at most n. The implementation is chosen once per process: AVX2 when the
+// CPU supports it, SSE2 on other x86 machines, a scalar loop elsewhere.
+// Whitespace and identifier classes are ASCII-only, as in the C locale.
+struct Scanner {
+  const char *name;
+  size_t (*whitespace_run)(const char *p, size_t n);
+  size_t (*identifier_run)(const char *p, size_t n);
+  // Index of the first byte equal to a or b, or n.
+  size_t (*find_either)(const char *p, size_t n, char a, char b);
+  // Counts '\n', and '\r' too when count_cr is set.
+  LineSpan (*count_lines)(const char *p, size_t n, bool count_cr);
+};
+
+const Scanner &scanner();
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <string_view>
+
+// The text of one .pgt file. Regular files are memory-mapped read-only so
+// tokens can be string_views into the mapping; text the lexer has to build
+// (string literals with escapes) is kept alongside it. Every view handed out
+// stays valid until the SourceFile is destroyed or replace() is called.
+class SourceFile {
+  void *mapped = nullptr;
+  size_t mapped_size = 0;
+  std::string owned;
+  std::string_view view;
+  std::deque<std::string> decoded;
+
+  void release();
+
+public:
+  SourceFile() = default;
+  ~SourceFile();
+  SourceFile(const SourceFile &) = delete;
+  SourceFile &operator=(const SourceFile &) = delete;
+
+  bool open(const std::string &path);
+  // Swaps in text held in memory, e.g. after a syntax repair rewrote the
+  // file on disk.
+  void replace(std::string text);
+  std::string_view keep(std::string text);
+  std::string_view text() const { return view; }
+};
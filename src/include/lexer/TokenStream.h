@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../token/Token.h"
+#include "Lexer.h"
+#include <cstddef>
+
+// Pulls tokens from a Lexer on demand, dropping comments, and buffers the
+// few tokens of lookahead the parser needs in a fixed ring. Once the lexer
+// reaches the end every further token is T_EOF.
+class TokenStream {
+  static constexpr size_t capacity = 4;
+
+  Lexer &lexer;
+  Token ring[capacity];
+  size_t head = 0;
+  size_t buffered = 0;
+  size_t consumed = 0;
+
+  void fill(size_t count);
+
+public:
+  static constexpr size_t max_lookahead = capacity - 1;
+
+  explicit TokenStream(Lexer &lexer) : lexer(lexer) {}
+
+  // offset is at most max_lookahead; peek(0) is the current token.
+  const Token &peek(size_t offset = 0);
+  void advance();
+  // Tokens consumed so far, for callers that check for progress.
+  size_t position() const { return consumed; }
+};
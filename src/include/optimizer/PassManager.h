@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../token/Ast.h"
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+// A rewrite over the analyzed program. Passes run after SemanticAnalyzer and
+// before the interpreter resolves and compiles the tree, so they may replace
+// or splice nodes freely but must keep the program's observable behavior.
+class AstPass {
+public:
+  virtual ~AstPass() = default;
+  virtual const char *name() const = 0;
+  virtual void run(std::vector<AstNode *> &program) = 0;
+};
+
+// Replaces BinaryOp nodes whose operands are literals with their value.
+class ConstantFoldingPass : public AstPass {
+  AstArena &arena;
+
+  void fold_block(std::vector<AstNode *> &body);
+  void fold_expr(AstNode *&expr);
+
+public:
+  explicit ConstantFoldingPass(AstArena &arena) : arena(arena) {}
+  const char *name() const override { return "constant-folding"; }
+  void run(std::vector<AstNode *> &program) override;
+};
+
+// Drops the untaken side of an if with a literal condition and while loops
+// whose literal condition is false.
+class BranchPruningPass : public AstPass {
+  void prune_block(std::vector<AstNode *> &body);
+
+public:
+  const char *name() const override { return "branch-pruning"; }
+  void run(std::vector<AstNode *> &program) override;
+};
+
+// Evaluates arithmetic over loop-invariant variables once before a while loop
+// instead of on every iteration.
+class LoopInvariantHoistingPass : public AstPass {
+  AstArena &arena;
+  std::set<std::string> global_names;
+  int next_temp = 0;
+
+  void hoist_block(std::vector<AstNode *> &body, std::set<std::string> defined);
+  void hoist_loop(WhileStmt &loop, const std::set<std::string> &defined,
+                  std::vector<AstNode *> &hoisted);
+  bool is_invariant(AstNode *expr, const std::set<std::string> &stable) const;
+  void hoist_expr(AstNode *&expr, const std::set<std::string> &stable,
+                  std::vector<AstNode *> &hoisted);
+
+public:
+  explicit LoopInvariantHoistingPass(AstArena &arena) : arena(arena) {}
+  const char *name() const override { return "loop-invariant-hoisting"; }
+  void run(std::vector<AstNode *> &program) override;
+};
+
+// Drops top-level functions and models that nothing can reach. The roots are
+// main, functions with routes, and every other top-level statement. A
+// definition is reached when a reached body calls it, names it, or mentions
+// it in a string literal, which is how web::get and web::route name their
+// handlers and how the db builtins name their models. Handler names that are
+// computed at run time are not seen. Unlike the passes above, this one runs
+// before SemanticAnalyzer, so unused library code is never analyzed either.
+class TreeShakingPass : public AstPass {
+  std::set<std::string> reached;
+  std::vector<std::string> pending;
+
+  void reach(const std::string &name);
+  void scan(AstNode *node);
+
+public:
+  const char *name() const override { return "tree-shaking"; }
+  void run(std::vector<AstNode *> &program) override;
+};
+
+class PassManager {
+  std::vector<std::unique_ptr<AstPass>> passes;
+
+public:
+  // Level 0 runs nothing, 1 folds constants and prunes branches, 2 also
+  // hoists loop invariants. TreeShakingPass is not part of the list: from
+  // level 1 the driver runs it on its own, before analysis.
+  static constexpr int max_opt_level = 2;
+
+  // New nodes are allocated from the program's arena.
+  PassManager(AstArena &arena, int opt_level = max_opt_level);
+  void add_pass(std::unique_ptr<AstPass> pass);
+  void run(std::vector<AstNode *> &program);
+};
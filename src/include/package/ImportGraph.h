@@ -0,0 +1,57 @@
+#pragma once
+
+#include "../token/Ast.h"
+#include "PackageResolver.h"
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+struct ImportEdge {
+  ImportStmt *import = nullptr;
+  ResolvedImport resolved;
+};
+
+// One loaded file: its package, its top-level program and the functions and
+// classes it declares for importers to pick from.
+struct ImportNode {
+  std::string file;
+  std::string package_name;
+  std::vector<AstNode *> program;
+  std::set<std::string> symbols;
+  std::vector<ImportEdge> imports;
+};
+
+// Every file reachable from the entry file, with each import statement
+// already resolved. Built once while loading, so later stages can follow
+// imports without going back to the filesystem. Files are kept sorted by
+// path, which is the order their programs are combined in.
+class ImportGraph {
+  std::map<std::string, ImportNode> nodes;
+
+public:
+  ImportNode &add_file(const std::string &file,
+                       const std::string &package_name,
+                       const std::vector<AstNode *> &program) {
+    ImportNode &node = nodes[file];
+    node.file = file;
+    node.package_name = package_name;
+    node.program = program;
+    for (AstNode *statement : program) {
+      if (auto func = node_cast<FunctionDef>(statement)) {
+        node.symbols.insert(func->name);
+      } else if (auto klass = node_cast<ClassDef>(statement)) {
+        node.symbols.insert(klass->name);
+      }
+    }
+    return node;
+  }
+
+  bool contains(const std::string &file) const { return nodes.count(file); }
+
+  const ImportNode &at(const std::string &file) const {
+    return nodes.at(file);
+  }
+
+  const std::map<std::string, ImportNode> &files() const { return nodes; }
+};
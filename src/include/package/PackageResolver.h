@@ -5,7 +5,10 @@
 #include <cctype>
 #include <filesystem>
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 struct ResolvedImport {
@@ -16,22 +19,48 @@ struct ResolvedImport {
   bool is_package = false;
 };
 
+// Resolves import paths to files. The loader and the later validation passes
+// ask about the same imports from several threads, so every filesystem probe,
+// the pgt.mod requirements and each resolved import are remembered for the
+// lifetime of the resolver.
 class PackageResolver {
-  std::string project_root;
-  std::string compiler_root;
-
   struct ModuleRequirement {
     std::string path;
     std::string version;
   };
 
-  static bool file_exists(const std::string &path) {
-    std::ifstream file(path);
-    return file.good();
+  std::string project_root;
+  std::string compiler_root;
+  std::vector<ModuleRequirement> module_requirements;
+
+  mutable std::mutex cache_lock;
+  mutable std::unordered_map<std::string, std::filesystem::file_type>
+      path_types;
+  mutable std::map<std::pair<std::string, std::string>, ResolvedImport>
+      resolved_imports;
+
+  std::filesystem::file_type path_type(const std::string &path) const {
+    {
+      std::lock_guard<std::mutex> guard(cache_lock);
+      auto found = path_types.find(path);
+      if (found != path_types.end()) {
+        return found->second;
+      }
+    }
+    std::error_code error;
+    std::filesystem::file_type type =
+        std::filesystem::status(path, error).type();
+    std::lock_guard<std::mutex> guard(cache_lock);
+    path_types.emplace(path, type);
+    return type;
+  }
+
+  bool file_exists(const std::string &path) const {
+    return path_type(path) == std::filesystem::file_type::regular;
   }
 
-  static bool directory_exists(const std::string &path) {
-    return std::filesystem::exists(path) && std::filesystem::is_directory(path);
+  bool directory_exists(const std::string &path) const {
+    return path_type(path) == std::filesystem::file_type::directory;
   }
 
   static bool starts_with(const std::string &value, const std::string &prefix) {
@@ -272,37 +301,8 @@ class PackageResolver {
     return "";
   }
 
-public:
-  PackageResolver(const std::string &entry_file,
-                  const std::string &executable_path)
-      : project_root(directory_of(entry_file)),
-        compiler_root(directory_of(executable_path)) {
-    if (project_root.empty()) {
-      project_root = ".";
-    }
-    if (compiler_root.empty()) {
-      compiler_root = ".";
-    }
-  }
-
-  static std::string directory_of(const std::string &file_path) {
-    std::filesystem::path path(file_path);
-    std::filesystem::path parent = path.parent_path();
-    if (parent.empty()) {
-      return ".";
-    }
-    return parent.string();
-  }
-
-  static std::string directory_name(const std::string &directory) {
-    if (directory.empty() || directory == ".") {
-      return "";
-    }
-    return std::filesystem::path(directory).filename().string();
-  }
-
-  ResolvedImport resolve_import_path(const std::string &base_dir,
-                                     const std::string &import_path) const {
+  ResolvedImport probe_import_path(const std::string &base_dir,
+                                   const std::string &import_path) const {
     std::vector<std::string> file_candidates;
     std::vector<std::string> directory_candidates;
     bool standard = is_standard_import(import_path);
@@ -331,7 +331,7 @@ public:
       add_directory_candidate(directory_candidates, project_root, import_path);
       add_directory_candidate(directory_candidates, ".", import_path);
 
-      for (const auto &requirement : read_module_requirements(project_root)) {
+      for (const auto &requirement : module_requirements) {
         if (!import_matches_module(import_path, requirement.path)) {
           continue;
         }
@@ -369,6 +369,52 @@ public:
     return {fallback, {}, false, standard, false};
   }
 
+public:
+  PackageResolver(const std::string &entry_file,
+                  const std::string &executable_path)
+      : project_root(directory_of(entry_file)),
+        compiler_root(directory_of(executable_path)) {
+    if (project_root.empty()) {
+      project_root = ".";
+    }
+    if (compiler_root.empty()) {
+      compiler_root = ".";
+    }
+    module_requirements = read_module_requirements(project_root);
+  }
+
+  static std::string directory_of(const std::string &file_path) {
+    std::filesystem::path path(file_path);
+    std::filesystem::path parent = path.parent_path();
+    if (parent.empty()) {
+      return ".";
+    }
+    return parent.string();
+  }
+
+  static std::string directory_name(const std::string &directory) {
+    if (directory.empty() || directory == ".") {
+      return "";
+    }
+    return std::filesystem::path(directory).filename().string();
+  }
+
+  ResolvedImport resolve_import_path(const std::string &base_dir,
+                                     const std::string &import_path) const {
+    std::pair<std::string, std::string> key(base_dir, import_path);
+    {
+      std::lock_guard<std::mutex> guard(cache_lock);
+      auto found = resolved_imports.find(key);
+      if (found != resolved_imports.end()) {
+        return found->second;
+      }
+    }
+    ResolvedImport resolved = probe_import_path(base_dir, import_path);
+    std::lock_guard<std::mutex> guard(cache_lock);
+    return resolved_imports.emplace(std::move(key), std::move(resolved))
+        .first->second;
+  }
+
   void validate_main_package_root(const std::string &entry_file) const {
     std::string root_dir = directory_of(entry_file);
     for (const auto &entry : std::filesystem::directory_iterator(root_dir)) {
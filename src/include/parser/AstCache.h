@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../token/Ast.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+// What the loader keeps from parsing one file.
+struct ParsedFile {
+  std::vector<AstNode *> program;
+  bool has_package_decl = false;
+  std::string package_name;
+  bool has_return_zero = false;
+};
+
+// On-disk cache of parsed files. Each entry is a .pgtc file named after the
+// SHA-256 of the compiler version and the source text, holding the tree as
+// the parser produced it, before any analysis or optimization pass runs.
+// Unreadable, truncated or stale entries are treated as misses, and failures
+// to write one are ignored: the cache only ever saves work.
+class AstCache {
+  std::string directory;
+
+public:
+  // An empty directory disables the cache.
+  explicit AstCache(std::string directory) : directory(std::move(directory)) {}
+
+  static std::string key(std::string_view source);
+  bool load(const std::string &key, AstArena &arena, ParsedFile &file) const;
+  void store(const std::string &key, const ParsedFile &file) const;
+};
@@ -1,48 +1,50 @@
 #pragma once
 
+#include "../lexer/TokenStream.h"
 #include "../token/Ast.h"
 #include "../token/Token.h"
 #include <memory>
 #include <vector>
 
 class Parser {
-  std::vector<Token> tokens;
-  size_t pos = 0;
+  AstArena &arena;
+  TokenStream tokens;
   bool has_package_decl = false;
   std::string package_name;
   bool has_return_zero = false;
   std::vector<RouteDef> pending_routes;
 
-  bool is_eof() const;
-  const Token &current() const;
+  bool is_eof();
+  const Token &current();
+  const Token &peek(size_t offset);
   void advance();
 
-  std::shared_ptr<FunctionDef> parse_function();
-  std::shared_ptr<ClassDef> parse_class();
+  FunctionDef *parse_function();
+  ClassDef *parse_class();
   OrmField parse_orm_field();
-  std::shared_ptr<AstNode> parse_statement();
-  std::shared_ptr<VarDecl> parse_var_decl();
-  std::shared_ptr<AstNode> parse_expr();
-  std::shared_ptr<AstNode> parse_comparison();
-  std::shared_ptr<AstNode> parse_add_sub();
-  std::shared_ptr<AstNode> parse_mul_div();
-  std::shared_ptr<AstNode> parse_primary();
-  std::shared_ptr<BuiltinCallExpr> parse_builtin_call_expr();
-  std::shared_ptr<BuiltinCallExpr> parse_namespaced_builtin_call_expr();
-  std::shared_ptr<IfStmt> parse_if();
-  std::shared_ptr<WhileStmt> parse_while();
-  std::shared_ptr<PrintStmt> parse_print();
-  std::shared_ptr<InputStmt> parse_input();
-  std::shared_ptr<CallStmt> parse_call();
-  std::shared_ptr<CallStmt> parse_function_call();
-  std::shared_ptr<FileOp> parse_file_op();
-  std::shared_ptr<NetOp> parse_net_op();
-  std::shared_ptr<ImportStmt> parse_import();
+  AstNode *parse_statement();
+  VarDecl *parse_var_decl();
+  AstNode *parse_expr();
+  AstNode *parse_comparison();
+  AstNode *parse_add_sub();
+  AstNode *parse_mul_div();
+  AstNode *parse_primary();
+  BuiltinCallExpr *parse_builtin_call_expr();
+  BuiltinCallExpr *parse_namespaced_builtin_call_expr();
+  IfStmt *parse_if();
+  WhileStmt *parse_while();
+  PrintStmt *parse_print();
+  InputStmt *parse_input();
+  CallStmt *parse_call();
+  CallStmt *parse_function_call();
+  FileOp *parse_file_op();
+  NetOp *parse_net_op();
+  ImportStmt *parse_import();
   std::string parse_type_name();
 
 public:
-  void load_tokens(std::vector<Token> t);
-  std::vector<std::shared_ptr<AstNode>> parse_program();
+  Parser(AstArena &arena, Lexer &lexer) : arena(arena), tokens(lexer) {}
+  std::vector<AstNode *> parse_program();
   bool found_package_main() const {
     return has_package_decl && package_name == "main";
   }
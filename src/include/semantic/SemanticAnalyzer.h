@@ -39,27 +39,33 @@ class SemanticAnalyzer {
   VarType type_from_name(const std::string &type_name);
   std::string type_to_string(VarType type);
   bool is_assignable(VarType expected, VarType actual);
-  VarType infer_expr_type(const std::shared_ptr<AstNode> &node);
+  VarType infer_expr_type(AstNode *node);
+  VarType infer_builtin_type(const BuiltinInfo &builtin,
+                             const std::string &name,
+                             const std::vector<AstNode *> &args,
+                             const SourceLocation &loc);
+  void expect_string_arg(AstNode *arg, const std::string &message,
+                         const SourceLocation &loc);
   void enter_scope();
   void exit_scope();
   void declare_variable(const std::string &name, VarType type,
                         const SourceLocation &loc);
   VariableInfo *find_variable(const std::string &name);
 
-  void analyze_program(const std::vector<std::shared_ptr<AstNode>> &program);
-  void analyze_function(const std::shared_ptr<FunctionDef> &func);
-  void analyze_statement(const std::shared_ptr<AstNode> &stmt);
-  void analyze_var_decl(const std::shared_ptr<VarDecl> &decl);
-  void analyze_expr(const std::shared_ptr<AstNode> &expr);
-  void analyze_print(const std::shared_ptr<PrintStmt> &print);
-  void analyze_input(const std::shared_ptr<InputStmt> &input);
-  void analyze_if(const std::shared_ptr<IfStmt> &if_stmt);
-  void analyze_while(const std::shared_ptr<WhileStmt> &while_stmt);
-  void analyze_call(const std::shared_ptr<CallStmt> &call);
-  void analyze_return(const std::shared_ptr<ReturnStmt> &ret);
-  void analyze_net_op(const std::shared_ptr<NetOp> &net_op);
-  void analyze_file_op(const std::shared_ptr<FileOp> &file_op);
+  void analyze_program(const std::vector<AstNode *> &program);
+  void analyze_function(FunctionDef *func);
+  void analyze_statement(AstNode *stmt);
+  void analyze_var_decl(VarDecl *decl);
+  void analyze_expr(AstNode *expr);
+  void analyze_print(PrintStmt *print);
+  void analyze_input(InputStmt *input);
+  void analyze_if(IfStmt *if_stmt);
+  void analyze_while(WhileStmt *while_stmt);
+  void analyze_call(CallStmt *call);
+  void analyze_return(ReturnStmt *ret);
+  void analyze_net_op(NetOp *net_op);
+  void analyze_file_op(FileOp *file_op);
 
 public:
-  void analyze(const std::vector<std::shared_ptr<AstNode>> &program);
+  void analyze(const std::vector<AstNode *> &program);
 };
\ No newline at end of file
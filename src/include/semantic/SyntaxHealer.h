@@ -1,11 +1,15 @@
 #pragma once
 
+#include "../lexer/Lexer.h"
+#include "../lexer/SourceFile.h"
 #include "../token/Token.h"
 #include <algorithm>
 #include <cctype>
 #include <cstddef>
 #include <cstdlib>
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
 class SyntaxHealer {
@@ -20,32 +24,80 @@ public:
     std::string source;
     std::vector<Diagnostic> diagnostics;
     bool changed = false;
+    // False when the last round still found edits to make.
+    bool settled = true;
   };
 
-  static RepairResult repair_source(const std::string &source,
+  static constexpr int max_rounds = 5;
+
+  // Repairs source in rounds. Typo corrections go first, on their own, since
+  // they change what kind of token a word is; bracket and separator fixes
+  // follow on the re-lexed text. Each round plans its edits in one pass and
+  // applies them in one rewrite, and the loop ends at the first round with
+  // nothing to change. A file that is balanced and free of typos returns
+  // before any of that.
+  static RepairResult repair_source(std::string_view source,
                                     const std::vector<Token> &tokens) {
-    std::vector<Token> filtered_tokens = strip_comment_tokens(tokens);
-    std::vector<TextEdit> edits = plan_edits(source, filtered_tokens);
     RepairResult result;
-    result.source = source;
-    result.changed = !edits.empty();
+    std::vector<Token> round_tokens = strip_comment_tokens(tokens);
+    size_t token_count = 0;
+    if (!find_repairs<TokenList>(round_tokens, token_count)) {
+      return result;
+    }
+
+    SourceFile repaired;
+    std::string_view text = source;
+    result.settled = false;
+    for (int round = 0; round < max_rounds; ++round) {
+      LineIndex lines(text);
+      std::vector<TextEdit> edits = plan_edits(lines, round_tokens);
+      if (edits.empty()) {
+        result.settled = true;
+        break;
+      }
+      std::string next = apply_edits(lines, edits);
+      if (next == text) {
+        result.settled = true;
+        break;
+      }
+      for (const auto &edit : edits) {
+        result.diagnostics.push_back({edit.line, edit.column, edit.message});
+      }
+      repaired.replace(std::move(next));
+      text = repaired.text();
+      round_tokens = tokenize(repaired);
+    }
 
-    for (const auto &edit : edits) {
-      result.diagnostics.push_back({edit.line, edit.column, edit.message});
+    if (text != source) {
+      result.source = std::string(text);
+      result.changed = true;
     }
+    return result;
+  }
 
-    if (!edits.empty()) {
-      result.source = apply_edits(source, edits);
-      result.changed = result.source != source;
+  // True when normalize() and balance() would leave tokens as they are:
+  // nothing to insert, every bracket closed in order. Needs no source text.
+  static bool is_balanced(const std::vector<Token> &tokens) {
+    BalanceScan scan;
+    for (TokenList list(tokens);; list.advance()) {
+      if (!scan.step(list.tokens, list.normalized, list.index))
+        return false;
+      if (is_eof(list.current().type))
+        return true;
     }
+  }
 
-    return result;
+  // Whether repair_source would change source, answered on the lexer's
+  // stream so that the file's tokens are never all held at once. tokens is
+  // set to the number of tokens in the file, comments left out.
+  static bool needs_repair(SourceFile &source, size_t &tokens) {
+    return find_repairs<TokenWindow>(source, tokens);
   }
 
   static std::vector<Token> heal(const std::vector<Token> &tokens) {
     std::vector<Token> filtered_tokens = strip_comment_tokens(tokens);
     std::vector<HealingToken> normalized = normalize(filtered_tokens, nullptr);
-    return balance(normalized, "", nullptr);
+    return balance(normalized, LineIndex(""), nullptr);
   }
 
 private:
@@ -54,6 +106,149 @@ private:
     bool synthetic = false;
   };
 
+  // The part of a file's token stream the checks can see from one position:
+  // up to behind tokens before it and ahead tokens after it, or up to EOF.
+  // Comments are left out, and index is 0 only at the start of the file.
+  class TokenWindow {
+    static constexpr size_t behind = 2;
+    static constexpr size_t ahead = 6;
+
+    Lexer lexer;
+    bool lexed_eof = false;
+
+    void fill() {
+      while (!lexed_eof && tokens.size() <= index + ahead) {
+        Token token = lexer.next_token();
+        if (is_comment_token(token.type))
+          continue;
+        tokens.push_back(token);
+        normalized.push_back({token, false});
+        lexed_eof = is_eof(token.type);
+      }
+    }
+
+  public:
+    std::vector<Token> tokens;
+    // The same tokens, as the bracket checks take them.
+    std::vector<HealingToken> normalized;
+    size_t index = 0;
+
+    explicit TokenWindow(SourceFile &source) : lexer(source) { fill(); }
+
+    const Token &current() const { return tokens[index]; }
+
+    void advance() {
+      if (++index > behind) {
+        tokens.erase(tokens.begin());
+        normalized.erase(normalized.begin());
+        --index;
+      }
+      fill();
+    }
+  };
+
+  // A token list walked the way TokenWindow walks a stream. Like normalize(),
+  // it ends at the first EOF and supplies one when the list has none.
+  class TokenList {
+  public:
+    std::vector<Token> tokens;
+    std::vector<HealingToken> normalized;
+    size_t index = 0;
+
+    explicit TokenList(const std::vector<Token> &list) {
+      for (const Token &token : list) {
+        if (is_eof(token.type))
+          break;
+        tokens.push_back(token);
+      }
+      int eof_line = list.empty() ? 0 : list.back().line;
+      int eof_column = list.empty() ? 0 : list.back().column;
+      tokens.push_back({T_EOF, "", eof_line, eof_column});
+      normalized.reserve(tokens.size());
+      for (const Token &token : tokens) {
+        normalized.push_back({token, false});
+      }
+    }
+
+    const Token &current() const { return tokens[index]; }
+    void advance() { ++index; }
+  };
+
+  // is_balanced one token at a time. step returns false once normalize() or
+  // balance() would have to change something; at EOF it also checks that
+  // every bracket was closed.
+  struct BalanceScan {
+    std::vector<Token> stack;
+    Token previous;
+
+    bool step(const std::vector<Token> &tokens,
+              const std::vector<HealingToken> &normalized, size_t index) {
+      if (should_close_brace_before(normalized, index, stack, previous) ||
+          should_close_paren_before(normalized, index, stack, previous)) {
+        return false;
+      }
+      const Token &token = tokens[index];
+      if (is_eof(token.type))
+        return stack.empty();
+
+      if (expects_paren_after(tokens, index) &&
+          (index + 1 >= tokens.size() || tokens[index + 1].type != T_LPAREN)) {
+        return false;
+      }
+      if (is_type(token.type)) {
+        // Nothing has been inserted, so what normalize() would have output
+        // so far ends with the same tokens.
+        std::vector<HealingToken> out(
+            normalized.begin() + index - std::min<size_t>(index, 2),
+            normalized.begin() + index + 1);
+        if (should_insert_equal_after_type(out, tokens, index))
+          return false;
+      }
+      if (should_insert_comma_before(normalized, index, stack, previous))
+        return false;
+
+      if (is_close(token.type)) {
+        if (stack.empty() || !matches(stack.back().type, token.type))
+          return false;
+        stack.pop_back();
+      } else if (is_open(token.type)) {
+        stack.push_back(token);
+      }
+      previous = token;
+      return true;
+    }
+  };
+
+  // Whether normalize(), balance() or the typo checks would change the
+  // tokens a Window reads from input. The first pass gathers what the typo
+  // checks need from the whole file; the second stops at the first edit.
+  template <typename Window, typename Input>
+  static bool find_repairs(Input &input, size_t &tokens) {
+    FileFacts facts;
+    tokens = 0;
+    for (Window window(input);; window.advance()) {
+      ++tokens;
+      facts.add(window.tokens, window.index);
+      if (is_eof(window.current().type))
+        break;
+    }
+
+    BalanceScan balance;
+    TypoScan typos{facts};
+    std::vector<TextEdit> edits;
+    for (Window window(input);; window.advance()) {
+      if (!balance.step(window.tokens, window.normalized, window.index))
+        return true;
+      if (is_eof(window.current().type))
+        break;
+      typos.step(window.tokens, window.index, edits);
+      if (!edits.empty())
+        return true;
+    }
+    typos.finish(edits);
+    return !edits.empty();
+  }
+
   struct TextEdit {
     enum class Kind { Insert, Erase, Replace };
 
@@ -67,6 +262,60 @@ private:
     std::string message;
   };
 
+  // Start offset of every line of one text, so that turning a (line, column)
+  // pair into an offset is a lookup instead of a rescan.
+  class LineIndex {
+    std::string_view source;
+    std::vector<size_t> starts;
+
+    size_t line_end(size_t line) const {
+      size_t start = starts[line - 1];
+      size_t end = line < starts.size() ? starts[line] - 1 : source.size();
+      if (end > start && source[end - 1] == '\n') {
+        end--;
+      }
+      if (end > start && source[end - 1] == '\r') {
+        end--;
+      }
+      return end;
+    }
+
+  public:
+    explicit LineIndex(std::string_view source) : source(source) {
+      starts.push_back(0);
+      for (size_t i = 0; i < source.size(); ++i) {
+        if (source[i] == '\n' && i + 1 < source.size()) {
+          starts.push_back(i + 1);
+        }
+      }
+    }
+
+    std::string_view text() const { return source; }
+    size_t line_count() const { return starts.size(); }
+
+    size_t line_end_column(int line) const {
+      if (line <= 0 || static_cast<size_t>(line) > starts.size()) {
+        return source.empty() ? 1 : source.size() + 1;
+      }
+      size_t index = static_cast<size_t>(line);
+      return line_end(index) - starts[index - 1] + 1;
+    }
+
+    size_t offset_for(int line, int column) const {
+      if (line <= 0 || static_cast<size_t>(line) > starts.size())
+        return source.size();
+
+      size_t index = static_cast<size_t>(line);
+      size_t start = starts[index - 1];
+      size_t line_length = line_end(index) - start;
+      size_t safe_column = column <= 0 ? 0 : static_cast<size_t>(column - 1);
+      if (safe_column > line_length) {
+        safe_column = line_length;
+      }
+      return start + safe_column;
+    }
+  };
+
   static bool is_comment_token(TokenType type) {
     return type == T_LINE_COMMENT || type == T_BLOCK_COMMENT;
   }
@@ -83,6 +332,19 @@ private:
     return filtered;
   }
 
+  static std::vector<Token> tokenize(SourceFile &source) {
+    std::vector<Token> tokens;
+    Lexer lexer(source);
+    Token token;
+    do {
+      token = lexer.next_token();
+      if (!is_comment_token(token.type)) {
+        tokens.push_back(token);
+      }
+    } while (!is_eof(token.type));
+    return tokens;
+  }
+
   static bool is_eof(TokenType type) { return type == T_EOF; }
 
   static bool is_type(TokenType type) {
@@ -121,28 +383,8 @@ private:
            (open == T_LBRACE && close == T_RBRACE);
   }
 
-  static const char *token_value(TokenType type) {
-    switch (type) {
-    case T_LPAREN:
-      return "(";
-    case T_RPAREN:
-      return ")";
-    case T_LBRACE:
-      return "{";
-    case T_RBRACE:
-      return "}";
-    case T_COMMA:
-      return ",";
-    case T_EQUAL:
-      return "=";
-    case T_PLUS:      
-    default:
-      return "";
-    }
-  }
-
   static Token synthetic(TokenType type, int line, int column) {
-    return {type, token_value(type), line, column};
+    return {type, token_spelling(type), line, column};
   }
 
   static bool can_end_expression(TokenType type) {
@@ -400,26 +642,6 @@ private:
     return edit;
   }
 
-  static size_t line_end_column(const std::string &source, int line) {
-    std::vector<size_t> starts = line_starts(source);
-    if (line <= 0 || static_cast<size_t>(line) > starts.size()) {
-      return source.empty() ? 1 : source.size() + 1;
-    }
-
-    size_t start = starts[static_cast<size_t>(line - 1)];
-    size_t end = source.size();
-    if (static_cast<size_t>(line) < starts.size()) {
-      end = starts[static_cast<size_t>(line)] - 1;
-    }
-    if (end > start && source[end - 1] == '\n') {
-      end--;
-    }
-    if (end > start && source[end - 1] == '\r') {
-      end--;
-    }
-    return end - start + 1;
-  }
-
   static TextEdit insert_after_token(const Token &token,
                                      const std::string &text,
                                      const std::string &message, size_t order) {
@@ -435,12 +657,12 @@ private:
     return make_insert(token.line, token.column, text, message, order);
   }
 
-  static TextEdit insert_at_line_end(const std::string &source,
+  static TextEdit insert_at_line_end(const LineIndex &lines,
                                      const Token &token,
                                      const std::string &text,
                                      const std::string &message, size_t order) {
     return make_insert(token.line,
-                       static_cast<int>(line_end_column(source, token.line)),
+                       static_cast<int>(lines.line_end_column(token.line)),
                        text, message, order);
   }
 
@@ -451,13 +673,13 @@ private:
     return make_insert(token.line, 1, text, message, order);
   }
 
-  static TextEdit append_to_source(const std::string &source,
+  static TextEdit append_to_source(const LineIndex &lines,
                                    const std::string &text,
                                    const std::string &message, size_t order) {
-    std::vector<size_t> starts = line_starts(source);
+    std::string_view source = lines.text();
     bool ends_with_newline = !source.empty() && source.back() == '\n';
-    int line = static_cast<int>(starts.empty() ? 1 : starts.size());
-    int column = static_cast<int>(line_end_column(source, line));
+    int line = static_cast<int>(lines.line_count());
+    int column = static_cast<int>(lines.line_end_column(line));
     if (ends_with_newline) {
       line++;
       column = 1;
@@ -466,7 +688,7 @@ private:
   }
 
   static TextEdit
-  replace_gap_after_token(const std::string &source, const Token &previous,
+  replace_gap_after_token(const LineIndex &lines, const Token &previous,
                           const Token &current, const std::string &text,
                           const std::string &message, size_t order) {
     TextEdit edit;
@@ -478,8 +700,8 @@ private:
     edit.order = order;
     edit.message = message;
 
-    size_t start = offset_for(source, edit.line, edit.column);
-    size_t end = offset_for(source, current.line, current.column);
+    size_t start = lines.offset_for(edit.line, edit.column);
+    size_t end = lines.offset_for(current.line, current.column);
     edit.length = end > start ? end - start : 0;
     return edit;
   }
@@ -492,25 +714,26 @@ private:
     return "missing token was inserted";
   }
 
-  static TextEdit close_edit(const std::string &source, TokenType close_type,
+  static TextEdit close_edit(const LineIndex &lines, TokenType close_type,
                              const Token &current, bool at_eof,
                              const Token &previous, size_t order) {
-    std::string text = token_value(close_type);
+    std::string text(token_spelling(close_type));
     std::string message = close_message(close_type);
 
     if (at_eof) {
+      std::string_view source = lines.text();
       if (close_type == T_RBRACE) {
         std::string prefix =
             source.empty() || source.back() == '\n' ? "" : "\n";
-        return append_to_source(source, prefix + text, message, order);
+        return append_to_source(lines, prefix + text, message, order);
       }
-      return append_to_source(source, text, message, order);
+      return append_to_source(lines, text, message, order);
     }
 
     if (close_type == T_RBRACE) {
       if (current.type == T_RETURN && previous.type == T_NUMBER &&
           previous.value == "1" && current.line > previous.line) {
-        return replace_gap_after_token(source, previous, current,
+        return replace_gap_after_token(lines, previous, current,
                                        "\n" + text + "\n\n", message, order);
       }
       return insert_line_before_token(current, text + "\n", message, order);
@@ -520,7 +743,7 @@ private:
       return insert_before_token(current, text, message, order);
     }
 
-    return insert_at_line_end(source, previous, text, message, order);
+    return insert_at_line_end(lines, previous, text, message, order);
   }
 
   static std::vector<HealingToken> normalize(const std::vector<Token> &tokens,
@@ -566,7 +789,7 @@ private:
   }
 
   static void close_top(std::vector<Token> &out, std::vector<Token> &stack,
-                        const std::string &source, std::vector<TextEdit> *edits,
+                        const LineIndex &lines, std::vector<TextEdit> *edits,
                         const Token &current, bool at_eof,
                         const Token &previous) {
     Token open = stack.back();
@@ -576,13 +799,13 @@ private:
     out.push_back(inserted);
 
     if (edits) {
-      edits->push_back(close_edit(source, close_type, current, at_eof, previous,
+      edits->push_back(close_edit(lines, close_type, current, at_eof, previous,
                                   edits->size()));
     }
   }
 
   static std::vector<Token> balance(const std::vector<HealingToken> &tokens,
-                                    const std::string &source,
+                                    const LineIndex &lines,
                                     std::vector<TextEdit> *edits) {
     std::vector<Token> out;
     std::vector<Token> stack;
@@ -596,12 +819,12 @@ private:
       bool at_eof = is_eof(token.type);
 
       while (should_close_brace_before(tokens, i, stack, previous)) {
-        close_top(out, stack, source, edits, token, at_eof, previous);
+        close_top(out, stack, lines, edits, token, at_eof, previous);
         previous = out.back();
       }
 
       while (should_close_paren_before(tokens, i, stack, previous)) {
-        close_top(out, stack, source, edits, token, at_eof, previous);
+        close_top(out, stack, lines, edits, token, at_eof, previous);
         previous = out.back();
       }
 
@@ -616,7 +839,7 @@ private:
             edits->push_back(insert_before_token(
                 token, ",", "missing ',' was inserted", edits->size()));
           } else {
-            edits->push_back(insert_at_line_end(source, previous, ",",
+            edits->push_back(insert_at_line_end(lines, previous, ",",
                                                 "missing ',' was inserted",
                                                 edits->size()));
           }
@@ -628,7 +851,7 @@ private:
         bool skip_current = false;
         while (!stack.empty() && !matches(stack.back().type, token.type)) {
           if (stack.back().type == T_LPAREN) {
-            close_top(out, stack, source, edits, token, false, previous);
+            close_top(out, stack, lines, edits, token, false, previous);
             previous = out.back();
             continue;
           }
@@ -659,7 +882,7 @@ private:
     }
 
     while (!stack.empty()) {
-      close_top(out, stack, source, edits, previous, true, previous);
+      close_top(out, stack, lines, edits, previous, true, previous);
       previous = out.back();
     }
 
@@ -669,7 +892,7 @@ private:
     return out;
   }
 
-  static std::vector<TextEdit> plan_edits(const std::string &source,
+  static std::vector<TextEdit> plan_edits(const LineIndex &lines,
                                           const std::vector<Token> &tokens) {
     std::vector<TextEdit> typo_edits = plan_typo_edits(tokens);
     if (!typo_edits.empty()) {
@@ -678,11 +901,11 @@ private:
 
     std::vector<TextEdit> edits;
     std::vector<HealingToken> normalized = normalize(tokens, &edits);
-    balance(normalized, source, &edits);
+    balance(normalized, lines, &edits);
     return edits;
   }
 
-  static std::string lower_ascii(const std::string &value) {
+  static std::string lower_ascii(std::string_view value) {
     std::string lowered;
     lowered.reserve(value.size());
     for (char raw_ch : value) {
@@ -714,7 +937,7 @@ private:
     return previous[right.size()];
   }
 
-  static size_t typo_threshold(const std::string &word,
+  static size_t typo_threshold(std::string_view word,
                                const std::string &candidate,
                                bool strong_context) {
     size_t length_delta = word.size() > candidate.size()
@@ -730,16 +953,25 @@ private:
     return candidate.size() <= 4 ? 1 : 2;
   }
 
-  static size_t typo_score(const std::string &word,
+  static size_t typo_score(std::string_view word,
                            const std::string &candidate, bool strong_context) {
     std::string lowered_word = lower_ascii(word);
     std::string lowered_candidate = lower_ascii(candidate);
     if (lowered_word == lowered_candidate)
       return 0;
 
+    // The distance is never below the length difference, so most words are
+    // ruled out without computing it.
+    size_t threshold =
+        typo_threshold(lowered_word, lowered_candidate, strong_context);
+    size_t length_delta = lowered_word.size() > lowered_candidate.size()
+                              ? lowered_word.size() - lowered_candidate.size()
+                              : lowered_candidate.size() - lowered_word.size();
+    if (length_delta > threshold)
+      return impossible_score();
+
     size_t distance = edit_distance(lowered_word, lowered_candidate);
-    if (distance <=
-        typo_threshold(lowered_word, lowered_candidate, strong_context)) {
+    if (distance <= threshold) {
       return distance;
     }
     return impossible_score();
@@ -764,7 +996,7 @@ private:
   }
 
   static bool contains_word(const std::vector<std::string> &values,
-                            const std::string &word) {
+                            std::string_view word) {
     for (const auto &value : values) {
       if (value == word)
         return true;
@@ -772,14 +1004,7 @@ private:
     return false;
   }
 
-  static void add_unique_word(std::vector<std::string> &values,
-                              const std::string &word) {
-    if (word.empty() || contains_word(values, word))
-      return;
-    values.push_back(word);
-  }
-
-  static std::string best_word(const std::string &word,
+  static std::string best_word(std::string_view word,
                                const std::vector<std::string> &candidates,
                                bool strong_context) {
     std::string best;
@@ -803,131 +1028,172 @@ private:
     return ambiguous ? "" : best;
   }
 
-  static std::vector<std::string> type_words() {
-    return {"int", "float", "string", "bool", "bytes", "object", "array"};
+  static const std::vector<std::string> &type_words() {
+    static const std::vector<std::string> words = {
+        "int", "float", "string", "bool", "bytes", "object", "array"};
+    return words;
   }
 
-  static std::vector<std::string> statement_words() {
-    return {"package", "from",  "import", "function", "class",
-            "return",  "if",    "else",   "while",    "call",
-            "cout",    "print", "printg", "println"};
+  static const std::vector<std::string> &statement_words() {
+    static const std::vector<std::string> words = {
+        "package", "from",  "import", "function", "class",
+        "return",  "if",    "else",   "while",    "call",
+        "cout",    "print", "printg", "println"};
+    return words;
   }
 
-  static std::vector<std::string> plain_builtin_words() {
-    return {"protocol",     "json_parse",   "json_stringify",
-            "read_file",    "open_log",     "request_method",
-            "request_path", "request_body", "request_json",
-            "log",          "log_output",   "set_log_output",
-            "log_console",  "log_file",     "log_trace",
-            "log_debug",    "log_info",     "log_notice",
-            "log_warn",     "log_warning",  "log_error",
-            "log_critical", "log_critecal", "log_fatal"};
+  static const std::vector<std::string> &plain_builtin_words() {
+    static const std::vector<std::string> words = {
+        "protocol",     "json_parse",   "json_stringify",
+        "read_file",    "open_log",     "request_method",
+        "request_path", "request_body", "request_json",
+        "log",          "log_output",   "set_log_output",
+        "log_console",  "log_file",     "log_trace",
+        "log_debug",    "log_info",     "log_notice",
+        "log_warn",     "log_warning",  "log_error",
+        "log_critical", "log_critecal", "log_fatal"};
+    return words;
   }
 
-  static bool is_plain_builtin_word(const std::string &word) {
+  static const std::vector<std::string> &call_builtin_words() {
+    static const std::vector<std::string> words = [] {
+      std::vector<std::string> all = plain_builtin_words();
+      all.push_back("print");
+      all.push_back("printg");
+      all.push_back("println");
+      all.push_back("cout");
+      return all;
+    }();
+    return words;
+  }
+
+  static bool is_plain_builtin_word(std::string_view word) {
     return contains_word(plain_builtin_words(), word);
   }
 
-  static std::vector<std::string>
-  callable_words(const std::vector<Token> &tokens) {
+  // Functions a file declares or imports, in first-seen order (candidates
+  // are tried in that order), with a set for membership tests.
+  struct Callables {
     std::vector<std::string> words;
+    std::unordered_set<std::string_view> known;
 
-    for (size_t i = 0; i < tokens.size(); ++i) {
-      if (is_eof(tokens[i].type))
-        break;
+    bool contains(std::string_view word) const {
+      return known.count(word) != 0;
+    }
 
-      if (tokens[i].type == T_IMPORT) {
-        int import_line = tokens[i].line;
-        for (size_t j = i + 1;
-             j < tokens.size() && tokens[j].line == import_line; ++j) {
-          if (tokens[j].type == T_IDENTIFIER) {
-            add_unique_word(words, tokens[j].value);
-          }
-        }
-        continue;
+    void add(std::string_view word) {
+      if (!word.empty() && known.insert(word).second) {
+        words.emplace_back(word);
+      }
+    }
+  };
+
+  // What the typo checks need to know about the whole file before they look
+  // at any one token, gathered one token at a time.
+  struct FileFacts {
+    bool package_main = false;
+    Callables callables;
+    int import_line = 0;
+
+    void add(const std::vector<Token> &tokens, size_t index) {
+      const Token &token = tokens[index];
+      if (index > 0 && tokens[index - 1].type == T_PACKAGE &&
+          token.type == T_IDENTIFIER && token.value == "main") {
+        package_main = true;
       }
+      if (is_eof(token.type))
+        return;
 
-      if (tokens[i].type != T_FUNCTION) {
-        continue;
+      // Every identifier on an import's line names something it imports.
+      if (token.type == T_IMPORT) {
+        import_line = token.line;
+      } else if (token.type == T_IDENTIFIER && import_line > 0 &&
+                 token.line == import_line) {
+        callables.add(token.value);
       }
-      if (i + 2 < tokens.size() && tokens[i + 1].type == T_LPAREN &&
-          tokens[i + 2].type == T_IDENTIFIER) {
-        add_unique_word(words, tokens[i + 2].value);
-      } else if (i + 1 < tokens.size() && tokens[i + 1].type == T_IDENTIFIER) {
-        add_unique_word(words, tokens[i + 1].value);
+      if (token.type != T_FUNCTION)
+        return;
+      if (index + 2 < tokens.size() && tokens[index + 1].type == T_LPAREN &&
+          tokens[index + 2].type == T_IDENTIFIER) {
+        callables.add(tokens[index + 2].value);
+      } else if (index + 1 < tokens.size() &&
+                 tokens[index + 1].type == T_IDENTIFIER) {
+        callables.add(tokens[index + 1].value);
       }
     }
-
-    return words;
-  }
+  };
 
   struct BuiltinPair {
     const char *root;
     const char *member;
   };
 
-  static std::vector<BuiltinPair> builtin_pairs() {
-    return {{"web", "route"},
-            {"web", "get"},
-            {"web", "post"},
-            {"web", "serve"},
-            {"web", "run"},
-            {"net", "get"},
-            {"net", "post"},
-            {"net", "serve"},
-            {"net", "run"},
-            {"log", "output"},
-            {"log", "set_output"},
-            {"log", "console"},
-            {"log", "file"},
-            {"log", "trace"},
-            {"log", "debug"},
-            {"log", "info"},
-            {"log", "notice"},
-            {"log", "warn"},
-            {"log", "warning"},
-            {"log", "error"},
-            {"log", "critical"},
-            {"log", "critecal"},
-            {"log", "fatal"},
-            {"json", "parse"},
-            {"json", "decode"},
-            {"json", "unmarshal"},
-            {"json", "stringify"},
-            {"json", "encode"},
-            {"json", "marshal"},
-            {"json", "write"},
-            {"json", "save"},
-            {"json", "read"},
-            {"json", "get"},
-            {"json", "object"},
-            {"auth", "hash_password"},
-            {"auth", "verify_password"},
-            {"jwt", "sign"},
-            {"jwt", "verify"},
-            {"sql", "open"},
-            {"sql", "connect"},
-            {"sql", "exec"},
-            {"sql", "table"},
-            {"sql", "insert"},
-            {"sql", "find"},
-            {"orm", "table"},
-            {"orm", "migrate"},
-            {"orm", "save"},
-            {"orm", "find"},
-            {"request", "method"},
-            {"request", "path"},
-            {"request", "body"},
-            {"request", "json"},
-            {"create", "file"},
-            {"write", "file"},
-            {"read", "file"},
-            {"close", "file"},
-            {"delete", "file"}};
-  }
-
-  static bool is_exact_builtin_pair(const std::string &root,
-                                    const std::string &member) {
+  static const std::vector<BuiltinPair> &builtin_pairs() {
+    static const std::vector<BuiltinPair> pairs = {{"web", "route"},
+                                                   {"web", "get"},
+                                                   {"web", "post"},
+                                                   {"web", "serve"},
+                                                   {"web", "run"},
+                                                   {"net", "get"},
+                                                   {"net", "post"},
+                                                   {"net", "serve"},
+                                                   {"net", "run"},
+                                                   {"log", "output"},
+                                                   {"log", "set_output"},
+                                                   {"log", "console"},
+                                                   {"log", "file"},
+                                                   {"log", "trace"},
+                                                   {"log", "debug"},
+                                                   {"log", "info"},
+                                                   {"log", "notice"},
+                                                   {"log", "warn"},
+                                                   {"log", "warning"},
+                                                   {"log", "error"},
+                                                   {"log", "critical"},
+                                                   {"log", "critecal"},
+                                                   {"log", "fatal"},
+                                                   {"json", "parse"},
+                                                   {"json", "decode"},
+                                                   {"json", "unmarshal"},
+                                                   {"json", "stringify"},
+                                                   {"json", "encode"},
+                                                   {"json", "marshal"},
+                                                   {"json", "write"},
+                                                   {"json", "save"},
+                                                   {"json", "read"},
+                                                   {"json", "get"},
+                                                   {"json", "object"},
+                                                   {"auth", "hash_password"},
+                                                   {"auth", "verify_password"},
+                                                   {"jwt", "sign"},
+                                                   {"jwt", "verify"},
+                                                   {"sql", "open"},
+                                                   {"sql", "connect"},
+                                                   {"sql", "exec"},
+                                                   {"sql", "table"},
+                                                   {"sql", "insert"},
+                                                   {"sql", "find"},
+                                                   {"orm", "table"},
+                                                   {"orm", "migrate"},
+                                                   {"orm", "save"},
+                                                   {"orm", "find"},
+                                                   {"request", "method"},
+                                                   {"request", "path"},
+                                                   {"request", "body"},
+                                                   {"request", "json"},
+                                                   {"request", "query"},
+                                                   {"request", "header"},
+                                                   {"request", "param"},
+                                                   {"create", "file"},
+                                                   {"write", "file"},
+                                                   {"read", "file"},
+                                                   {"close", "file"},
+                                                   {"delete", "file"}};
+    return pairs;
+  }
+
+  static bool is_exact_builtin_pair(std::string_view root,
+                                    std::string_view member) {
     for (const auto &pair : builtin_pairs()) {
       if (root == pair.root && member == pair.member) {
         return true;
@@ -936,10 +1202,10 @@ private:
     return false;
   }
 
-  static std::string correction_message(const std::string &original,
+  static std::string correction_message(std::string_view original,
                                         const std::string &replacement) {
-    return "syntax typo '" + original + "' was corrected to '" + replacement +
-           "'";
+    return "syntax typo '" + std::string(original) + "' was corrected to '" +
+           replacement + "'";
   }
 
   static void add_replace_if_needed(std::vector<TextEdit> &edits,
@@ -986,44 +1252,11 @@ private:
     }
 
     edits.push_back(make_erase(
-        token, "invalid numeric suffix '" + token.value + "' was removed",
+        token,
+        "invalid numeric suffix '" + std::string(token.value) + "' was removed",
         edits.size()));
   }
 
-  static bool has_package_main(const std::vector<Token> &tokens) {
-    for (size_t i = 0; i + 1 < tokens.size(); ++i) {
-      if (tokens[i].type == T_PACKAGE && tokens[i + 1].type == T_IDENTIFIER &&
-          tokens[i + 1].value == "main") {
-        return true;
-      }
-    }
-    return false;
-  }
-
-  static int brace_depth_before(const std::vector<Token> &tokens,
-                                size_t index) {
-    int depth = 0;
-    for (size_t i = 0; i < index; ++i) {
-      if (tokens[i].type == T_LBRACE) {
-        depth++;
-      } else if (tokens[i].type == T_RBRACE && depth > 0) {
-        depth--;
-      }
-    }
-    return depth;
-  }
-
-  static bool only_closing_braces_after(const std::vector<Token> &tokens,
-                                        size_t index) {
-    for (size_t i = index + 1; i < tokens.size(); ++i) {
-      if (is_eof(tokens[i].type))
-        return true;
-      if (tokens[i].type != T_RBRACE)
-        return false;
-    }
-    return true;
-  }
-
   static bool previous_statement_is_return_one(const std::vector<Token> &tokens,
                                                size_t index) {
     if (index < 2)
@@ -1034,29 +1267,6 @@ private:
            tokens[value_index - 1].type == T_RETURN;
   }
 
-  static void add_main_exit_return_edits(std::vector<TextEdit> &edits,
-                                         const std::vector<Token> &tokens,
-                                         size_t index, bool package_main) {
-    if (!package_main || index + 1 >= tokens.size())
-      return;
-    const Token &token = tokens[index];
-    const Token &value = tokens[index + 1];
-    if (token.type != T_RETURN || value.type != T_NUMBER)
-      return;
-    if (value.value == "0" || !only_closing_braces_after(tokens, index + 1)) {
-      return;
-    }
-
-    int depth = brace_depth_before(tokens, index);
-    if (depth > 0 && !previous_statement_is_return_one(tokens, index)) {
-      return;
-    }
-
-    edits.push_back(make_replace(
-        value, "0", "main exit code '" + value.value + "' was corrected to '0'",
-        edits.size()));
-  }
-
   static bool add_malformed_network_call_edits(std::vector<TextEdit> &edits,
                                                const std::vector<Token> &tokens,
                                                size_t index) {
@@ -1213,7 +1423,7 @@ private:
     return {};
   }
 
-  static bool has_keyword_prefix_damage(const std::string &word,
+  static bool has_keyword_prefix_damage(std::string_view word,
                                         const std::string &candidate) {
     std::string lowered_word = lower_ascii(word);
     std::string lowered_candidate = lower_ascii(candidate);
@@ -1225,7 +1435,7 @@ private:
     return prefix >= std::min<size_t>(5, lowered_candidate.size() - 1);
   }
 
-  static bool has_repeated_extra_suffix(const std::string &word,
+  static bool has_repeated_extra_suffix(std::string_view word,
                                         const std::string &candidate,
                                         size_t max_suffix_length = 3) {
     std::string lowered_word = lower_ascii(word);
@@ -1244,7 +1454,7 @@ private:
                        [&](char ch) { return ch == suffix.front(); });
   }
 
-  static bool contains_candidate_as_subsequence(const std::string &word,
+  static bool contains_candidate_as_subsequence(std::string_view word,
                                                 const std::string &candidate) {
     std::string lowered_word = lower_ascii(word);
     std::string lowered_candidate = lower_ascii(candidate);
@@ -1265,7 +1475,7 @@ private:
     return candidate_index == lowered_candidate.size();
   }
 
-  static size_t noisy_callable_score(const std::string &word,
+  static size_t noisy_callable_score(std::string_view word,
                                      const std::string &candidate) {
     size_t normal_score = typo_score(word, candidate, false);
     if (normal_score < impossible_score())
@@ -1280,7 +1490,7 @@ private:
   }
 
   static std::string
-  best_callable_word(const std::string &word,
+  best_callable_word(std::string_view word,
                      const std::vector<std::string> &candidates) {
     std::string best;
     size_t best_score = impossible_score();
@@ -1303,7 +1513,7 @@ private:
     return ambiguous ? "" : best;
   }
 
-  static size_t strong_statement_score(const std::string &word,
+  static size_t strong_statement_score(std::string_view word,
                                        const std::string &candidate) {
     size_t normal_score = typo_score(word, candidate, false);
     if (normal_score < impossible_score())
@@ -1320,7 +1530,7 @@ private:
   }
 
   static std::string
-  best_strong_statement_word(const std::string &word,
+  best_strong_statement_word(std::string_view word,
                              const std::vector<std::string> &candidates) {
     std::string best;
     size_t best_score = impossible_score();
@@ -1345,8 +1555,7 @@ private:
 
   static void add_word_typo_edits(std::vector<TextEdit> &edits,
                                   const std::vector<Token> &tokens,
-                                  size_t index,
-                                  const std::vector<std::string> &callables) {
+                                  size_t index, const Callables &callables) {
     const Token &token = tokens[index];
     if (token.type != T_IDENTIFIER)
       return;
@@ -1384,15 +1593,15 @@ private:
     }
 
     if (index + 1 < tokens.size() && tokens[index + 1].type == T_LPAREN &&
-        (contains_word(callables, token.value) ||
+        (callables.contains(token.value) ||
          is_plain_builtin_word(token.value))) {
       return;
     }
 
     if (index + 1 < tokens.size() && tokens[index + 1].type == T_LPAREN &&
-        !contains_word(callables, token.value)) {
+        !callables.contains(token.value)) {
       std::string callable_replacement =
-          best_callable_word(token.value, callables);
+          best_callable_word(token.value, callables.words);
       if (!callable_replacement.empty()) {
         add_replace_if_needed(edits, token, callable_replacement);
         return;
@@ -1400,78 +1609,89 @@ private:
     }
 
     if (index + 1 < tokens.size() && tokens[index + 1].type == T_LPAREN) {
-      std::vector<std::string> builtin_words = plain_builtin_words();
-      builtin_words.push_back("print");
-      builtin_words.push_back("printg");
-      builtin_words.push_back("println");
-      builtin_words.push_back("cout");
       std::string builtin_replacement =
-          best_word(token.value, builtin_words, false);
+          best_word(token.value, call_builtin_words(), false);
       add_replace_if_needed(edits, token, builtin_replacement);
     }
   }
 
-  static std::vector<TextEdit>
-  plan_typo_edits(const std::vector<Token> &tokens) {
-    std::vector<TextEdit> edits;
-    bool package_main = has_package_main(tokens);
-    std::vector<std::string> callables = callable_words(tokens);
-    for (size_t i = 0; i < tokens.size(); ++i) {
-      if (is_eof(tokens[i].type))
-        break;
-      add_numeric_suffix_edits(edits, tokens, i);
-      add_main_exit_return_edits(edits, tokens, i, package_main);
-      if (add_malformed_network_call_edits(edits, tokens, i)) {
-        continue;
+  // The typo checks one token at a time. A main exit code is only wrong
+  // when nothing but closing braces follows it, so its edit waits for
+  // finish.
+  struct TypoScan {
+    const FileFacts &facts;
+    int depth = 0;
+    // Tokens to pass before exit_code is the file's last statement, or -1
+    // when there is no such exit code.
+    int exit_code_pending = -1;
+    Token exit_code{};
+
+    void step(const std::vector<Token> &tokens, size_t index,
+              std::vector<TextEdit> &edits) {
+      const Token &token = tokens[index];
+      if (exit_code_pending > 0) {
+        --exit_code_pending;
+      } else if (exit_code_pending == 0 && token.type != T_RBRACE) {
+        exit_code_pending = -1;
+      }
+      if (facts.package_main && token.type == T_RETURN &&
+          index + 1 < tokens.size() && tokens[index + 1].type == T_NUMBER &&
+          tokens[index + 1].value != "0" &&
+          (depth == 0 || previous_statement_is_return_one(tokens, index))) {
+        exit_code = tokens[index + 1];
+        exit_code_pending = 1;
+      }
+      if (token.type == T_LBRACE) {
+        depth++;
+      } else if (token.type == T_RBRACE && depth > 0) {
+        depth--;
       }
-      add_namespace_typo_edits(edits, tokens, i);
-      add_word_typo_edits(edits, tokens, i, callables);
-    }
-    return edits;
-  }
 
-  static std::vector<size_t> line_starts(const std::string &source) {
-    std::vector<size_t> starts;
-    starts.push_back(0);
-    for (size_t i = 0; i < source.size(); ++i) {
-      if (source[i] == '\n' && i + 1 < source.size()) {
-        starts.push_back(i + 1);
+      add_numeric_suffix_edits(edits, tokens, index);
+      if (add_malformed_network_call_edits(edits, tokens, index)) {
+        return;
       }
+      add_namespace_typo_edits(edits, tokens, index);
+      add_word_typo_edits(edits, tokens, index, facts.callables);
     }
-    return starts;
-  }
-
-  static size_t offset_for(const std::string &source, int line, int column) {
-    std::vector<size_t> starts = line_starts(source);
-    if (line <= 0 || starts.empty())
-      return source.size();
-    if (static_cast<size_t>(line) > starts.size())
-      return source.size();
 
-    size_t start = starts[static_cast<size_t>(line - 1)];
-    size_t end = source.size();
-    if (static_cast<size_t>(line) < starts.size()) {
-      end = starts[static_cast<size_t>(line)] - 1;
-    }
-    if (end > start && source[end - 1] == '\n') {
-      end--;
+    void finish(std::vector<TextEdit> &edits) const {
+      if (exit_code_pending < 0)
+        return;
+      edits.push_back(make_replace(exit_code, "0",
+                                   "main exit code '" +
+                                       std::string(exit_code.value) +
+                                       "' was corrected to '0'",
+                                   edits.size()));
     }
-    if (end > start && source[end - 1] == '\r') {
-      end--;
+  };
+
+  static std::vector<TextEdit>
+  plan_typo_edits(const std::vector<Token> &tokens) {
+    FileFacts facts;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+      facts.add(tokens, i);
+      if (is_eof(tokens[i].type))
+        break;
     }
 
-    size_t safe_column = column <= 0 ? 0 : static_cast<size_t>(column - 1);
-    size_t line_length = end - start;
-    if (safe_column > line_length) {
-      safe_column = line_length;
+    std::vector<TextEdit> edits;
+    TypoScan scan{facts};
+    for (size_t i = 0; i < tokens.size() && !is_eof(tokens[i].type); ++i) {
+      scan.step(tokens, i, edits);
     }
-    return start + safe_column;
+    scan.finish(edits);
+    return edits;
   }
 
-  static std::string apply_edits(const std::string &source,
+  // Edits are applied back to front, each at the start of the already
+  // rewritten tail, which is kept reversed so that every edit only touches
+  // its end. Same result as editing a copy of source in place, in one pass.
+  static std::string apply_edits(const LineIndex &lines,
                                  std::vector<TextEdit> edits) {
+    std::string_view source = lines.text();
     for (auto &edit : edits) {
-      edit.offset = offset_for(source, edit.line, edit.column);
+      edit.offset = lines.offset_for(edit.line, edit.column);
     }
 
     std::stable_sort(edits.begin(), edits.end(),
@@ -1481,19 +1701,25 @@ private:
                        return left.order > right.order;
                      });
 
-    std::string result = source;
+    std::string tail;
+    size_t cursor = source.size();
     for (const auto &edit : edits) {
-      size_t offset = std::min(edit.offset, result.size());
-      if (edit.kind == TextEdit::Kind::Erase) {
-        size_t length = std::min(edit.length, result.size() - offset);
-        result.erase(offset, length);
-      } else if (edit.kind == TextEdit::Kind::Replace) {
-        size_t length = std::min(edit.length, result.size() - offset);
-        result.replace(offset, length, edit.text);
-      } else {
-        result.insert(offset, edit.text);
+      size_t offset = std::min(edit.offset, cursor);
+      tail.append(source.rbegin() + (source.size() - cursor),
+                  source.rbegin() + (source.size() - offset));
+      cursor = offset;
+      if (edit.kind != TextEdit::Kind::Insert) {
+        tail.resize(tail.size() - std::min(edit.length, tail.size()));
+      }
+      if (edit.kind != TextEdit::Kind::Erase) {
+        tail.append(edit.text.rbegin(), edit.text.rend());
       }
     }
+
+    std::string result;
+    result.reserve(cursor + tail.size());
+    result.append(source.substr(0, cursor));
+    result.append(tail.rbegin(), tail.rend());
     return result;
   }
 };
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "../utils/Builtins.h"
+#include "AstArena.h"
 #include "../utils/Error.h"
 #include "Token.h"
 #include "../utils/Utils.h"
@@ -7,11 +9,44 @@
 #include <string>
 #include <vector>
 
+// One tag per concrete node type. Passes dispatch with a switch on kind and
+// node_cast instead of RTTI, so a new node type needs one case per pass.
+enum class NodeKind {
+  FUNCTION_DEF,
+  CLASS_DEF,
+  VAR_DECL,
+  BINARY_OP,
+  LITERAL,
+  IDENTIFIER,
+  BUILTIN_CALL,
+  PRINT,
+  INPUT,
+  CALL,
+  RETURN,
+  IMPORT,
+  IF,
+  WHILE,
+  NET_OP,
+  FILE_OP
+};
+
 struct AstNode {
+  const NodeKind kind;
   SourceLocation location;
+  explicit AstNode(NodeKind kind) : kind(kind) {}
   virtual ~AstNode() = default;
 };
 
+// Checked downcast: returns nullptr when node is null or of another kind.
+template <typename T> T *node_cast(AstNode *node) {
+  return node && node->kind == T::node_kind ? static_cast<T *>(node) : nullptr;
+}
+
+template <typename T> const T *node_cast(const AstNode *node) {
+  return node && node->kind == T::node_kind ? static_cast<const T *>(node)
+                                            : nullptr;
+}
+
 struct RouteDef {
   std::string method;
   std::string path;
@@ -19,12 +54,17 @@ struct RouteDef {
 };
 
 struct FunctionDef : AstNode {
+  static constexpr NodeKind node_kind = NodeKind::FUNCTION_DEF;
+  FunctionDef() : AstNode(node_kind) {}
   std::string name;
   std::vector<std::string> param_names;
   std::vector<std::string> param_types;
-  std::vector<std::shared_ptr<AstNode>> body;
+  std::vector<AstNode *> body;
   std::vector<RouteDef> routes;
   bool has_return_one = false;
+  int frame_size = 0;
+  std::vector<int> param_slots;
+  std::vector<int> request_slots;
 };
 
 struct OrmField {
@@ -36,83 +76,127 @@ struct OrmField {
 };
 
 struct ClassDef : AstNode {
+  static constexpr NodeKind node_kind = NodeKind::CLASS_DEF;
+  ClassDef() : AstNode(node_kind) {}
   std::string name;
   std::string base;
   std::vector<OrmField> fields;
 };
 
 struct VarDecl : AstNode {
+  static constexpr NodeKind node_kind = NodeKind::VAR_DECL;
+  VarDecl() : AstNode(node_kind) {}
   std::string name;
   std::string type_name;
-  std::shared_ptr<AstNode> expr;
+  AstNode *expr = nullptr;
+  int slot = -1;
+  bool is_global = false;
 };
 
 struct BinaryOp : AstNode {
+  static constexpr NodeKind node_kind = NodeKind::BINARY_OP;
+  BinaryOp() : AstNode(node_kind) {}
   TokenType op;
-  std::shared_ptr<AstNode> left, right;
+  AstNode *left = nullptr;
+  AstNode *right = nullptr;
+  // Set by SemanticAnalyzer when both operands are proven numeric: INT when
+  // both are ints, FLOAT when at least one is a float.
+  ValueType operand_type = ValueType::NONE;
 };
 
 struct Literal : AstNode {
+  static constexpr NodeKind node_kind = NodeKind::LITERAL;
+  Literal() : AstNode(node_kind) {}
   Value value;
 };
 struct Identifier : AstNode {
+  static constexpr NodeKind node_kind = NodeKind::IDENTIFIER;
+  Identifier() : AstNode(node_kind) {}
   std::string name;
+  int slot = -1;
+  int global_slot = -1;
 };
 
 struct BuiltinCallExpr : AstNode {
+  static constexpr NodeKind node_kind = NodeKind::BUILTIN_CALL;
+  BuiltinCallExpr() : AstNode(node_kind) {}
   std::string name;
-  std::vector<std::shared_ptr<AstNode>> args;
+  const BuiltinInfo *builtin = nullptr;
+  std::vector<AstNode *> args;
 };
 
 struct PrintStmt : AstNode {
-  std::vector<std::shared_ptr<AstNode>> args;
+  static constexpr NodeKind node_kind = NodeKind::PRINT;
+  PrintStmt() : AstNode(node_kind) {}
+  std::vector<AstNode *> args;
   std::vector<std::string> formats;
   bool is_printg = false;
 };
 
 struct InputStmt : AstNode {
+  static constexpr NodeKind node_kind = NodeKind::INPUT;
+  InputStmt() : AstNode(node_kind) {}
   std::string format;
   std::string prompt;
   std::string var_name;
+  int slot = -1;
+  bool is_global = false;
 };
 
 struct CallStmt : AstNode {
+  static constexpr NodeKind node_kind = NodeKind::CALL;
+  CallStmt() : AstNode(node_kind) {}
   std::string func_name;
-  std::vector<std::shared_ptr<AstNode>> args;
+  const BuiltinInfo *builtin = nullptr;
+  std::vector<AstNode *> args;
 };
 
 struct ReturnStmt : AstNode {
-  std::shared_ptr<AstNode> expr;
+  static constexpr NodeKind node_kind = NodeKind::RETURN;
+  ReturnStmt() : AstNode(node_kind) {}
+  AstNode *expr = nullptr;
 };
 
 struct ImportStmt : AstNode {
+  static constexpr NodeKind node_kind = NodeKind::IMPORT;
+  ImportStmt() : AstNode(node_kind) {}
   std::string file_path;
   std::vector<std::string> import_names;
 };
 
 struct IfStmt : AstNode {
-  std::shared_ptr<AstNode> condition;
-  std::vector<std::shared_ptr<AstNode>> then_body;
-  std::vector<std::shared_ptr<AstNode>> else_body;
+  static constexpr NodeKind node_kind = NodeKind::IF;
+  IfStmt() : AstNode(node_kind) {}
+  AstNode *condition = nullptr;
+  std::vector<AstNode *> then_body;
+  std::vector<AstNode *> else_body;
 };
 
 struct WhileStmt : AstNode {
-  std::shared_ptr<AstNode> condition;
-  std::vector<std::shared_ptr<AstNode>> body;
+  static constexpr NodeKind node_kind = NodeKind::WHILE;
+  WhileStmt() : AstNode(node_kind) {}
+  AstNode *condition = nullptr;
+  std::vector<AstNode *> body;
 };
 
 struct NetOp : AstNode {
+  static constexpr NodeKind node_kind = NodeKind::NET_OP;
+  NetOp() : AstNode(node_kind) {}
   std::string transport;
   std::string method;
-  std::shared_ptr<AstNode> url;
-  std::shared_ptr<AstNode> path;
-  std::shared_ptr<AstNode> port;
-  std::shared_ptr<AstNode> data;
+  AstNode *url = nullptr;
+  AstNode *path = nullptr;
+  AstNode *port = nullptr;
+  AstNode *data = nullptr;
+  // Server worker count for serve and run.
+  AstNode *workers = nullptr;
 };
 
 struct FileOp : AstNode {
+  static constexpr NodeKind node_kind = NodeKind::FILE_OP;
+  FileOp() : AstNode(node_kind) {}
   TokenType operation;
-  std::shared_ptr<AstNode> file_path;
+  AstNode *file_path = nullptr;
   std::string mode;
-  std::shared_ptr<AstNode> data;
+  AstNode *data = nullptr;
 };
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+struct AstNode;
+
+// Owns every AST node of a program. Nodes are bump-allocated in parse order,
+// so the nodes of one function sit next to each other in memory, and all of
+// them are destroyed together with the arena. Everything else holds plain
+// AstNode pointers, so the arena must outlive the interpreter.
+class AstArena {
+  static constexpr size_t block_size = 64 * 1024;
+
+  std::vector<std::unique_ptr<unsigned char[]>> blocks;
+  unsigned char *cursor = nullptr;
+  size_t remaining = 0;
+  std::vector<AstNode *> nodes;
+
+  void *allocate(size_t size, size_t align);
+
+public:
+  AstArena() = default;
+  AstArena(const AstArena &) = delete;
+  AstArena &operator=(const AstArena &) = delete;
+  ~AstArena();
+
+  template <typename T> T *make() {
+    static_assert(std::is_base_of<AstNode, T>::value,
+                  "AstArena only allocates AST nodes");
+    T *node = new (allocate(sizeof(T), alignof(T))) T();
+    nodes.push_back(node);
+    return node;
+  }
+
+  size_t size() const { return nodes.size(); }
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Ast.h"
+#include <vector>
+
+// Calls fn(AstNode *&) on each expression operand of node, in source order.
+// Operands may be null (an optional NetOp port, a bare return).
+template <typename Fn> void for_each_operand(AstNode &node, Fn &&fn) {
+  auto visit_all = [&](std::vector<AstNode *> &exprs) {
+    for (auto &expr : exprs) {
+      fn(expr);
+    }
+  };
+  switch (node.kind) {
+  case NodeKind::VAR_DECL:
+    fn(static_cast<VarDecl &>(node).expr);
+    break;
+  case NodeKind::BINARY_OP: {
+    auto &bin = static_cast<BinaryOp &>(node);
+    fn(bin.left);
+    fn(bin.right);
+    break;
+  }
+  case NodeKind::BUILTIN_CALL:
+    visit_all(static_cast<BuiltinCallExpr &>(node).args);
+    break;
+  case NodeKind::PRINT:
+    visit_all(static_cast<PrintStmt &>(node).args);
+    break;
+  case NodeKind::CALL:
+    visit_all(static_cast<CallStmt &>(node).args);
+    break;
+  case NodeKind::RETURN:
+    fn(static_cast<ReturnStmt &>(node).expr);
+    break;
+  case NodeKind::IF:
+    fn(static_cast<IfStmt &>(node).condition);
+    break;
+  case NodeKind::WHILE:
+    fn(static_cast<WhileStmt &>(node).condition);
+    break;
+  case NodeKind::NET_OP: {
+    auto &net_op = static_cast<NetOp &>(node);
+    fn(net_op.url);
+    fn(net_op.path);
+    fn(net_op.port);
+    fn(net_op.data);
+    fn(net_op.workers);
+    break;
+  }
+  case NodeKind::FILE_OP: {
+    auto &file_op = static_cast<FileOp &>(node);
+    fn(file_op.file_path);
+    fn(file_op.data);
+    break;
+  }
+  case NodeKind::FUNCTION_DEF:
+  case NodeKind::CLASS_DEF:
+  case NodeKind::LITERAL:
+  case NodeKind::IDENTIFIER:
+  case NodeKind::INPUT:
+  case NodeKind::IMPORT:
+    break;
+  }
+}
+
+// Calls fn(std::vector<AstNode *> &) on each statement list nested in node.
+template <typename Fn> void for_each_block(AstNode &node, Fn &&fn) {
+  switch (node.kind) {
+  case NodeKind::FUNCTION_DEF:
+    fn(static_cast<FunctionDef &>(node).body);
+    break;
+  case NodeKind::IF: {
+    auto &if_stmt = static_cast<IfStmt &>(node);
+    fn(if_stmt.then_body);
+    fn(if_stmt.else_body);
+    break;
+  }
+  case NodeKind::WHILE:
+    fn(static_cast<WhileStmt &>(node).body);
+    break;
+  case NodeKind::CLASS_DEF:
+  case NodeKind::VAR_DECL:
+  case NodeKind::BINARY_OP:
+  case NodeKind::LITERAL:
+  case NodeKind::IDENTIFIER:
+  case NodeKind::BUILTIN_CALL:
+  case NodeKind::PRINT:
+  case NodeKind::INPUT:
+  case NodeKind::CALL:
+  case NodeKind::RETURN:
+  case NodeKind::IMPORT:
+  case NodeKind::NET_OP:
+  case NodeKind::FILE_OP:
+    break;
+  }
+}
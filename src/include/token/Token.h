@@ -1,6 +1,7 @@
 #pragma once
 
-#include <string>
+#include <array>
+#include <string_view>
 
 enum TokenType {
   T_PACKAGE,
@@ -60,7 +61,121 @@ enum TokenType {
 
 struct Token {
   TokenType type = T_EOF;
-  std::string value;
+  std::string_view value;
   int line = 0;
   int column = 0;
 };
+
+struct Keyword {
+  std::string_view text;
+  TokenType type;
+};
+
+// Reserved words. `True` and `False` are accepted spellings of the booleans.
+inline constexpr Keyword keywords[] = {
+    {"package", T_PACKAGE}, {"function", T_FUNCTION}, {"class", T_CLASS},
+    {"print", T_PRINT},     {"printg", T_PRINTG},     {"println", T_PRINTLN},
+    {"return", T_RETURN},   {"call", T_CALL},         {"input", T_INPUT},
+    {"cout", T_COUT},       {"int", T_INT},           {"float", T_FLOAT},
+    {"string", T_STRING},   {"bool", T_BOOL_TYPE},    {"bytes", T_BYTES},
+    {"object", T_OBJECT},   {"array", T_ARRAY},       {"from", T_FROM},
+    {"import", T_IMPORT},   {"if", T_IF},             {"else", T_ELSE},
+    {"while", T_WHILE},     {"true", T_TRUE},         {"True", T_TRUE},
+    {"false", T_FALSE},     {"False", T_FALSE},       {"create", T_CREATE},
+    {"write", T_WRITE},     {"read", T_READ},         {"close", T_CLOSE},
+    {"delete", T_DELETE},   {"file", T_FILE}};
+
+constexpr size_t min_keyword_length = 2;
+constexpr size_t max_keyword_length = 8;
+constexpr size_t keyword_slot_count = 64;
+
+// Perfect for the table above; keyword_slots fails to compile if a new
+// keyword collides, in which case the multipliers need retuning.
+constexpr size_t keyword_hash(std::string_view text) {
+  return (text.size() + 11 * static_cast<unsigned char>(text[0]) +
+          12 * static_cast<unsigned char>(text[1]) +
+          25 * static_cast<unsigned char>(text[text.size() - 1])) &
+         (keyword_slot_count - 1);
+}
+
+constexpr std::array<signed char, keyword_slot_count> build_keyword_slots() {
+  std::array<signed char, keyword_slot_count> slots{};
+  for (auto &slot : slots) {
+    slot = -1;
+  }
+  for (size_t i = 0; i < std::size(keywords); ++i) {
+    size_t length = keywords[i].text.size();
+    if (length < min_keyword_length || length > max_keyword_length) {
+      throw "keyword length outside the hashed range";
+    }
+    size_t slot = keyword_hash(keywords[i].text);
+    if (slots[slot] != -1) {
+      throw "keyword hash collision";
+    }
+    slots[slot] = static_cast<signed char>(i);
+  }
+  return slots;
+}
+
+inline constexpr std::array<signed char, keyword_slot_count> keyword_slots =
+    build_keyword_slots();
+
+// T_IDENTIFIER unless text is exactly a reserved word.
+constexpr TokenType keyword_type(std::string_view text) {
+  if (text.size() < min_keyword_length || text.size() > max_keyword_length) {
+    return T_IDENTIFIER;
+  }
+  int index = keyword_slots[keyword_hash(text)];
+  if (index < 0 || keywords[index].text != text) {
+    return T_IDENTIFIER;
+  }
+  return keywords[index].type;
+}
+
+// Canonical source text of fixed-spelling tokens, "" for the rest.
+constexpr std::string_view token_spelling(TokenType type) {
+  switch (type) {
+  case T_LBRACE:
+    return "{";
+  case T_RBRACE:
+    return "}";
+  case T_LPAREN:
+    return "(";
+  case T_RPAREN:
+    return ")";
+  case T_COMMA:
+    return ",";
+  case T_PLUS:
+    return "+";
+  case T_MINUS:
+    return "-";
+  case T_STAR:
+    return "*";
+  case T_SLASH:
+    return "/";
+  case T_EQUAL:
+    return "=";
+  case T_GREATER:
+    return ">";
+  case T_LESS:
+    return "<";
+  case T_EQUAL_EQUAL:
+    return "==";
+  case T_NOT_EQUAL:
+    return "!=";
+  case T_GREATER_EQUAL:
+    return ">=";
+  case T_LESS_EQUAL:
+    return "<=";
+  case T_COLON_COLON:
+    return "::";
+  default:
+    break;
+  }
+  for (const auto &keyword : keywords) {
+    if (keyword.type == type) {
+      return keyword.text;
+    }
+  }
+  return "";
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Builtins callable from PGT code. Each builtin is registered exactly once in
+// the table in src/utils/Builtins.cpp: the parser resolves call names to a
+// BuiltinInfo, SemanticAnalyzer checks arity and argument types, and
+// Interpreter::call_builtin dispatches on the id.
+//
+// Adding a native builtin:
+//   1. add an id to BuiltinId and a row (name, id, arity) to the table;
+//      aliases are extra rows sharing the same id,
+//   2. type its arguments and result in SemanticAnalyzer::infer_builtin_type,
+//   3. implement it in Interpreter::call_builtin.
+// Rows marked as statements may also be called as `name(args)` statements.
+enum class BuiltinId {
+  PROTOCOL,
+  READ_FILE,
+  OPEN_LOG,
+  REQUEST_METHOD,
+  REQUEST_PATH,
+  REQUEST_BODY,
+  REQUEST_JSON,
+  REQUEST_QUERY,
+  REQUEST_HEADER,
+  REQUEST_PARAM,
+  JSON_PARSE,
+  JSON_STRINGIFY,
+  JSON_WRITE,
+  JSON_READ,
+  JSON_GET,
+  JSON_OBJECT,
+  AUTH_HASH_PASSWORD,
+  AUTH_VERIFY_PASSWORD,
+  JWT_SIGN,
+  JWT_VERIFY,
+  SQL_OPEN,
+  SQL_EXEC,
+  SQL_TABLE,
+  SQL_INSERT,
+  SQL_FIND,
+  ORM_MIGRATE,
+  LOG,
+  LOG_TRACE,
+  LOG_DEBUG,
+  LOG_INFO,
+  LOG_NOTICE,
+  LOG_WARN,
+  LOG_ERROR,
+  LOG_CRITICAL,
+  LOG_OUTPUT,
+  LOG_CONSOLE,
+  LOG_FILE
+};
+
+struct BuiltinInfo {
+  const char *name;
+  BuiltinId id;
+  int min_args;
+  int max_args;
+  const char *arity;
+  bool statement;
+};
+
+const BuiltinInfo *find_builtin(std::string_view name);
+bool is_log_builtin(BuiltinId id);
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of workers, each with its own task deque. A worker runs the
+// newest task of its own deque first, which keeps a file and the imports it
+// just discovered on one core, and when it runs dry it steals the oldest task
+// of another worker. Tasks may submit more tasks; they must not throw.
+class ThreadPool {
+  struct Queue {
+    std::mutex lock;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+
+  std::mutex state_lock;
+  std::condition_variable work_available;
+  std::condition_variable all_done;
+  size_t queued = 0;
+  size_t unfinished = 0;
+  size_t next_queue = 0;
+  bool stopping = false;
+
+  bool take(size_t index, std::function<void()> &task);
+  void work(size_t index);
+
+public:
+  // threads == 0 picks one per hardware thread.
+  explicit ThreadPool(size_t threads = 0);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void submit(std::function<void()> task);
+  // Blocks until every task submitted so far, and every task those submit,
+  // has finished.
+  void wait();
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One measured phase of `pgt run --timings`. file is empty for phases that
+// cover the whole program; tokens and nodes are zero where a phase does not
+// produce any.
+struct PhaseTiming {
+  std::string file;
+  std::string phase;
+  uint64_t nanoseconds = 0;
+  uint64_t allocations = 0;
+  size_t tokens = 0;
+  size_t nodes = 0;
+};
+
+// Number of operator new calls made so far by the calling thread.
+uint64_t thread_allocation_count();
+
+// Measures one phase on the calling thread, from construction to stop(), on
+// the monotonic clock.
+class PhaseClock {
+  std::chrono::steady_clock::time_point start;
+  uint64_t start_allocations;
+
+public:
+  PhaseClock()
+      : start(std::chrono::steady_clock::now()),
+        start_allocations(thread_allocation_count()) {}
+
+  PhaseTiming stop(std::string file, std::string phase) const;
+};
+
+// A table for people, one row per phase with a total at the end.
+void print_timings(std::ostream &out, const std::vector<PhaseTiming> &phases);
+// The same data as a single JSON object, stable across releases so runs can
+// be compared.
+void print_timings_json(std::ostream &out,
+                        const std::vector<PhaseTiming> &phases);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <string>
 #include <utility>
@@ -7,93 +8,163 @@
 
 extern bool DEBUG;
 
-enum class ValueType { INT, FLOAT, STRING, BOOL, BYTES, OBJECT, ARRAY, NONE };
+enum class ValueType : unsigned char {
+  INT,
+  FLOAT,
+  STRING,
+  BOOL,
+  BYTES,
+  OBJECT,
+  ARRAY,
+  NONE
+};
 
+template <typename T> struct SharedPayload {
+  std::atomic<long> refs{1};
+  T value;
+
+  explicit SharedPayload(T v) : value(std::move(v)) {}
+};
+
+// A Value is a 16-byte tagged word: scalars live inline, strings, objects
+// and arrays live in an immutable refcounted payload, so copying a value
+// never copies its contents.
 struct Value {
-  ValueType type = ValueType::NONE;
-  long long int_val = 0;
-  double float_val = 0.0;
-  bool bool_val = false;
-  std::string str_val;
-  std::map<std::string, Value> obj_val;
-  std::vector<Value> arr_val;
-
-  Value() = default;
-  Value(long long v) : type(ValueType::INT), int_val(v) {}
-  Value(double v) : type(ValueType::FLOAT), float_val(v) {}
-  Value(std::string v) : type(ValueType::STRING), str_val(std::move(v)) {}
+  using ObjectMap = std::map<std::string, Value>;
+  using ArrayList = std::vector<Value>;
+
+  Value() noexcept { data.int_val = 0; }
+  Value(long long v) noexcept : kind(ValueType::INT) { data.int_val = v; }
+  Value(double v) noexcept : kind(ValueType::FLOAT) { data.float_val = v; }
+  Value(std::string v) : kind(ValueType::STRING) {
+    data.str_val = new SharedPayload<std::string>(std::move(v));
+  }
+
+  Value(const Value &other) noexcept : kind(other.kind), data(other.data) {
+    retain();
+  }
+  Value(Value &&other) noexcept : kind(other.kind), data(other.data) {
+    other.kind = ValueType::NONE;
+    other.data.int_val = 0;
+  }
+
+  Value &operator=(const Value &other) noexcept {
+    if (this != &other) {
+      other.retain();
+      release();
+      kind = other.kind;
+      data = other.data;
+    }
+    return *this;
+  }
+
+  Value &operator=(Value &&other) noexcept {
+    if (this != &other) {
+      release();
+      kind = other.kind;
+      data = other.data;
+      other.kind = ValueType::NONE;
+      other.data.int_val = 0;
+    }
+    return *this;
+  }
+
+  ~Value() { release(); }
 
   static Value Bool(bool v) {
     Value value;
-    value.type = ValueType::BOOL;
-    value.bool_val = v;
+    value.kind = ValueType::BOOL;
+    value.data.bool_val = v;
     return value;
   }
 
   static Value Bytes(std::string v) {
-    Value value;
-    value.type = ValueType::BYTES;
-    value.str_val = std::move(v);
+    Value value(std::move(v));
+    value.kind = ValueType::BYTES;
     return value;
   }
 
-  static Value Object(std::map<std::string, Value> v) {
+  static Value Object(ObjectMap v) {
     Value value;
-    value.type = ValueType::OBJECT;
-    value.obj_val = std::move(v);
+    value.kind = ValueType::OBJECT;
+    value.data.obj_val = new SharedPayload<ObjectMap>(std::move(v));
     return value;
   }
 
-  static Value Array(std::vector<Value> v) {
+  static Value Array(ArrayList v) {
     Value value;
-    value.type = ValueType::ARRAY;
-    value.arr_val = std::move(v);
+    value.kind = ValueType::ARRAY;
+    value.data.arr_val = new SharedPayload<ArrayList>(std::move(v));
     return value;
   }
 
+  ValueType type() const { return kind; }
+  long long int_val() const {
+    return kind == ValueType::INT ? data.int_val : 0;
+  }
+  double float_val() const {
+    return kind == ValueType::FLOAT ? data.float_val : 0.0;
+  }
+  bool bool_val() const { return kind == ValueType::BOOL && data.bool_val; }
+
+  const std::string &str_val() const {
+    static const std::string empty;
+    return is_string_kind() ? data.str_val->value : empty;
+  }
+
+  const ObjectMap &obj_val() const {
+    static const ObjectMap empty;
+    return kind == ValueType::OBJECT ? data.obj_val->value : empty;
+  }
+
+  const ArrayList &arr_val() const {
+    static const ArrayList empty;
+    return kind == ValueType::ARRAY ? data.arr_val->value : empty;
+  }
+
   std::string to_string(const std::string &format = "") const {
     if (!format.empty()) {
-      if (format == "{int}" && type == ValueType::INT)
-        return std::to_string(int_val);
-      if (format == "{int}" && type == ValueType::BOOL)
-        return std::to_string(bool_val ? 1 : 0);
-      if (format == "{float}" && type == ValueType::FLOAT)
-        return std::to_string(float_val);
-      if (format == "{float}" && type == ValueType::INT)
-        return std::to_string(static_cast<double>(int_val));
-      if (format == "{string}" && type == ValueType::STRING)
-        return str_val;
-      if (format == "{string}" && type == ValueType::BYTES)
-        return str_val;
-      if (format == "{bool}" && type == ValueType::BOOL)
-        return bool_val ? "true" : "false";
-      if (format == "{bool}" && type == ValueType::INT)
-        return int_val != 0 ? "true" : "false";
-      if (format == "{bool}" && type == ValueType::FLOAT)
-        return float_val != 0.0 ? "true" : "false";
+      if (format == "{int}" && kind == ValueType::INT)
+        return std::to_string(int_val());
+      if (format == "{int}" && kind == ValueType::BOOL)
+        return std::to_string(bool_val() ? 1 : 0);
+      if (format == "{float}" && kind == ValueType::FLOAT)
+        return std::to_string(float_val());
+      if (format == "{float}" && kind == ValueType::INT)
+        return std::to_string(static_cast<double>(int_val()));
+      if (format == "{string}" && kind == ValueType::STRING)
+        return str_val();
+      if (format == "{string}" && kind == ValueType::BYTES)
+        return str_val();
+      if (format == "{bool}" && kind == ValueType::BOOL)
+        return bool_val() ? "true" : "false";
+      if (format == "{bool}" && kind == ValueType::INT)
+        return int_val() != 0 ? "true" : "false";
+      if (format == "{bool}" && kind == ValueType::FLOAT)
+        return float_val() != 0.0 ? "true" : "false";
       if (format == "{bool}" &&
-          (type == ValueType::STRING || type == ValueType::BYTES))
-        return str_val.empty() ? "false" : "true";
-      if (format == "{bytes}" && type == ValueType::BYTES)
-        return str_val;
-      if (format == "{bytes}" && type == ValueType::STRING)
-        return str_val;
+          (kind == ValueType::STRING || kind == ValueType::BYTES))
+        return str_val().empty() ? "false" : "true";
+      if (format == "{bytes}" && kind == ValueType::BYTES)
+        return str_val();
+      if (format == "{bytes}" && kind == ValueType::STRING)
+        return str_val();
     }
-    switch (type) {
+    switch (kind) {
     case ValueType::INT:
-      return std::to_string(int_val);
+      return std::to_string(int_val());
     case ValueType::FLOAT:
-      return std::to_string(float_val);
+      return std::to_string(float_val());
     case ValueType::STRING:
-      return str_val;
+      return str_val();
     case ValueType::BOOL:
-      return bool_val ? "true" : "false";
+      return bool_val() ? "true" : "false";
     case ValueType::BYTES:
-      return str_val;
+      return str_val();
     case ValueType::OBJECT: {
       std::string json = "{";
-      for (auto it = obj_val.begin(); it != obj_val.end(); ++it) {
-        if (it != obj_val.begin())
+      for (auto it = obj_val().begin(); it != obj_val().end(); ++it) {
+        if (it != obj_val().begin())
           json += ",";
         json += "\"" + it->first + "\":" + it->second.to_json();
       }
@@ -102,10 +173,10 @@ struct Value {
     }
     case ValueType::ARRAY: {
       std::string json = "[";
-      for (size_t i = 0; i < arr_val.size(); ++i) {
+      for (size_t i = 0; i < arr_val().size(); ++i) {
         if (i > 0)
           json += ",";
-        json += arr_val[i].to_json();
+        json += arr_val()[i].to_json();
       }
       json += "]";
       return json;
@@ -116,21 +187,21 @@ struct Value {
   }
 
   std::string to_json() const {
-    switch (type) {
+    switch (kind) {
     case ValueType::INT:
-      return std::to_string(int_val);
+      return std::to_string(int_val());
     case ValueType::FLOAT:
-      return std::to_string(float_val);
+      return std::to_string(float_val());
     case ValueType::STRING:
-      return "\"" + str_val + "\"";
+      return "\"" + str_val() + "\"";
     case ValueType::BOOL:
-      return bool_val ? "true" : "false";
+      return bool_val() ? "true" : "false";
     case ValueType::BYTES:
-      return "\"" + str_val + "\"";
+      return "\"" + str_val() + "\"";
     case ValueType::OBJECT: {
       std::string json = "{";
-      for (auto it = obj_val.begin(); it != obj_val.end(); ++it) {
-        if (it != obj_val.begin())
+      for (auto it = obj_val().begin(); it != obj_val().end(); ++it) {
+        if (it != obj_val().begin())
           json += ",";
         json += "\"" + it->first + "\":" + it->second.to_json();
       }
@@ -139,10 +210,10 @@ struct Value {
     }
     case ValueType::ARRAY: {
       std::string json = "[";
-      for (size_t i = 0; i < arr_val.size(); ++i) {
+      for (size_t i = 0; i < arr_val().size(); ++i) {
         if (i > 0)
           json += ",";
-        json += arr_val[i].to_json();
+        json += arr_val()[i].to_json();
       }
       json += "]";
       return json;
@@ -151,4 +222,51 @@ struct Value {
       return "null";
     }
   }
-};
\ No newline at end of file
+
+private:
+  ValueType kind = ValueType::NONE;
+  union {
+    long long int_val;
+    double float_val;
+    bool bool_val;
+    SharedPayload<std::string> *str_val;
+    SharedPayload<ObjectMap> *obj_val;
+    SharedPayload<ArrayList> *arr_val;
+  } data;
+
+  bool is_string_kind() const {
+    return kind == ValueType::STRING || kind == ValueType::BYTES;
+  }
+
+  template <typename T> static void retain(SharedPayload<T> *payload) {
+    payload->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  template <typename T> static void release(SharedPayload<T> *payload) {
+    if (payload->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete payload;
+    }
+  }
+
+  void retain() const {
+    if (is_string_kind()) {
+      retain(data.str_val);
+    } else if (kind == ValueType::OBJECT) {
+      retain(data.obj_val);
+    } else if (kind == ValueType::ARRAY) {
+      retain(data.arr_val);
+    }
+  }
+
+  void release() {
+    if (is_string_kind()) {
+      release(data.str_val);
+    } else if (kind == ValueType::OBJECT) {
+      release(data.obj_val);
+    } else if (kind == ValueType::ARRAY) {
+      release(data.arr_val);
+    }
+  }
+};
+
+static_assert(sizeof(Value) == 16, "Value must stay a 16-byte tagged word");
@@ -0,0 +1,5 @@
+#pragma once
+
+// Reported by `pgt version`; also part of every .pgtc cache key, so a new
+// compiler never reuses trees parsed by an older one.
+inline constexpr const char *pgt_version = "1.1";
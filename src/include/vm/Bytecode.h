@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../token/Ast.h"
+#include "../utils/Utils.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class OpCode {
+  CONST,
+  LOAD_LOCAL,
+  LOAD_GLOBAL,
+  LOAD_NAME,
+  STORE_LOCAL,
+  STORE_GLOBAL,
+  BINARY,
+  BINARY_INT,
+  BINARY_FLOAT,
+  INC_LOCAL_INT,
+  POP,
+  JUMP,
+  JUMP_IF_FALSE,
+  PRINT_VALUE,
+  PRINT_END,
+  CALL,
+  BUILTIN,
+  INPUT,
+  FILE_OP,
+  NET_OP,
+  RETURN,
+  END
+};
+
+// How a chunk finished: RETURN carries the function result, NORMAL means
+// execution fell off the end. Errors are the only thing thrown out of a chunk.
+enum class ExecStatus { NORMAL, RETURN };
+
+// BINARY_INT and BINARY_FLOAT are BINARY for operands the analyzer proved
+// numeric; they check the tags and fall back to Interpreter::binary_op when
+// the proof does not hold at run time. INC_LOCAL_INT adds b to an int local
+// and jumps to c, past the generic store it guards; otherwise it falls
+// through to that store.
+struct Instruction {
+  OpCode op;
+  int a = 0;
+  int b = 0;
+  int c = 0;
+  const AstNode *node = nullptr;
+};
+
+struct Chunk {
+  std::string name;
+  std::vector<Instruction> code;
+  std::vector<Value> constants;
+  std::vector<std::string> names;
+  std::vector<const BuiltinInfo *> builtins;
+  size_t frame_size = 0;
+  size_t max_stack = 0;
+};
+
+class BytecodeCompiler {
+  std::shared_ptr<Chunk> chunk;
+  size_t stack_depth = 0;
+
+  size_t emit(OpCode op, int a = 0, int b = 0, const AstNode *node = nullptr);
+  int add_constant(const Value &value);
+  int add_name(const std::string &name);
+  int add_builtin(const BuiltinInfo *builtin);
+  void patch_jump(size_t at);
+  void adjust_stack(int delta);
+  bool emit_increment(const VarDecl &decl, size_t &at);
+
+  void compile_block(const std::vector<AstNode *> &body);
+  void compile_statement(AstNode *stmt);
+  void compile_expr(AstNode *expr);
+  void compile_print(const PrintStmt &print);
+  void compile_call(const CallStmt &call);
+  void compile_builtin(const BuiltinInfo *builtin,
+                       const std::vector<AstNode *> &args, const AstNode *node);
+  void compile_if(const IfStmt &if_stmt);
+  void compile_while(const WhileStmt &while_stmt);
+  void compile_file_op(const FileOp &file_op);
+  void compile_net_op(const NetOp &net_op);
+
+public:
+  std::shared_ptr<Chunk> compile_function(const FunctionDef &func);
+  std::shared_ptr<Chunk> compile_expression(AstNode *expr,
+                                            const std::string &name);
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "../token/Ast.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Resolver {
+  std::map<std::string, int> global_slots;
+  std::vector<std::string> global_names;
+  std::map<std::string, int> local_slots;
+
+  int local_slot(const std::string &name);
+  void declare_assignment(const std::string &name);
+  void collect(AstNode *node);
+  void annotate(AstNode *node);
+  void annotate_name(const std::string &name, int &slot, bool &is_global);
+
+public:
+  void resolve_global(VarDecl &decl);
+  void resolve_function(FunctionDef &func);
+  const std::vector<std::string> &globals() const { return global_names; }
+};
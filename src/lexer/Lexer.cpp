@@ -1,6 +1,5 @@
 #include "../include/lexer/Lexer.h"
 #include <cctype>
-#include <iostream>
 
 char Lexer::peek() const { return pos < source.size() ? source[pos] : 0; }
 char Lexer::peek_next() const {
@@ -13,19 +12,60 @@ char Lexer::get() {
   return source[pos++];
 }
 
-Lexer::Lexer(std::string src) : source(std::move(src)) {}
+// Moves past count bytes that may span lines. '\r' only ends a line inside
+// block comments.
+void Lexer::advance(size_t count, bool count_cr) {
+  LineSpan span = scan.count_lines(source.data() + pos, count, count_cr);
+  if (span.lines) {
+    line += static_cast<int>(span.lines);
+    column = 1 + static_cast<int>(span.tail);
+  } else {
+    column += static_cast<int>(count);
+  }
+  pos += count;
+}
+
+// A NUL byte ends the input, as it always has; cutting the view there lets
+// the scanning kernels ignore it.
+Lexer::Lexer(SourceFile &file)
+    : file(file), scan(scanner()),
+      source(file.text().substr(0, file.text().find('\0'))) {}
+
+// Only literals that contain a backslash get their own storage.
+std::string_view Lexer::decode_string(std::string_view raw) {
+  std::string str;
+  str.reserve(raw.size());
+  for (size_t i = 0; i < raw.size(); ++i) {
+    if (raw[i] != '\\') {
+      str += raw[i];
+      continue;
+    }
+    if (++i == raw.size()) {
+      break;
+    }
+    char escaped = raw[i];
+    if (escaped == 'n') {
+      str += '\n';
+    } else if (escaped == 't') {
+      str += '\t';
+    } else if (escaped == 'r') {
+      str += '\r';
+    } else {
+      str += escaped;
+    }
+  }
+  return file.keep(std::move(str));
+}
 
 Token Lexer::next_token() {
   while (true) {
     char c = peek();
     if (c == 0)
       return {T_EOF, "", line, column};
-    if (std::isspace(c)) {
-      get();
-      if (c == '\n') {
-        line++;
-        column = 1;
-      }
+    size_t blank =
+        scan.whitespace_run(source.data() + pos, source.size() - pos);
+    if (blank) {
+      advance(blank, false);
       continue;
     }
 
@@ -65,32 +105,30 @@ Token Lexer::next_token() {
       return {T_STAR, "*", token_line, token_column};
     }
     if (c == '/') {
+      size_t start = pos;
       if (peek_next() == '/') {
-        std::string comment = "//";
-        get();
-        get();
-        while (peek() != 0 && peek() != '\n' && peek() != '\r') {
-          comment += get();
-        }
-        return {T_LINE_COMMENT, comment, token_line, token_column};
+        size_t length =
+            2 + scan.find_either(source.data() + pos + 2,
+                                 source.size() - pos - 2, '\n', '\r');
+        pos += length;
+        column += static_cast<int>(length);
+        return {T_LINE_COMMENT, source.substr(start, pos - start), token_line,
+                token_column};
       }
       if (peek_next() == '*') {
-        std::string comment = "/*";
         get();
         get();
-        while (peek() != 0) {
-          char ch = get();
-          comment += ch;
-          if (ch == '\n' || ch == '\r') {
-            line++;
-            column = 1;
-          }
-          if (ch == '*' && peek() == '/') {
-            comment += get();
+        while (pos < source.size()) {
+          size_t rest = source.size() - pos;
+          size_t star = scan.find_either(source.data() + pos, rest, '*', '*');
+          advance(star < rest ? star + 1 : rest, true);
+          if (star < rest && peek() == '/') {
+            get();
             break;
           }
         }
-        return {T_BLOCK_COMMENT, comment, token_line, token_column};
+        return {T_BLOCK_COMMENT, source.substr(start, pos - start), token_line,
+                token_column};
       }
       get();
       return {T_SLASH, "/", token_line, token_column};
@@ -140,155 +178,55 @@ Token Lexer::next_token() {
 
     if (c == '"') {
       get();
-      std::string str;
-      bool is_first_char = true;
-
       if (peek() == '\n' || peek() == '\r') {
-        char newline = get();
-        if (newline == '\n' || newline == '\r') {
-          line++;
-          column = 1;
-        }
+        get();
+        line++;
+        column = 1;
         while (peek() == ' ' || peek() == '\t') {
           get();
         }
-        is_first_char = false;
       }
 
-      size_t iterations = 0;
-      size_t last_pos = pos;
-      while (peek() != 0) {
-        iterations++;
-        if (iterations > 100000) {
-          std::cerr << "Error: Infinite loop in string lexer at line " << line
-                    << std::endl;
-          break;
-        }
-        if (pos == last_pos && iterations > 1000) {
-          std::cerr << "Error: Lexer stuck at position " << pos << " in string"
-                    << std::endl;
-          break;
-        }
-        last_pos = pos;
-
+      size_t start = pos;
+      size_t end = source.size();
+      bool has_escape = false;
+      while (pos < source.size()) {
+        advance(scan.find_either(source.data() + pos, source.size() - pos, '"',
+                                 '\\'),
+                false);
         if (peek() == '\\') {
+          // The escaped character never counts as a line break.
+          has_escape = true;
           get();
-          char escaped = get();
-          if (escaped == 0) {
-            break;
-          }
-          if (escaped == 'n') {
-            str += '\n';
-          } else if (escaped == 't') {
-            str += '\t';
-          } else if (escaped == 'r') {
-            str += '\r';
-          } else if (escaped == '"') {
-            str += '"';
-          } else if (escaped == '\\') {
-            str += '\\';
-          } else {
-            str += escaped;
-          }
-          continue;
-        }
-
-        if (peek() == '"') {
+          get();
+        } else if (peek() == '"') {
+          end = pos;
           get();
           break;
-        } else {
-          char ch = get();
-          if (ch == '\n') {
-            line++;
-            column = 1;
-            str += '\n';
-          } else if (ch == ' ' || ch == '\t') {
-            str += ch;
-          } else {
-            str += ch;
-          }
-          is_first_char = false;
         }
       }
-      return {T_STRING_LITERAL, str, token_line, token_column};
+      std::string_view raw = source.substr(start, end - start);
+      return {T_STRING_LITERAL, has_escape ? decode_string(raw) : raw,
+              token_line, token_column};
     }
 
     if (std::isdigit(c) || (c == '-' && std::isdigit(peek() + 1)) || c == '.') {
-      std::string num;
+      size_t start = pos;
       if (c == '-' || c == '.')
-        num += get();
+        get();
       while (std::isdigit(peek()) || peek() == '.')
-        num += get();
-      return {T_NUMBER, num, token_line, token_column};
+        get();
+      return {T_NUMBER, source.substr(start, pos - start), token_line,
+              token_column};
     }
 
     if (std::isalpha(c) || c == '_') {
-      std::string id;
-      while (std::isalnum(peek()) || peek() == '_' || peek() == '.')
-        id += get();
-
-      if (id == "package")
-        return {T_PACKAGE, id, token_line, token_column};
-      if (id == "function")
-        return {T_FUNCTION, id, token_line, token_column};
-      if (id == "class")
-        return {T_CLASS, id, token_line, token_column};
-      if (id == "print")
-        return {T_PRINT, id, token_line, token_column};
-      if (id == "printg")
-        return {T_PRINTG, id, token_line, token_column};
-      if (id == "println")
-        return {T_PRINTLN, id, token_line, token_column};
-      if (id == "return")
-        return {T_RETURN, id, token_line, token_column};
-      if (id == "call")
-        return {T_CALL, id, token_line, token_column};
-      if (id == "input")
-        return {T_INPUT, id, token_line, token_column};
-      if (id == "cout")
-        return {T_COUT, id, token_line, token_column};
-      if (id == "int")
-        return {T_INT, id, token_line, token_column};
-      if (id == "float")
-        return {T_FLOAT, id, token_line, token_column};
-      if (id == "string")
-        return {T_STRING, id, token_line, token_column};
-      if (id == "bool")
-        return {T_BOOL_TYPE, id, token_line, token_column};
-      if (id == "bytes")
-        return {T_BYTES, id, token_line, token_column};
-      if (id == "object")
-        return {T_OBJECT, id, token_line, token_column};
-      if (id == "array")
-        return {T_ARRAY, id, token_line, token_column};
-      if (id == "from")
-        return {T_FROM, id, token_line, token_column};
-      if (id == "import")
-        return {T_IMPORT, id, token_line, token_column};
-      if (id == "if")
-        return {T_IF, id, token_line, token_column};
-      if (id == "else")
-        return {T_ELSE, id, token_line, token_column};
-      if (id == "while")
-        return {T_WHILE, id, token_line, token_column};
-      if (id == "true" || id == "True")
-        return {T_TRUE, id, token_line, token_column};
-      if (id == "false" || id == "False")
-        return {T_FALSE, id, token_line, token_column};
-      if (id == "create")
-        return {T_CREATE, id, token_line, token_column};
-      if (id == "write")
-        return {T_WRITE, id, token_line, token_column};
-      if (id == "read")
-        return {T_READ, id, token_line, token_column};
-      if (id == "close")
-        return {T_CLOSE, id, token_line, token_column};
-      if (id == "delete")
-        return {T_DELETE, id, token_line, token_column};
-      if (id == "file")
-        return {T_FILE, id, token_line, token_column};
-
-      return {T_IDENTIFIER, id, token_line, token_column};
+      size_t length =
+          scan.identifier_run(source.data() + pos, source.size() - pos);
+      std::string_view id = source.substr(pos, length);
+      pos += length;
+      column += static_cast<int>(length);
+      return {keyword_type(id), id, token_line, token_column};
     }
 
     get();
@@ -0,0 +1,258 @@
+#include "../include/lexer/Scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PGT_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+bool is_whitespace(unsigned char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+bool is_identifier_char(unsigned char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_' || c == '.';
+}
+
+bool is_newline(char c, bool count_cr) {
+  return c == '\n' || (count_cr && c == '\r');
+}
+
+size_t scalar_whitespace_run(const char *p, size_t n) {
+  size_t i = 0;
+  while (i < n && is_whitespace(static_cast<unsigned char>(p[i]))) {
+    ++i;
+  }
+  return i;
+}
+
+size_t scalar_identifier_run(const char *p, size_t n) {
+  size_t i = 0;
+  while (i < n && is_identifier_char(static_cast<unsigned char>(p[i]))) {
+    ++i;
+  }
+  return i;
+}
+
+size_t scalar_find_either(const char *p, size_t n, char a, char b) {
+  size_t i = 0;
+  while (i < n && p[i] != a && p[i] != b) {
+    ++i;
+  }
+  return i;
+}
+
+LineSpan scalar_count_lines(const char *p, size_t n, bool count_cr) {
+  LineSpan span;
+  span.tail = n;
+  for (size_t i = 0; i < n; ++i) {
+    if (is_newline(p[i], count_cr)) {
+      span.lines++;
+      span.tail = n - i - 1;
+    }
+  }
+  return span;
+}
+
+#ifdef PGT_SCAN_X86
+#define PGT_SSE2 __attribute__((target("sse2")))
+#define PGT_AVX2 __attribute__((target("avx2")))
+
+// Bytes of v that are <= limit as unsigned values.
+PGT_SSE2 __m128i at_most_128(__m128i v, char limit) {
+  return _mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(limit)), v);
+}
+
+PGT_SSE2 __m128i whitespace_mask_128(__m128i v) {
+  __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+  __m128i control = at_most_128(_mm_sub_epi8(v, _mm_set1_epi8('\t')), 4);
+  return _mm_or_si128(space, control);
+}
+
+PGT_SSE2 __m128i identifier_mask_128(__m128i v) {
+  __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+  __m128i alpha = at_most_128(_mm_sub_epi8(lower, _mm_set1_epi8('a')), 25);
+  __m128i digit = at_most_128(_mm_sub_epi8(v, _mm_set1_epi8('0')), 9);
+  __m128i punct = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')),
+                               _mm_cmpeq_epi8(v, _mm_set1_epi8('.')));
+  return _mm_or_si128(_mm_or_si128(alpha, digit), punct);
+}
+
+PGT_SSE2 size_t sse2_whitespace_run(const char *p, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    unsigned stop = ~_mm_movemask_epi8(whitespace_mask_128(v)) & 0xFFFFu;
+    if (stop) {
+      return i + __builtin_ctz(stop);
+    }
+  }
+  return i + scalar_whitespace_run(p + i, n - i);
+}
+
+PGT_SSE2 size_t sse2_identifier_run(const char *p, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    unsigned stop = ~_mm_movemask_epi8(identifier_mask_128(v)) & 0xFFFFu;
+    if (stop) {
+      return i + __builtin_ctz(stop);
+    }
+  }
+  return i + scalar_identifier_run(p + i, n - i);
+}
+
+PGT_SSE2 size_t sse2_find_either(const char *p, size_t n, char a, char b) {
+  __m128i va = _mm_set1_epi8(a);
+  __m128i vb = _mm_set1_epi8(b);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    unsigned hit = _mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+    if (hit) {
+      return i + __builtin_ctz(hit);
+    }
+  }
+  return i + scalar_find_either(p + i, n - i, a, b);
+}
+
+PGT_SSE2 LineSpan sse2_count_lines(const char *p, size_t n, bool count_cr) {
+  __m128i lf = _mm_set1_epi8('\n');
+  __m128i cr = _mm_set1_epi8(count_cr ? '\r' : '\n');
+  LineSpan span;
+  size_t last = n;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    unsigned bits = _mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+    if (bits) {
+      span.lines += __builtin_popcount(bits);
+      last = i + 31 - __builtin_clz(bits);
+    }
+  }
+  LineSpan rest = scalar_count_lines(p + i, n - i, count_cr);
+  span.lines += rest.lines;
+  if (rest.lines) {
+    span.tail = rest.tail;
+  } else {
+    span.tail = last == n ? n : n - last - 1;
+  }
+  return span;
+}
+
+PGT_AVX2 __m256i at_most_256(__m256i v, char limit) {
+  return _mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(limit)), v);
+}
+
+PGT_AVX2 size_t avx2_whitespace_run(const char *p, size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    __m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+    __m256i control =
+        at_most_256(_mm256_sub_epi8(v, _mm256_set1_epi8('\t')), 4);
+    unsigned stop = ~static_cast<unsigned>(
+        _mm256_movemask_epi8(_mm256_or_si256(space, control)));
+    if (stop) {
+      return i + __builtin_ctz(stop);
+    }
+  }
+  return i + sse2_whitespace_run(p + i, n - i);
+}
+
+PGT_AVX2 size_t avx2_identifier_run(const char *p, size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    __m256i alpha =
+        at_most_256(_mm256_sub_epi8(lower, _mm256_set1_epi8('a')), 25);
+    __m256i digit = at_most_256(_mm256_sub_epi8(v, _mm256_set1_epi8('0')), 9);
+    __m256i punct =
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('.')));
+    __m256i ident = _mm256_or_si256(_mm256_or_si256(alpha, digit), punct);
+    unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(ident));
+    if (stop) {
+      return i + __builtin_ctz(stop);
+    }
+  }
+  return i + sse2_identifier_run(p + i, n - i);
+}
+
+PGT_AVX2 size_t avx2_find_either(const char *p, size_t n, char a, char b) {
+  __m256i va = _mm256_set1_epi8(a);
+  __m256i vb = _mm256_set1_epi8(b);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    unsigned hit = static_cast<unsigned>(_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb))));
+    if (hit) {
+      return i + __builtin_ctz(hit);
+    }
+  }
+  return i + sse2_find_either(p + i, n - i, a, b);
+}
+
+PGT_AVX2 LineSpan avx2_count_lines(const char *p, size_t n, bool count_cr) {
+  __m256i lf = _mm256_set1_epi8('\n');
+  __m256i cr = _mm256_set1_epi8(count_cr ? '\r' : '\n');
+  LineSpan span;
+  size_t last = n;
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    unsigned bits = static_cast<unsigned>(_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, lf), _mm256_cmpeq_epi8(v, cr))));
+    if (bits) {
+      span.lines += __builtin_popcount(bits);
+      last = i + 31 - __builtin_clz(bits);
+    }
+  }
+  LineSpan rest = sse2_count_lines(p + i, n - i, count_cr);
+  span.lines += rest.lines;
+  if (rest.lines) {
+    span.tail = rest.tail;
+  } else {
+    span.tail = last == n ? n : n - last - 1;
+  }
+  return span;
+}
+#endif
+
+const Scanner scalar_scanner = {"scalar", scalar_whitespace_run,
+                                scalar_identifier_run, scalar_find_either,
+                                scalar_count_lines};
+
+#ifdef PGT_SCAN_X86
+const Scanner sse2_scanner = {"sse2", sse2_whitespace_run,
+                              sse2_identifier_run, sse2_find_either,
+                              sse2_count_lines};
+
+const Scanner avx2_scanner = {"avx2", avx2_whitespace_run,
+                              avx2_identifier_run, avx2_find_either,
+                              avx2_count_lines};
+#endif
+
+const Scanner &select_scanner() {
+#ifdef PGT_SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return avx2_scanner;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return sse2_scanner;
+  }
+#endif
+  return scalar_scanner;
+}
+} // namespace
+
+const Scanner &scanner() {
+  static const Scanner &selected = select_scanner();
+  return selected;
+}
@@ -0,0 +1,61 @@
+#include "../include/lexer/SourceFile.h"
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SourceFile::~SourceFile() { release(); }
+
+void SourceFile::release() {
+  if (mapped) {
+    munmap(mapped, mapped_size);
+    mapped = nullptr;
+    mapped_size = 0;
+  }
+  owned.clear();
+  decoded.clear();
+  view = std::string_view();
+}
+
+bool SourceFile::open(const std::string &path) {
+  release();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                      MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED) {
+      close(fd);
+      mapped = data;
+      mapped_size = static_cast<size_t>(st.st_size);
+      view = std::string_view(static_cast<const char *>(data), mapped_size);
+      return true;
+    }
+  }
+  close(fd);
+
+  // Empty files, pipes and filesystems without mmap support are read whole.
+  std::ifstream f(path, std::ios::binary);
+  if (!f) {
+    return false;
+  }
+  owned.assign(std::istreambuf_iterator<char>(f), {});
+  view = owned;
+  return true;
+}
+
+void SourceFile::replace(std::string text) {
+  release();
+  owned = std::move(text);
+  view = owned;
+}
+
+std::string_view SourceFile::keep(std::string text) {
+  decoded.push_back(std::move(text));
+  return decoded.back();
+}
@@ -0,0 +1,26 @@
+#include "../include/lexer/TokenStream.h"
+
+void TokenStream::fill(size_t count) {
+  while (buffered < count) {
+    Token token = lexer.next_token();
+    if (token.type == T_LINE_COMMENT || token.type == T_BLOCK_COMMENT) {
+      continue;
+    }
+    ring[(head + buffered) % capacity] = token;
+    ++buffered;
+  }
+}
+
+const Token &TokenStream::peek(size_t offset) {
+  fill(offset + 1);
+  return ring[(head + offset) % capacity];
+}
+
+void TokenStream::advance() {
+  if (peek().type == T_EOF) {
+    return;
+  }
+  head = (head + 1) % capacity;
+  --buffered;
+  ++consumed;
+}
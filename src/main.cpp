@@ -1,5 +1,6 @@
 #include "include/lexer/Lexer.h"
 #include "include/parser/Parser.h"
+#include "include/parser/AstCache.h"
 #include "include/semantic/SyntaxHealer.h"
 #include "include/interpreter/Interpreter.h"
 #include "include/utils/Utils.h"
@@ -7,16 +8,23 @@
 #include "include/semantic/SemanticAnalyzer.h"
 #include "include/utils/Error.h"
 #include "include/package/PackageResolver.h"
+#include "include/package/ImportGraph.h"
 #include "include/gen/Generator.h"
 #include "include/init/ProjectInit.h"
+#include "include/optimizer/PassManager.h"
+#include "include/utils/ThreadPool.h"
+#include "include/utils/Timings.h"
+#include "include/utils/Version.h"
 
 #include <iostream>
 #include <fstream>
 #include <set>
 #include <map>
+#include <mutex>
 #include <cctype>
 #include <cstdlib>
 #include <filesystem>
+#include <functional>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -242,12 +250,11 @@ namespace
         return 1;
     }
 
-    bool tokenize_source(const std::string &source, std::vector<Token> &tokens)
+    void tokenize_source(SourceFile &source, std::vector<Token> &tokens)
     {
         tokens.clear();
         Lexer lexer(source);
         Token t;
-        size_t token_count = 0;
         do
         {
             t = lexer.next_token();
@@ -256,16 +263,153 @@ namespace
                 continue;
             }
             tokens.push_back(t);
-            token_count++;
-            if (token_count > 10000)
+        } while (t.type != T_EOF);
+    }
+
+    // One file of the program, loaded on a pool thread. Its messages are held
+    // back until the loader reaches it, so output does not depend on which
+    // thread got there first.
+    struct LoadedFile
+    {
+        AstArena arena;
+        ParsedFile parsed;
+        bool ok = false;
+        std::ostringstream out;
+        std::ostringstream err;
+        // Set when the healer rewrote the file. It is written back only once
+        // the loader reaches the file and has printed what was changed, so a
+        // run that stops at an earlier file leaves it untouched.
+        bool repaired = false;
+        std::string repaired_source;
+        std::vector<PhaseTiming> timings;
+    };
+
+    // Heals and parses one file. settled is set when the healer has nothing
+    // left to change in the file as it will be on disk.
+    bool parse_source(const std::string &path, SourceFile &source, LoadedFile &file, bool &settled)
+    {
+        // Most files need no repair, and checking that on the lexer's stream
+        // keeps their tokens from ever being held all at once.
+        PhaseClock check_clock;
+        size_t token_count = 0;
+        bool needs_repair = SyntaxHealer::needs_repair(source, token_count);
+        file.timings.push_back(check_clock.stop(path, "lex"));
+        file.timings.back().tokens = token_count;
+        if (DEBUG)
+            file.out << "[DEBUG] Tokenized " << token_count << " tokens" << std::endl;
+
+        settled = true;
+        if (needs_repair)
+        {
+            PhaseClock heal_clock;
+            std::vector<Token> tokens;
+            tokenize_source(source, tokens);
+            SyntaxHealer::RepairResult repair = SyntaxHealer::repair_source(source.text(), tokens);
+            std::vector<Token>().swap(tokens);
+            settled = repair.settled;
+            if (repair.changed)
             {
-                std::cerr << "Error: Too many tokens, possible infinite loop in lexer" << std::endl;
-                return false;
+                for (const auto &diagnostic : repair.diagnostics)
+                {
+                    file.err << "Syntax repair: " << path << ":"
+                             << diagnostic.line << ":" << diagnostic.column
+                             << ": " << diagnostic.message << "\n";
+                }
+
+                file.repaired = true;
+                file.repaired_source = repair.source;
+                source.replace(std::move(repair.source));
             }
-        } while (t.type != T_EOF);
+            file.timings.push_back(heal_clock.stop(path, "heal"));
+        }
 
+        PhaseClock parse_clock;
+        Lexer lexer(source);
+        Parser parser(file.arena, lexer);
+        if (DEBUG)
+            file.out << "[DEBUG] Starting parse_program..." << std::endl;
+        try
+        {
+            file.parsed.program = parser.parse_program();
+        }
+        catch (const CompilerError &e)
+        {
+            file.err << e.get_traceback();
+            return false;
+        }
+
+        file.parsed.has_package_decl = parser.found_package_decl();
+        file.parsed.package_name = parser.parsed_package_name();
+        file.parsed.has_return_zero = parser.found_return_zero();
+        file.timings.push_back(parse_clock.stop(path, "parse"));
+        file.timings.back().nodes = file.arena.size();
         return true;
     }
+
+    void load_source(const std::string &path, const AstCache &ast_cache, LoadedFile &file)
+    {
+        PhaseClock read_clock;
+        SourceFile source;
+        if (!source.open(path))
+        {
+            file.err << "Error: Cannot open file '" << path << "'\n";
+            return;
+        }
+        file.timings.push_back(read_clock.stop(path, "read"));
+
+        if (DEBUG)
+            file.out << "[DEBUG] Loading file: " << path << std::endl;
+        if (DEBUG)
+            file.out << "[DEBUG] File size: " << source.text().size() << " bytes" << std::endl;
+
+        PhaseClock cache_clock;
+        std::string cache_key = AstCache::key(source.text());
+        bool cached = ast_cache.load(cache_key, file.arena, file.parsed);
+        file.timings.push_back(cache_clock.stop(path, "cache"));
+        file.timings.back().nodes = file.arena.size();
+        if (cached)
+        {
+            if (DEBUG)
+                file.out << "[DEBUG] Loaded cached AST " << cache_key << std::endl;
+        }
+        else
+        {
+            bool settled = false;
+            if (!parse_source(path, source, file, settled))
+            {
+                return;
+            }
+            // Only a source the healer accepts as-is is worth caching: that
+            // is what the next run will read back from disk.
+            if (settled)
+            {
+                PhaseClock store_clock;
+                ast_cache.store(file.repaired ? AstCache::key(source.text()) : cache_key, file.parsed);
+                file.timings.push_back(store_clock.stop(path, "store"));
+            }
+        }
+        if (DEBUG)
+            file.out << "[DEBUG] Parsed " << file.parsed.program.size() << " nodes" << std::endl;
+        file.ok = true;
+    }
+
+    bool parse_option_count(const std::string &text, uint64_t &value)
+    {
+        if (text.empty() || text.size() > 18)
+        {
+            return false;
+        }
+        value = 0;
+        for (char ch : text)
+        {
+            if (!std::isdigit(static_cast<unsigned char>(ch)))
+            {
+                return false;
+            }
+            value = value * 10 + (ch - '0');
+        }
+        return value > 0;
+    }
 }
 
 int main(int argc, char **argv)
@@ -278,6 +422,9 @@ int main(int argc, char **argv)
         std::cout << "  pgt version             — Show version\n";
         std::cout << "  pgt run <file.pgt>      — Run PGT program\n";
         std::cout << "  pgt run <file.pgt> --debug — Run with debug output\n";
+        std::cout << "  pgt run <file.pgt> --opt-level <0-2> — Run with the given optimization level\n";
+        std::cout << "  pgt run <file.pgt> --timings — Print how long each startup phase took\n";
+        std::cout << "  pgt run <file.pgt> --prefork — Run web::run workers as supervised processes\n";
         std::cout << "  pgt init [template] [name] — Initialize a project from template\n";
         std::cout << "  pgt mod init <module>    — Create pgt.mod\n";
         std::cout << "  pgt mod download         — Download pgt.mod libraries\n";
@@ -298,7 +445,13 @@ int main(int argc, char **argv)
         std::cout << "  help                    — Show this help message\n";
         std::cout << "  version                 — Show compiler version\n";
         std::cout << "  run <file.pgt>          — Execute .pgt file\n";
-        std::cout << "  run <file.pgt> --debug  — Execute with debug info\n\n";
+        std::cout << "  run <file.pgt> --debug  — Execute with debug info\n";
+        std::cout << "  run <file.pgt> --opt-level <0-2> — Set AST optimization level (default 2)\n";
+        std::cout << "  run <file.pgt> --timings — Print per-file, per-phase startup timings\n";
+        std::cout << "  run <file.pgt> --timings-json <file> — Write the startup timings as JSON\n";
+        std::cout << "  run <file.pgt> --prefork — Fork web::run workers under a supervisor that restarts them\n";
+        std::cout << "  run <file.pgt> --max-requests <n> — Restart a preforked worker after n requests\n";
+        std::cout << "  run <file.pgt> --max-memory <MiB> — Restart a preforked worker once it uses this much memory\n\n";
         std::cout << "  init [template] [name]  — Initialize a project from template\n";
         std::cout << "  init backend test       — Create backend project named test\n\n";
         std::cout << "  mod init <module>       — Create pgt.mod\n";
@@ -322,7 +475,7 @@ int main(int argc, char **argv)
 
     if (command == "version" || command == "--version" || command == "-v")
     {
-        std::cout << "PGT Compiler v1.1\n";
+        std::cout << "PGT Compiler v" << pgt_version << "\n";
         std::cout << "Built on Aprel 21 2026\n";
         std::cout << "Author: pabla\n";
         return 0;
@@ -348,30 +501,185 @@ int main(int argc, char **argv)
         if (argc < 3)
         {
             std::cerr << "Error: No input file specified.\n";
-            std::cerr << "Usage: pgt run <file.pgt> [--debug]\n";
+            std::cerr << "Usage: pgt run <file.pgt> [--debug] [--opt-level <0-2>] [--timings] [--timings-json <file>] [--prefork [--max-requests <n>] [--max-memory <MiB>]]\n";
             return 1;
         }
 
         std::string filename = argv[2];
+        int opt_level = PassManager::max_opt_level;
+        bool print_phase_timings = false;
+        std::string timings_json_path;
+        HttpServerOptions server_options;
 
-        if (argc == 4 && std::string(argv[3]) == "--debug")
+        for (int i = 3; i < argc; ++i)
         {
-            DEBUG = true;
+            std::string arg = argv[i];
+            if (arg == "--debug")
+            {
+                DEBUG = true;
+            }
+            else if (arg == "--timings")
+            {
+                print_phase_timings = true;
+            }
+            else if (arg == "--timings-json" || arg.rfind("--timings-json=", 0) == 0)
+            {
+                if (arg == "--timings-json")
+                {
+                    if (i + 1 >= argc)
+                    {
+                        std::cerr << "Error: --timings-json expects a file.\n";
+                        return 1;
+                    }
+                    timings_json_path = argv[++i];
+                }
+                else
+                {
+                    timings_json_path = arg.substr(std::string("--timings-json=").size());
+                }
+            }
+            else if (arg == "--prefork")
+            {
+                server_options.prefork = true;
+            }
+            else if (arg == "--max-requests" || arg.rfind("--max-requests=", 0) == 0 ||
+                     arg == "--max-memory" || arg.rfind("--max-memory=", 0) == 0)
+            {
+                size_t equals = arg.find('=');
+                std::string option = arg.substr(0, equals);
+                std::string value;
+                if (equals == std::string::npos)
+                {
+                    if (i + 1 >= argc)
+                    {
+                        std::cerr << "Error: " << option << " expects a value.\n";
+                        return 1;
+                    }
+                    value = argv[++i];
+                }
+                else
+                {
+                    value = arg.substr(equals + 1);
+                }
+                uint64_t count = 0;
+                if (!parse_option_count(value, count))
+                {
+                    std::cerr << "Error: " << option << " must be a positive number.\n";
+                    return 1;
+                }
+                if (option == "--max-requests")
+                {
+                    server_options.max_requests = count;
+                }
+                else
+                {
+                    server_options.max_memory_mb = count;
+                }
+            }
+            else if (arg == "--opt-level" || arg.rfind("--opt-level=", 0) == 0)
+            {
+                std::string level;
+                if (arg == "--opt-level")
+                {
+                    if (i + 1 >= argc)
+                    {
+                        std::cerr << "Error: --opt-level expects a value.\n";
+                        return 1;
+                    }
+                    level = argv[++i];
+                }
+                else
+                {
+                    level = arg.substr(std::string("--opt-level=").size());
+                }
+                if (level.size() != 1 || level[0] < '0' || level[0] > '0' + PassManager::max_opt_level)
+                {
+                    std::cerr << "Error: --opt-level must be between 0 and " << PassManager::max_opt_level << ".\n";
+                    return 1;
+                }
+                opt_level = level[0] - '0';
+            }
+            else
+            {
+                std::cerr << "Unknown argument: " << arg << "\n";
+                std::cerr << "Use 'pgt help' for usage.\n";
+                return 1;
+            }
         }
-        else if (argc > 3)
+
+        // Only a supervisor can replace a worker that retires, so the budgets
+        // make no sense for threads.
+        if ((server_options.max_requests || server_options.max_memory_mb) && !server_options.prefork)
         {
-            std::cerr << "Unknown argument: " << argv[3] << "\n";
-            std::cerr << "Use 'pgt help' for usage.\n";
+            std::cerr << "Error: --max-requests and --max-memory need --prefork.\n";
             return 1;
         }
 
+        // Everything up to the call into main counts as startup. Files are
+        // timed on the pool and their phases reported in load order.
+        PhaseClock startup_clock;
+        std::vector<PhaseTiming> timings;
+
+        AstArena arena;
         std::set<std::string> loaded_files;
-        std::map<std::string, std::vector<std::shared_ptr<AstNode>>> file_asts;
-        std::map<std::string, std::string> file_packages;
+        ImportGraph import_graph;
         std::map<std::string, std::string> directory_packages;
         std::map<std::string, std::string> directory_package_sources;
         std::vector<std::string> files_to_load = {filename};
         PackageResolver package_resolver(filename, argv[0]);
+        // Parsed files are cached under the project's .pgt directory unless
+        // PGT_CACHE_DIR points elsewhere; an empty PGT_CACHE_DIR turns it off.
+        const char *cache_dir = std::getenv("PGT_CACHE_DIR");
+        std::filesystem::path default_cache_dir = std::filesystem::path(PackageResolver::directory_of(filename)) / ".pgt" / "cache";
+        AstCache ast_cache(cache_dir ? cache_dir : default_cache_dir.string());
+
+        // Files are opened, healed and parsed on a pool as their imports turn
+        // up. The loop below then checks them in the order a sequential load
+        // would, so diagnostics and combined_program do not depend on timing.
+        // std::map never moves its elements, so workers can hold on to theirs.
+        std::map<std::string, LoadedFile> sources;
+        PhaseClock load_clock;
+        {
+            std::mutex sources_lock;
+            ThreadPool pool;
+            std::function<void(const std::string &)> schedule = [&](const std::string &path)
+            {
+                LoadedFile *file;
+                {
+                    std::lock_guard<std::mutex> guard(sources_lock);
+                    auto [entry, inserted] = sources.try_emplace(path);
+                    if (!inserted)
+                    {
+                        return;
+                    }
+                    file = &entry->second;
+                }
+                pool.submit([&, path, file]()
+                {
+                    load_source(path, ast_cache, *file);
+                    if (!file->ok)
+                    {
+                        return;
+                    }
+                    std::string base_dir = PackageResolver::directory_of(path);
+                    for (const auto &node : file->parsed.program)
+                    {
+                        if (auto import = node_cast<ImportStmt>(node))
+                        {
+                            ResolvedImport resolved_import = package_resolver.resolve_import_path(base_dir, import->file_path);
+                            for (const auto &import_file : resolved_import.files)
+                            {
+                                schedule(import_file);
+                            }
+                        }
+                    }
+                });
+            };
+            schedule(filename);
+            pool.wait();
+        }
+        timings.push_back(load_clock.stop("", "load"));
+        PhaseClock validate_clock;
 
         while (!files_to_load.empty())
         {
@@ -382,79 +690,30 @@ int main(int argc, char **argv)
                 continue;
             }
 
-            std::ifstream f(current_file);
-            if (!f)
+            LoadedFile &loaded = sources.at(current_file);
+            std::cout << loaded.out.str();
+            std::cerr << loaded.err.str();
+            timings.insert(timings.end(), loaded.timings.begin(), loaded.timings.end());
+            if (loaded.repaired)
             {
-                std::cerr << "Error: Cannot open file '" << current_file << "'\n";
-                return 1;
-            }
-
-            std::string source((std::istreambuf_iterator<char>(f)), {});
-            f.close();
-
-            if (DEBUG)
-                std::cout << "[DEBUG] Loading file: " << current_file << std::endl;
-            if (DEBUG)
-                std::cout << "[DEBUG] File size: " << source.size() << " bytes" << std::endl;
-
-            std::vector<Token> tokens;
-            if (!tokenize_source(source, tokens))
-            {
-                return 1;
-            }
-
-            for (int repair_pass = 0; repair_pass < 5; ++repair_pass)
-            {
-                SyntaxHealer::RepairResult repair = SyntaxHealer::repair_source(source, tokens);
-                if (!repair.changed)
-                {
-                    break;
-                }
-
-                for (const auto &diagnostic : repair.diagnostics)
-                {
-                    std::cerr << "Syntax repair: " << current_file << ":"
-                              << diagnostic.line << ":" << diagnostic.column
-                              << ": " << diagnostic.message << "\n";
-                }
-
                 std::ofstream repaired_file(current_file);
                 if (!repaired_file)
                 {
                     std::cerr << "Error: Cannot write repaired file '" << current_file << "'\n";
                     return 1;
                 }
-                repaired_file << repair.source;
+                repaired_file << loaded.repaired_source;
                 repaired_file.close();
-
-                source = repair.source;
-                if (!tokenize_source(source, tokens))
-                {
-                    return 1;
-                }
+                std::string().swap(loaded.repaired_source);
             }
-
-            if (DEBUG)
-                std::cout << "[DEBUG] Tokenized " << tokens.size() << " tokens" << std::endl;
-
-            Parser parser;
-            parser.load_tokens(tokens);
-            if (DEBUG)
-                std::cout << "[DEBUG] Starting parse_program..." << std::endl;
-            std::vector<std::shared_ptr<AstNode>> program;
-            try
-            {
-                program = parser.parse_program();
-            }
-            catch (const CompilerError &e)
+            if (!loaded.ok)
             {
-                std::cerr << e.get_traceback();
                 return 1;
             }
-            if (DEBUG)
-                std::cout << "[DEBUG] Parsed " << program.size() << " nodes" << std::endl;
+            ParsedFile &parsed = loaded.parsed;
+            std::vector<AstNode *> &program = parsed.program;
 
-            if (!parser.found_package_decl())
+            if (!parsed.has_package_decl)
             {
                 SemanticError err("Missing package declaration: expected 'package <name>' at the top of the file.",
                                   SourceLocation(1, 0, current_file));
@@ -462,7 +721,7 @@ int main(int argc, char **argv)
                 return 1;
             }
 
-            std::string parsed_package_name = parser.parsed_package_name();
+            const std::string &parsed_package_name = parsed.package_name;
             try
             {
                 package_resolver.validate_package_directory(current_file, parsed_package_name);
@@ -485,11 +744,10 @@ int main(int argc, char **argv)
             }
             directory_packages[current_dir] = parsed_package_name;
             directory_package_sources[current_dir] = current_file;
-            file_packages[current_file] = parsed_package_name;
 
             if (current_file == filename)
             {
-                if (!parser.found_package_main())
+                if (parsed_package_name != "main")
                 {
                     SemanticError err("Main file must declare 'package main'.",
                                       SourceLocation(1, 0, current_file));
@@ -505,19 +763,19 @@ int main(int argc, char **argv)
                     std::cerr << e.get_traceback();
                     return 1;
                 }
-                if (!parser.found_return_zero())
+                if (!parsed.has_return_zero)
                 {
                     std::cerr << "Error: Missing 'return 0' at the end of main file\n";
                     return 1;
                 }
             }
 
-            file_asts[current_file] = program;
+            ImportNode &graph_node = import_graph.add_file(current_file, parsed_package_name, program);
 
             std::string base_dir = PackageResolver::directory_of(current_file);
             for (const auto &node : program)
             {
-                if (auto import = std::dynamic_pointer_cast<ImportStmt>(node))
+                if (auto import = node_cast<ImportStmt>(node))
                 {
                     ResolvedImport resolved_import = package_resolver.resolve_import_path(base_dir, import->file_path);
                     if (!resolved_import.found)
@@ -544,94 +802,72 @@ int main(int argc, char **argv)
                     {
                         files_to_load.push_back(import_file);
                     }
+                    graph_node.imports.push_back({import, resolved_import});
                 }
             }
 
             loaded_files.insert(current_file);
         }
 
-        std::map<std::string, std::set<std::string>> file_symbols;
-        for (const auto &[file, ast] : file_asts)
+        for (const auto &[file, node] : import_graph.files())
         {
-            for (const auto &node : ast)
+            for (const auto &edge : node.imports)
             {
-                if (auto func = std::dynamic_pointer_cast<FunctionDef>(node))
+                const ImportStmt *import = edge.import;
+                const ResolvedImport &resolved_import = edge.resolved;
+                if (!resolved_import.found || resolved_import.files.empty())
                 {
-                    file_symbols[file].insert(func->name);
+                    std::cerr << "Error: Cannot find imported file: " << resolved_import.path << "\n";
+                    return 1;
                 }
-                else if (auto klass = std::dynamic_pointer_cast<ClassDef>(node))
+                std::set<std::string> available_symbols;
+                for (const auto &import_file : resolved_import.files)
                 {
-                    file_symbols[file].insert(klass->name);
-                }
-            }
-        }
+                    if (!import_graph.contains(import_file))
+                    {
+                        std::cerr << "Error: Cannot find imported file: " << import_file << "\n";
+                        return 1;
+                    }
 
-        for (const auto &[file, ast] : file_asts)
-        {
-            for (const auto &node : ast)
-            {
-                if (auto import = std::dynamic_pointer_cast<ImportStmt>(node))
-                {
-                    ResolvedImport resolved_import = package_resolver.resolve_import_path(PackageResolver::directory_of(file),
-                                                                                          import->file_path);
-                    if (!resolved_import.found || resolved_import.files.empty())
+                    const ImportNode &imported = import_graph.at(import_file);
+                    if (imported.package_name == "main")
                     {
-                        std::cerr << "Error: Cannot find imported file: " << resolved_import.path << "\n";
+                        SemanticError err("Package 'main' cannot be imported. Move shared code into a separate package.",
+                                          SourceLocation(import->location.line, import->location.column, file));
+                        std::cerr << err.get_traceback();
                         return 1;
                     }
-                    const std::string &current_package = file_packages[file];
-                    std::set<std::string> available_symbols;
-                    for (const auto &import_file : resolved_import.files)
+                    if (PackageResolver::directory_of(file) == PackageResolver::directory_of(import_file) &&
+                        node.package_name != imported.package_name)
                     {
-                        if (!file_asts.count(import_file))
-                        {
-                            std::cerr << "Error: Cannot find imported file: " << import_file << "\n";
-                            return 1;
-                        }
-
-                        const std::string &imported_package = file_packages[import_file];
-                        if (imported_package == "main")
-                        {
-                            SemanticError err("Package 'main' cannot be imported. Move shared code into a separate package.",
-                                              SourceLocation(import->location.line, import->location.column, file));
-                            std::cerr << err.get_traceback();
-                            return 1;
-                        }
-                        if (PackageResolver::directory_of(file) == PackageResolver::directory_of(import_file) &&
-                            current_package != imported_package)
-                        {
-                            SemanticError err("Directory cannot contain mixed packages: '" + current_package +
-                                                  "' and '" + imported_package +
-                                                  "'. Move package '" + imported_package + "' into its own directory.",
-                                              SourceLocation(import->location.line, import->location.column, file));
-                            std::cerr << err.get_traceback();
-                            return 1;
-                        }
-                        if (file_symbols.count(import_file))
-                        {
-                            available_symbols.insert(file_symbols[import_file].begin(), file_symbols[import_file].end());
-                        }
+                        SemanticError err("Directory cannot contain mixed packages: '" + node.package_name +
+                                              "' and '" + imported.package_name +
+                                              "'. Move package '" + imported.package_name + "' into its own directory.",
+                                          SourceLocation(import->location.line, import->location.column, file));
+                        std::cerr << err.get_traceback();
+                        return 1;
                     }
-                    for (const auto &symbol_name : import->import_names)
+                    available_symbols.insert(imported.symbols.begin(), imported.symbols.end());
+                }
+                for (const auto &symbol_name : import->import_names)
+                {
+                    if (!available_symbols.count(symbol_name))
                     {
-                        if (!available_symbols.count(symbol_name))
-                        {
-                            SemanticError err("Symbol '" + symbol_name + "' not found in import '" + import->file_path + "'",
-                                              SourceLocation(import->location.line, import->location.column, file));
-                            std::cerr << err.get_traceback();
-                            return 1;
-                        }
+                        SemanticError err("Symbol '" + symbol_name + "' not found in import '" + import->file_path + "'",
+                                          SourceLocation(import->location.line, import->location.column, file));
+                        std::cerr << err.get_traceback();
+                        return 1;
                     }
                 }
             }
         }
 
-        std::vector<std::shared_ptr<AstNode>> combined_program;
-        for (const auto &[file, ast] : file_asts)
+        std::vector<AstNode *> combined_program;
+        for (const auto &[file, graph_node] : import_graph.files())
         {
-            for (const auto &node : ast)
+            for (const auto &node : graph_node.program)
             {
-                if (!std::dynamic_pointer_cast<ImportStmt>(node))
+                if (node->kind != NodeKind::IMPORT)
                 {
                     combined_program.push_back(node);
                 }
@@ -640,7 +876,7 @@ int main(int argc, char **argv)
 
         for (const auto &node : combined_program)
         {
-            if (auto func = std::dynamic_pointer_cast<FunctionDef>(node))
+            if (auto func = node_cast<FunctionDef>(node))
             {
                 if (!func->has_return_one)
                 {
@@ -651,10 +887,26 @@ int main(int argc, char **argv)
             }
         }
 
+        timings.push_back(validate_clock.stop("", "validate"));
+        timings.back().nodes = combined_program.size();
+
         try
         {
+            if (opt_level >= 1)
+            {
+                PhaseClock shake_clock;
+                TreeShakingPass().run(combined_program);
+                timings.push_back(shake_clock.stop("", "tree-shake"));
+                timings.back().nodes = combined_program.size();
+            }
+            PhaseClock analyze_clock;
             SemanticAnalyzer analyzer;
             analyzer.analyze(combined_program);
+            timings.push_back(analyze_clock.stop("", "analyze"));
+            PhaseClock optimize_clock;
+            PassManager passes(arena, opt_level);
+            passes.run(combined_program);
+            timings.push_back(optimize_clock.stop("", "optimize"));
         }
         catch (const CompilerError &e)
         {
@@ -664,8 +916,28 @@ int main(int argc, char **argv)
 
         try
         {
+            PhaseClock register_clock;
             Interpreter interp;
-            interp.run(combined_program);
+            interp.load(combined_program);
+            timings.push_back(register_clock.stop("", "register"));
+            timings.push_back(startup_clock.stop("", "startup"));
+
+            if (print_phase_timings)
+            {
+                print_timings(std::cerr, timings);
+            }
+            if (!timings_json_path.empty())
+            {
+                std::ofstream timings_file(timings_json_path);
+                if (!timings_file)
+                {
+                    std::cerr << "Error: Cannot write timings to '" << timings_json_path << "'\n";
+                    return 1;
+                }
+                print_timings_json(timings_file, timings);
+            }
+            interp.set_server_options(server_options);
+            interp.run_main();
         }
         catch (const CompilerError &e)
         {
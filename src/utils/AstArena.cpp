@@ -0,0 +1,26 @@
+#include "../include/token/AstArena.h"
+#include "../include/token/Ast.h"
+#include <cstdint>
+
+AstArena::~AstArena() {
+  for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+    (*it)->~AstNode();
+  }
+}
+
+void *AstArena::allocate(size_t size, size_t align) {
+  size_t padding = reinterpret_cast<uintptr_t>(cursor) % align;
+  padding = padding ? align - padding : 0;
+  if (!cursor || padding + size > remaining) {
+    size_t capacity = size > block_size ? size : block_size;
+    blocks.emplace_back(new unsigned char[capacity]);
+    cursor = blocks.back().get();
+    remaining = capacity;
+    padding = 0;
+  }
+  cursor += padding;
+  void *result = cursor;
+  cursor += size;
+  remaining -= padding + size;
+  return result;
+}
@@ -0,0 +1,113 @@
+#include "../include/utils/Builtins.h"
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+const BuiltinInfo builtin_table[] = {
+    {"protocol", BuiltinId::PROTOCOL, 1, 1, "1 argument", false},
+    {"read::file", BuiltinId::READ_FILE, 1, 1, "1 argument", false},
+    {"read_file", BuiltinId::READ_FILE, 1, 1, "1 argument", false},
+    {"open_log", BuiltinId::OPEN_LOG, 1, 1, "1 argument", true},
+
+    {"request::method", BuiltinId::REQUEST_METHOD, 0, 0, "0 arguments", false},
+    {"request::path", BuiltinId::REQUEST_PATH, 0, 0, "0 arguments", false},
+    {"request::body", BuiltinId::REQUEST_BODY, 0, 0, "0 arguments", false},
+    {"request::json", BuiltinId::REQUEST_JSON, 0, 0, "0 arguments", false},
+    {"request::query", BuiltinId::REQUEST_QUERY, 0, 1, "0 or 1 arguments",
+     false},
+    {"request::header", BuiltinId::REQUEST_HEADER, 1, 1, "1 argument", false},
+    {"request::param", BuiltinId::REQUEST_PARAM, 1, 1, "1 argument", false},
+    {"request_method", BuiltinId::REQUEST_METHOD, 0, 0, "0 arguments", false},
+    {"request_path", BuiltinId::REQUEST_PATH, 0, 0, "0 arguments", false},
+    {"request_body", BuiltinId::REQUEST_BODY, 0, 0, "0 arguments", false},
+    {"request_json", BuiltinId::REQUEST_JSON, 0, 0, "0 arguments", false},
+    {"request_query", BuiltinId::REQUEST_QUERY, 0, 1, "0 or 1 arguments",
+     false},
+    {"request_header", BuiltinId::REQUEST_HEADER, 1, 1, "1 argument", false},
+    {"request_param", BuiltinId::REQUEST_PARAM, 1, 1, "1 argument", false},
+
+    {"json::parse", BuiltinId::JSON_PARSE, 1, 1, "1 argument", false},
+    {"json::decode", BuiltinId::JSON_PARSE, 1, 1, "1 argument", false},
+    {"json::unmarshal", BuiltinId::JSON_PARSE, 1, 1, "1 argument", false},
+    {"json_parse", BuiltinId::JSON_PARSE, 1, 1, "1 argument", false},
+    {"json::stringify", BuiltinId::JSON_STRINGIFY, 1, 1, "1 argument", false},
+    {"json::encode", BuiltinId::JSON_STRINGIFY, 1, 1, "1 argument", false},
+    {"json::marshal", BuiltinId::JSON_STRINGIFY, 1, 1, "1 argument", false},
+    {"json_stringify", BuiltinId::JSON_STRINGIFY, 1, 1, "1 argument", false},
+    {"json::write", BuiltinId::JSON_WRITE, 2, 2, "path and value", false},
+    {"json::save", BuiltinId::JSON_WRITE, 2, 2, "path and value", false},
+    {"json::read", BuiltinId::JSON_READ, 1, 1, "1 argument", false},
+    {"json::get", BuiltinId::JSON_GET, 2, 2, "object and key", false},
+    {"json::object", BuiltinId::JSON_OBJECT, 0, -1, "key/value pairs", false},
+
+    {"auth::hash_password", BuiltinId::AUTH_HASH_PASSWORD, 1, 1, "1 argument",
+     false},
+    {"auth::verify_password", BuiltinId::AUTH_VERIFY_PASSWORD, 2, 2,
+     "2 arguments", false},
+    {"jwt::sign", BuiltinId::JWT_SIGN, 2, 2, "payload and secret", false},
+    {"jwt::verify", BuiltinId::JWT_VERIFY, 2, 2, "2 arguments", false},
+
+    {"sql::open", BuiltinId::SQL_OPEN, 1, 1, "1 argument", false},
+    {"sql::connect", BuiltinId::SQL_OPEN, 1, 1, "1 argument", false},
+    {"sql::exec", BuiltinId::SQL_EXEC, 1, 1, "1 argument", false},
+    {"sql::table", BuiltinId::SQL_TABLE, 2, 2, "2 arguments", false},
+    {"orm::table", BuiltinId::SQL_TABLE, 2, 2, "2 arguments", false},
+    {"sql::insert", BuiltinId::SQL_INSERT, 2, 2, "2 arguments", false},
+    {"orm::save", BuiltinId::SQL_INSERT, 2, 2, "2 arguments", false},
+    {"sql::find", BuiltinId::SQL_FIND, 3, 3, "3 arguments", false},
+    {"orm::find", BuiltinId::SQL_FIND, 3, 3, "3 arguments", false},
+    {"orm::migrate", BuiltinId::ORM_MIGRATE, 1, 1, "1 argument", false},
+
+    {"log", BuiltinId::LOG, 1, -1, "at least 1 argument", true},
+    {"log::trace", BuiltinId::LOG_TRACE, 1, -1, "at least 1 argument", true},
+    {"log_trace", BuiltinId::LOG_TRACE, 1, -1, "at least 1 argument", true},
+    {"log::debug", BuiltinId::LOG_DEBUG, 1, -1, "at least 1 argument", true},
+    {"log_debug", BuiltinId::LOG_DEBUG, 1, -1, "at least 1 argument", true},
+    {"log::info", BuiltinId::LOG_INFO, 1, -1, "at least 1 argument", true},
+    {"log_info", BuiltinId::LOG_INFO, 1, -1, "at least 1 argument", true},
+    {"log::notice", BuiltinId::LOG_NOTICE, 1, -1, "at least 1 argument", true},
+    {"log_notice", BuiltinId::LOG_NOTICE, 1, -1, "at least 1 argument", true},
+    {"log::warn", BuiltinId::LOG_WARN, 1, -1, "at least 1 argument", true},
+    {"log::warning", BuiltinId::LOG_WARN, 1, -1, "at least 1 argument", true},
+    {"log_warn", BuiltinId::LOG_WARN, 1, -1, "at least 1 argument", true},
+    {"log_warning", BuiltinId::LOG_WARN, 1, -1, "at least 1 argument", true},
+    {"log::error", BuiltinId::LOG_ERROR, 1, -1, "at least 1 argument", true},
+    {"log_error", BuiltinId::LOG_ERROR, 1, -1, "at least 1 argument", true},
+    {"log::critical", BuiltinId::LOG_CRITICAL, 1, -1, "at least 1 argument",
+     true},
+    {"log::critecal", BuiltinId::LOG_CRITICAL, 1, -1, "at least 1 argument",
+     true},
+    {"log::fatal", BuiltinId::LOG_CRITICAL, 1, -1, "at least 1 argument",
+     true},
+    {"log_critical", BuiltinId::LOG_CRITICAL, 1, -1, "at least 1 argument",
+     true},
+    {"log_critecal", BuiltinId::LOG_CRITICAL, 1, -1, "at least 1 argument",
+     true},
+    {"log_fatal", BuiltinId::LOG_CRITICAL, 1, -1, "at least 1 argument", true},
+    {"log::output", BuiltinId::LOG_OUTPUT, 1, 1, "1 argument", true},
+    {"log::set_output", BuiltinId::LOG_OUTPUT, 1, 1, "1 argument", true},
+    {"log_output", BuiltinId::LOG_OUTPUT, 1, 1, "1 argument", true},
+    {"set_log_output", BuiltinId::LOG_OUTPUT, 1, 1, "1 argument", true},
+    {"log::console", BuiltinId::LOG_CONSOLE, 0, 0, "0 arguments", true},
+    {"log_console", BuiltinId::LOG_CONSOLE, 0, 0, "0 arguments", true},
+    {"log::file", BuiltinId::LOG_FILE, 1, 1, "1 argument", true},
+    {"log_file", BuiltinId::LOG_FILE, 1, 1, "1 argument", true},
+};
+} // namespace
+
+const BuiltinInfo *find_builtin(std::string_view name) {
+  static const std::unordered_map<std::string_view, const BuiltinInfo *>
+      by_name = [] {
+        std::unordered_map<std::string_view, const BuiltinInfo *> table;
+        for (const auto &builtin : builtin_table) {
+          table.emplace(builtin.name, &builtin);
+        }
+        return table;
+      }();
+  auto it = by_name.find(name);
+  return it != by_name.end() ? it->second : nullptr;
+}
+
+bool is_log_builtin(BuiltinId id) {
+  return id >= BuiltinId::LOG && id <= BuiltinId::LOG_FILE;
+}
@@ -0,0 +1,112 @@
+#include "../include/utils/ThreadPool.h"
+
+namespace {
+// Set on worker threads so submit() can push onto the caller's own deque.
+thread_local const ThreadPool *current_pool = nullptr;
+thread_local size_t current_queue = 0;
+} // namespace
+
+ThreadPool::ThreadPool(size_t threads) {
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+  }
+  if (threads == 0) {
+    threads = 1;
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    queues.push_back(std::make_unique<Queue>());
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    workers.emplace_back([this, i] { work(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> guard(state_lock);
+    stopping = true;
+  }
+  work_available.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  // Count the task before it becomes visible, so a worker that takes it
+  // right away never drives the counters below zero.
+  size_t index = current_queue;
+  {
+    std::lock_guard<std::mutex> guard(state_lock);
+    if (current_pool != this) {
+      index = next_queue++ % queues.size();
+    }
+    ++queued;
+    ++unfinished;
+  }
+  {
+    std::lock_guard<std::mutex> guard(queues[index]->lock);
+    queues[index]->tasks.push_back(std::move(task));
+  }
+  work_available.notify_one();
+}
+
+bool ThreadPool::take(size_t index, std::function<void()> &task) {
+  {
+    Queue &own = *queues[index];
+    std::lock_guard<std::mutex> guard(own.lock);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+  for (size_t offset = 1; offset < queues.size(); ++offset) {
+    Queue &victim = *queues[(index + offset) % queues.size()];
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::work(size_t index) {
+  current_pool = this;
+  current_queue = index;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> guard(state_lock);
+      work_available.wait(guard, [this] { return stopping || queued > 0; });
+      if (queued == 0) {
+        return;
+      }
+    }
+
+    // queued runs ahead of the deques while a task is being pushed or while
+    // another worker is between take() and the decrement below.
+    std::function<void()> task;
+    if (!take(index, task)) {
+      std::this_thread::yield();
+      continue;
+    }
+    {
+      std::lock_guard<std::mutex> guard(state_lock);
+      --queued;
+    }
+    task();
+    task = nullptr;
+
+    std::lock_guard<std::mutex> guard(state_lock);
+    if (--unfinished == 0) {
+      all_done.notify_all();
+    }
+  }
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> guard(state_lock);
+  all_done.wait(guard, [this] { return unfinished == 0; });
+}
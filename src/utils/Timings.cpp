@@ -0,0 +1,121 @@
+#include "../include/utils/Timings.h"
+#include "../include/utils/Version.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+namespace {
+// Bumped by the replacement operator new below. Per thread, so a phase run on
+// a pool worker only counts its own allocations.
+thread_local uint64_t allocations = 0;
+
+void write_json_string(std::ostream &out, const std::string &value) {
+  out << '"';
+  for (char raw : value) {
+    unsigned char ch = static_cast<unsigned char>(raw);
+    if (raw == '"' || raw == '\\') {
+      out << '\\' << raw;
+    } else if (ch < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+      out << escaped;
+    } else {
+      out << raw;
+    }
+  }
+  out << '"';
+}
+} // namespace
+
+void *operator new(std::size_t size) {
+  ++allocations;
+  if (size == 0) {
+    size = 1;
+  }
+  for (;;) {
+    if (void *memory = std::malloc(size)) {
+      return memory;
+    }
+    std::new_handler handler = std::get_new_handler();
+    if (!handler) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+uint64_t thread_allocation_count() { return allocations; }
+
+PhaseTiming PhaseClock::stop(std::string file, std::string phase) const {
+  PhaseTiming timing;
+  timing.file = std::move(file);
+  timing.phase = std::move(phase);
+  timing.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  timing.allocations = thread_allocation_count() - start_allocations;
+  return timing;
+}
+
+void print_timings(std::ostream &out, const std::vector<PhaseTiming> &phases) {
+  size_t file_width = 4;
+  for (const auto &timing : phases) {
+    file_width = std::max(file_width, timing.file.size());
+  }
+
+  std::ios_base::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+  out << std::left << std::setw(file_width) << "file" << "  " << std::setw(10)
+      << "phase" << std::right << std::setw(12) << "ms" << std::setw(12)
+      << "allocs" << std::setw(10) << "tokens" << std::setw(10) << "nodes"
+      << "\n";
+  for (const auto &timing : phases) {
+    out << std::left << std::setw(file_width) << timing.file << "  "
+        << std::setw(10) << timing.phase << std::right << std::fixed
+        << std::setprecision(3) << std::setw(12)
+        << timing.nanoseconds / 1e6 << std::setw(12) << timing.allocations
+        << std::setw(10);
+    if (timing.tokens) {
+      out << timing.tokens;
+    } else {
+      out << "-";
+    }
+    out << std::setw(10);
+    if (timing.nodes) {
+      out << timing.nodes;
+    } else {
+      out << "-";
+    }
+    out << "\n";
+  }
+  out.flags(flags);
+  out.precision(precision);
+}
+
+void print_timings_json(std::ostream &out,
+                        const std::vector<PhaseTiming> &phases) {
+  out << "{\"version\":";
+  write_json_string(out, pgt_version);
+  out << ",\"phases\":[";
+  for (size_t i = 0; i < phases.size(); ++i) {
+    const PhaseTiming &timing = phases[i];
+    if (i > 0) {
+      out << ",";
+    }
+    out << "{\"file\":";
+    write_json_string(out, timing.file);
+    out << ",\"phase\":";
+    write_json_string(out, timing.phase);
+    out << ",\"ns\":" << timing.nanoseconds
+        << ",\"allocations\":" << timing.allocations
+        << ",\"tokens\":" << timing.tokens << ",\"nodes\":" << timing.nodes
+        << "}";
+  }
+  out << "]}\n";
+}